@@ -0,0 +1,87 @@
+#pragma once
+#ifndef BARNES_HUT_H
+#define BARNES_HUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AlignedAllocator.h"
+#include "ThreadPool.h"
+
+// One octree cell. Nodes are stored in depth-first order, so a cell's
+// children follow it directly and `next` is the index just past its subtree;
+// the force walk needs no stack. Particles are kept sorted along the Morton
+// curve, so every cell owns one contiguous particle range.
+struct OctreeNode {
+    float comX, comY, comZ;     // centre of mass
+    float mass;
+    float size;                 // cell edge length
+    uint32_t next;
+    uint32_t begin, count;      // particle range
+    uint32_t leaf;
+};
+
+// Gravitational N-body system integrated with kick-drift-kick leapfrog.
+// Forces come from a Barnes-Hut octree that is rebuilt every step: particles
+// are Morton-sorted with a parallel radix sort, the upper levels are split
+// into independent subtrees built on the pool, and the force walk is spread
+// over the pool in Morton order so neighbouring particles share cache lines.
+// Units follow the caller; with G = 1 a mass is a gravitational parameter.
+class BarnesHutSimulation {
+public:
+    float theta = 0.5f;                 // opening angle, smaller is more accurate
+    float softening = 0.05f;            // Plummer softening length
+    float gravitationalConstant = 1.0f;
+    uint32_t leafSize = 16;
+
+    AlignedVector<float> posX, posY, posZ;
+    AlignedVector<float> velX, velY, velZ;
+    AlignedVector<float> accX, accY, accZ;
+    AlignedVector<float> mass;
+    AlignedVector<uint32_t> id;         // original index, follows the Morton reordering
+
+    double lastBuildSeconds = 0.0;
+    double lastForceSeconds = 0.0;
+
+    explicit BarnesHutSimulation(ThreadPool& pool);
+
+    uint32_t addParticle(const glm::vec3& position, const glm::vec3& velocity, float particleMass);
+    void reserve(size_t count);
+    void clear();
+    size_t size() const { return mass.size(); }
+
+    // Advances every particle by dt with one tree build and one force pass.
+    void step(float dt);
+
+    // Rebuilds the tree for the current positions and fills acc*.
+    void computeForces();
+    // Brute-force acceleration on one particle, for accuracy checks.
+    glm::vec3 directAcceleration(size_t index) const;
+
+    const std::vector<OctreeNode>& tree() const { return nodes; }
+
+private:
+    void sortByMorton();
+    void buildTree();
+
+    ThreadPool& pool;
+    bool accelerationValid = false;
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    float boundsSize = 1.0f;
+    std::vector<uint64_t> codes, codesScratch;
+    std::vector<uint32_t> order, orderScratch;
+    std::vector<uint32_t> histogram;
+    AlignedVector<float> floatScratch;
+    AlignedVector<uint32_t> idScratch;
+    std::vector<OctreeNode> nodes;
+};
+
+// Adds a thin disk of equal-mass particles on circular orbits around a
+// central mass sitting at `center`, in the x-z plane.
+void addParticleDisk(BarnesHutSimulation& simulation, size_t count, const glm::vec3& center,
+    float centralMass, float diskMass, float innerRadius, float outerRadius, unsigned seed = 1);
+
+#endif
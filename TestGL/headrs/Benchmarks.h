@@ -0,0 +1,66 @@
+#pragma once
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <chrono>
+#include <cstddef>
+
+// Runs the benchmarks named on the command line (`TestGL --bench registry`),
+// or all of them when no name is given.
+int runBenchmarks(int argc, char** argv);
+
+class BenchTimer {
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    void reset() { start = std::chrono::steady_clock::now(); }
+
+    double elapsedSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Allocations made through the global operator new since startup. Counted
+// only when TESTGL_COUNT_ALLOCATIONS is defined (the Debug configurations),
+// 0 otherwise.
+size_t allocationCount();
+
+// A hidden window whose GL 3.3 context is current while the object lives,
+// for the rendering benchmarks. `ok` is false when no context could be made.
+class BenchGLContext {
+public:
+    BenchGLContext();
+    ~BenchGLContext();
+    BenchGLContext(const BenchGLContext&) = delete;
+    BenchGLContext& operator=(const BenchGLContext&) = delete;
+
+    bool ok = false;
+
+private:
+    void* window = nullptr;
+};
+
+void benchBodyRegistry();
+void benchKeplerPropagator();
+void benchBarnesHut();
+void benchSymplectic();
+void benchEphemeris();
+void benchCatalogIngest();
+void benchEclipseSearch();
+void benchEclipseCatalog();
+void benchShadowRaster();
+void benchConjunctionSweep();
+void benchUniformSetters();
+void benchSphereInstancing();
+void benchRenderQueue();
+void benchStreamBuffer();
+void benchCulling();
+void benchFrustumCulling();
+void benchSphereLod();
+void benchSphereMeshes();
+void benchMeshRegistry();
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef BODY_REGISTRY_H
+#define BODY_REGISTRY_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AlignedAllocator.h"
+#include "Ephemeris.h"
+#include "KeplerPropagator.h"
+
+struct BodyDesc {
+    std::string name;
+    int32_t parent = -1;        // index of the body this one orbits, -1 for the origin
+    KeplerElements orbit;       // relative to the parent; zero mean motion fixes the body in its parent's frame
+    double spinRate = 0.0;      // radians per day
+    double spinPhase = 0.0;     // rotation angle at the orbit epoch
+    float radius = 1.0f;
+    uint32_t materialId = 0;
+};
+
+// Structure-of-arrays storage for every simulated body. Hot per-frame data
+// lives in separate contiguous arrays so the update loops stream linearly;
+// names are kept apart as cold data. A body's parent must be added before it,
+// which keeps the arrays topologically ordered for a single update pass.
+// Every state is a pure function of the Julian date, so evaluating any date
+// costs the same as the next frame. Positions come from the Kepler orbits, or
+// from a precomputed ephemeris when one is attached and covers the date.
+//
+// Each body has a parent-relative offset (local*) and a world position (pos*).
+// Offsets that change mark the body dirty, and the world pass only rewrites
+// bodies that are dirty or have a dirty ancestor, starting from the first
+// dirty index. Bodies with no orbital motion are never re-propagated, so
+// frames fixed to a parent or driven from outside (setLocalPosition) cost
+// nothing until they or their parent move.
+class BodyRegistry {
+public:
+    double time = 0.0;
+    KeplerOrbitSet orbits;
+    KeplerPropagator propagator;
+    const Ephemeris* ephemeris = nullptr;
+    AlignedVector<double> spinRate;
+    AlignedVector<double> spinPhase;
+    AlignedVector<float> spinAngle;
+    AlignedVector<float> localX;
+    AlignedVector<float> localY;
+    AlignedVector<float> localZ;
+    AlignedVector<float> posX;
+    AlignedVector<float> posY;
+    AlignedVector<float> posZ;
+    AlignedVector<float> prevX;
+    AlignedVector<float> prevY;
+    AlignedVector<float> prevZ;
+    AlignedVector<float> prevSpin;
+    AlignedVector<float> radius;
+    AlignedVector<int32_t> parent;
+    AlignedVector<uint32_t> materialId;
+    std::vector<std::string> names;
+
+    uint32_t addBody(const BodyDesc& desc);
+    void reserve(size_t count);
+    void clear();
+    size_t size() const { return names.size(); }
+    int32_t find(const std::string& name) const;
+
+    void evaluate(double julianDate);
+    // Only the time and spin angles, for when positions come from elsewhere
+    // (gravity mode integrates them).
+    void evaluateSpin(double julianDate);
+    // Checks the ephemeris lists these bodies in the same order before using it.
+    bool useEphemeris(const Ephemeris* source);
+    void storePreviousState();
+
+    glm::vec3 position(uint32_t index) const { return glm::vec3(posX[index], posY[index], posZ[index]); }
+    glm::vec3 localPosition(uint32_t index) const { return glm::vec3(localX[index], localY[index], localZ[index]); }
+    // Overrides one world position for display; the body's subtree stays put.
+    void setPosition(uint32_t index, const glm::vec3& p);
+    // Moves a body within its parent's frame. Takes effect, for the whole
+    // subtree, at the next updateWorldPositions() or evaluate().
+    void setLocalPosition(uint32_t index, const glm::vec3& offset);
+    void updateWorldPositions();
+
+    // Blend between the last two simulation states for display.
+    glm::vec3 interpolatedPosition(uint32_t index, float alpha) const;
+    float interpolatedSpin(uint32_t index, float alpha) const;
+
+private:
+    void markDirty(size_t begin, size_t end);
+
+    AlignedVector<uint8_t> dirty;
+    size_t firstDirty = 0;
+    // [begin, end) runs of bodies with orbital motion, propagated as batches.
+    std::vector<std::pair<uint32_t, uint32_t>> movingRuns;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef CONJUNCTION_SWEEP_H
+#define CONJUNCTION_SWEEP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AlignedAllocator.h"
+
+enum class ConjunctionKind {
+    Conjunction,    // centres within the threshold, disks apart
+    Transit,        // a smaller near disk crosses a larger far one
+    Occultation     // a larger near disk covers a far one
+};
+
+struct ConjunctionPair {
+    uint32_t nearBody;
+    uint32_t farBody;
+    float separation;       // between the centres, radians
+    ConjunctionKind kind;
+};
+
+struct ConjunctionStats {
+    size_t bodies = 0;
+    size_t swaps = 0;       // insertion-sort moves to restore the sweep order
+    size_t candidates = 0;  // pairs whose intervals overlap on the sweep axis
+};
+
+// Finds every pair of bodies that appear close together as seen from an
+// observer. Each body becomes an interval of ecliptic longitude: its apparent
+// radius plus half the threshold either side of its centre, widened by
+// 1/cos(latitude) away from the ecliptic, or the whole circle when that reach
+// touches a pole. The intervals are kept sorted by their start and swept
+// once, and only pairs that overlap in longitude and latitude get the exact
+// separation test. The order is kept between updates, so when bodies move a
+// little an insertion sort restores it in close to linear time. Intervals
+// that cross longitude +-pi are checked against the start of the order as
+// well.
+class ConjunctionSweep {
+public:
+    float threshold = 0.0174533f;   // radians (1 degree)
+
+    // Positions and radii in the same units; `radius` may be null for point
+    // bodies. The body at index `exclude` (the observer's own) is ignored.
+    void update(const float* x, const float* y, const float* z, const float* radius, size_t count,
+        const glm::vec3& observer, int64_t exclude = -1);
+
+    const std::vector<ConjunctionPair>& pairs() const { return found; }
+    const ConjunctionStats& stats() const { return lastStats; }
+
+private:
+    // Latitude and reach are copied in so most candidates are rejected
+    // without touching the per-body arrays.
+    struct Interval {
+        float start;        // longitude, in [-pi, pi)
+        float end;          // may pass pi
+        float latitude;
+        float reach;
+        uint32_t body;
+    };
+
+    void project(const float* x, const float* y, const float* z, const float* radius, size_t count,
+        const glm::vec3& observer);
+    void test(const Interval& a, const Interval& b);
+
+    AlignedVector<float> dirX, dirY, dirZ;
+    AlignedVector<float> latitude, apparentRadius, reach, distance;
+    std::vector<Interval> order;
+    int64_t orderExclude = -1;
+    std::vector<ConjunctionPair> found;
+    ConjunctionStats lastStats;
+};
+
+// O(n^2) reference with the same classification, for checks and benchmarks.
+void findConjunctionsBruteForce(const float* x, const float* y, const float* z, const float* radius, size_t count,
+    const glm::vec3& observer, float threshold, std::vector<ConjunctionPair>& pairs);
+
+#endif
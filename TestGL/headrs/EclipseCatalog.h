@@ -0,0 +1,61 @@
+#pragma once
+#ifndef ECLIPSE_CATALOG_H
+#define ECLIPSE_CATALOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "EclipseSearch.h"
+
+class ThreadPool;
+
+// Binary eclipse catalog written next to the CSV: a 64-byte header, then one
+// 32-byte record per eclipse sorted by time of greatest eclipse.
+const char ECLIPSE_CATALOG_MAGIC[8] = { 'S', 'S', 'E', 'C', 'L', 'I', 'P', '\0' };
+const uint32_t ECLIPSE_CATALOG_VERSION = 1;
+
+struct EclipseCatalogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    uint64_t count;
+    double from;                // Julian dates of the range searched
+    double to;
+    uint8_t reserved[24];
+};
+
+struct EclipseRecord {
+    double maximum;             // Julian date of greatest eclipse
+    double start;               // first and last contact
+    double end;
+    float magnitude;
+    uint8_t kind;               // EclipseKind
+    uint8_t type;               // EclipseType
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(EclipseCatalogHeader) == 64, "eclipse catalog header must stay 64 bytes");
+static_assert(sizeof(EclipseRecord) == 32, "eclipse records must stay 32 bytes");
+
+struct EclipseCatalogStats {
+    size_t events = 0;          // total in the catalog, including any from before a resume
+    size_t solar = 0;           // found by this run
+    size_t lunar = 0;
+    size_t resumedEvents = 0;   // already written when the run resumed
+    double seconds = 0.0;
+    bool interrupted = false;   // stopped by `cancel`; the checkpoint allows a resume
+};
+
+// Finds every solar and lunar eclipse (penumbral ones included) between
+// `from` and `to` and writes them to <base>.csv and <base>.ecl. The range is
+// cut into one-year shards searched in parallel; batches of shards finish in
+// time order, so the files stay sorted as they grow. After each batch the
+// progress goes to <base>.checkpoint, which a later call with `resume` set
+// picks up from (taking the range from the checkpoint). The checkpoint is
+// removed once the catalog is complete.
+bool generateEclipseCatalog(const EclipseModel& model, const std::string& basePath, double from, double to,
+    bool resume, ThreadPool& pool, EclipseCatalogStats& stats, const std::atomic<bool>* cancel = nullptr);
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef ECLIPSE_SEARCH_H
+#define ECLIPSE_SEARCH_H
+
+#include <atomic>
+#include <thread>
+
+#include "KeplerPropagator.h"
+
+enum class EclipseKind {
+    Solar,
+    Lunar
+};
+
+enum class EclipseType {
+    None,
+    Penumbral,      // lunar only
+    Partial,
+    Annular,        // solar only
+    Total
+};
+
+// Orbits the search evaluates, in AU and days: Earth about the Sun and the
+// Moon about the Earth, with their mean anomalies at `epoch`.
+struct EclipseModel {
+    double epoch = 0.0;
+    KeplerElements earthOrbit;
+    KeplerElements moonOrbit;
+    double sunRadius = 0.00465247;      // AU
+    double earthRadius = 4.26352e-5;
+    double moonRadius = 1.16138e-5;
+    double shadowEnlargement = 1.02;    // Earth's atmosphere widens the shadow by about 2%
+    bool penumbralLunar = false;        // also find lunar eclipses that miss the umbra
+};
+
+struct EclipseEvent {
+    EclipseKind kind = EclipseKind::Solar;
+    EclipseType type = EclipseType::None;   // None when nothing was found in the window
+    double start = 0.0;         // first contact, Julian date
+    double maximum = 0.0;       // least separation of the centres
+    double end = 0.0;           // last contact
+    double separation = 0.0;    // at maximum, radians
+    double magnitude = 0.0;
+};
+
+// Lower-case name of the type ("none", "penumbral", "partial", ...).
+const char* eclipseTypeName(EclipseType type);
+
+// Finds the first eclipse whose maximum falls after `from`, scanning at most
+// `maxDays`. Solar eclipses count when the penumbra touches the Earth, lunar
+// ones when the Moon enters the umbra (or the penumbra if the model asks for
+// penumbral eclipses). The scan brackets each local minimum
+// of the Sun-Moon (or shadow-Moon) separation, Brent's minimizer finds the
+// maximum, and Brent's root finder refines both contacts. A set `cancel`
+// flag ends the scan early with no event.
+EclipseEvent findNextEclipse(const EclipseModel& model, EclipseKind kind, double from, double maxDays,
+    const std::atomic<bool>* cancel = nullptr);
+
+// Runs findNextEclipse on a worker thread so the render loop never waits.
+// Starting a new search cancels the one in flight.
+class EclipseSearch {
+public:
+    EclipseSearch() = default;
+    ~EclipseSearch();
+
+    EclipseSearch(const EclipseSearch&) = delete;
+    EclipseSearch& operator=(const EclipseSearch&) = delete;
+
+    void start(const EclipseModel& model, EclipseKind kind, double from, double maxDays);
+    void cancel();
+    bool running() const { return worker.joinable() && !finished.load(std::memory_order_acquire); }
+
+    // True once per finished search, with its event and wall-clock time.
+    bool poll(EclipseEvent& event, double& seconds);
+
+private:
+    std::thread worker;
+    std::atomic<bool> cancelRequested{ false };
+    std::atomic<bool> finished{ false };
+    EclipseEvent result;
+    double resultSeconds = 0.0;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef ELEMENT_CATALOG_H
+#define ELEMENT_CATALOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "KeplerKernel.h"
+#include "MappedFile.h"
+
+class ThreadPool;
+
+// Compact binary orbital-element catalog for large minor-planet sets. The
+// columns are exactly the KeplerOrbitView arrays, so the renderer maps the
+// file and propagates from it without parsing or copying.
+//
+// Layout (little-endian): a 64-byte header, then the columns in view order
+// (two double columns, nine float columns), each starting on a 64-byte
+// boundary so the SIMD kernels can use aligned loads. Units are AU, radians
+// and days; mean anomalies are at the header epoch.
+const char ELEMENT_CATALOG_MAGIC[8] = { 'S', 'S', 'E', 'L', 'E', 'M', 'S', '\0' };
+const uint32_t ELEMENT_CATALOG_VERSION = 1;
+
+struct ElementCatalogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    uint64_t count;
+    double epoch;               // Julian date
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(ElementCatalogHeader) == 64, "element catalog header must stay 64 bytes");
+
+class ElementCatalog {
+public:
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    size_t size() const { return header ? static_cast<size_t>(header->count) : 0; }
+    double epoch() const { return header->epoch; }
+    const KeplerOrbitView& view() const { return columns; }
+
+private:
+    MappedFile file;
+    const ElementCatalogHeader* header = nullptr;
+    KeplerOrbitView columns = {};
+};
+
+struct CatalogIngestStats {
+    size_t bytes = 0;
+    size_t records = 0;
+    size_t rejected = 0;
+    size_t firstRejectedLine = 0;   // 1-based, 0 if every record was valid
+    double seconds = 0.0;
+};
+
+// Reads an MPCORB-style fixed-width element file in chunks, parses the
+// records of each chunk in parallel with std::from_chars, and writes the
+// catalog. Lines that fail validation are counted and skipped.
+bool ingestElementCatalog(const std::string& inputPath, const std::string& outputPath, ThreadPool& pool,
+    CatalogIngestStats& stats);
+
+#endif
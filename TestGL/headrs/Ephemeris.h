@@ -0,0 +1,87 @@
+#pragma once
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+
+// Binary ephemeris in the style of the JPL DE files: every body's track is cut
+// into fixed-length time segments, each holding Chebyshev coefficients for
+// x, y and z. Positions are relative to the body's parent, in scene units.
+//
+// Layout (little-endian): a 64-byte header, one 64-byte index entry per body,
+// then each body's segments as doubles [x0..xn-1, y0..yn-1, z0..zn-1],
+// starting on a 64-byte boundary.
+const char EPHEMERIS_MAGIC[8] = { 'S', 'S', 'E', 'P', 'H', 'E', 'M', '\0' };
+const uint32_t EPHEMERIS_VERSION = 1;
+
+struct EphemerisHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bodyCount;
+    double startTime;           // Julian dates
+    double endTime;
+    uint8_t reserved[32];
+};
+
+struct EphemerisBodyEntry {
+    char name[24];
+    int32_t parent;             // -1 for the origin
+    uint32_t coefficientCount;  // per axis and segment
+    uint32_t segmentCount;
+    uint32_t reserved;
+    double segmentDays;
+    uint64_t dataOffset;        // from the start of the file
+    uint8_t padding[8];
+};
+
+static_assert(sizeof(EphemerisHeader) == 64, "ephemeris header must stay 64 bytes");
+static_assert(sizeof(EphemerisBodyEntry) == 64, "ephemeris index entry must stay 64 bytes");
+
+// Read side: maps the file and evaluates straight from the mapping, so a
+// lookup is a segment index computation and a Clenshaw recurrence.
+class Ephemeris {
+public:
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    size_t bodyCount() const { return header ? header->bodyCount : 0; }
+    double startTime() const { return header->startTime; }
+    double endTime() const { return header->endTime; }
+    bool covers(double julianDate) const;
+    const EphemerisBodyEntry& body(size_t index) const { return entries[index]; }
+
+    // Position of one body relative to its parent.
+    glm::dvec3 relativePosition(size_t index, double julianDate) const;
+    // Parent-relative positions of every body, for BodyRegistry to compose.
+    void evaluateRelative(double julianDate, float* x, float* y, float* z) const;
+
+private:
+    MappedFile file;
+    const EphemerisHeader* header = nullptr;
+    const EphemerisBodyEntry* entries = nullptr;
+};
+
+// Write side, used by the offline tool.
+struct EphemerisBodySpec {
+    std::string name;
+    int32_t parent = -1;
+    double segmentDays = 8.0;
+    uint32_t coefficientCount = 12;
+};
+
+// Returns a body's parent-relative position at a Julian date.
+using EphemerisSampler = std::function<glm::dvec3(size_t body, double julianDate)>;
+
+// Fits each body's track by interpolating at the Chebyshev nodes of every segment.
+bool writeEphemeris(const std::string& path, const std::vector<EphemerisBodySpec>& bodies,
+    double startTime, double endTime, const EphemerisSampler& sampler);
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "AlignedAllocator.h"
+#include "FrustumKernel.h"
+#include "KeplerKernel.h"
+
+// A plane as learnopengl/entity.h's Plane holds it: unit normal and distance
+// from the origin along it. A sphere is on or in front of the plane when
+// its centre's signed distance is greater than -radius, as in entity.h's
+// Sphere::isOnOrForwardPlane.
+struct FrustumPlane {
+    glm::vec3 normal = { 0.0f, 1.0f, 0.0f };
+    float distance = 0.0f;
+
+    float signedDistance(const glm::vec3& point) const { return glm::dot(normal, point) - distance; }
+};
+
+static_assert(sizeof(FrustumPlane) == 4 * sizeof(float), "the culling kernels read planes as four floats");
+
+enum FrustumFace {
+    FACE_LEFT,
+    FACE_RIGHT,
+    FACE_BOTTOM,
+    FACE_TOP,
+    FACE_NEAR,
+    FACE_FAR,
+};
+
+// The faces of entity.h's Frustum, normals pointing inwards, held as an
+// array so the kernels can run over them. entity.h itself cannot be included
+// here: its Sphere bounding volume collides with our Sphere mesh, and it
+// needs learnopengl's Camera and Model.
+struct ViewFrustum {
+    FrustumPlane faces[6];
+
+    bool contains(const glm::vec3& centre, float radius) const {
+        for (const FrustumPlane& face : faces) {
+            if (face.signedDistance(centre) <= -radius)
+                return false;
+        }
+        return true;
+    }
+};
+
+// The frustum of a projection * view matrix, in world space.
+ViewFrustum frustumFromMatrix(const glm::mat4& viewProjection);
+
+// Bounding spheres as structure-of-arrays columns, for the SIMD kernels.
+struct SphereBounds {
+    AlignedVector<float> x, y, z, radius;
+
+    void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        radius.resize(count);
+    }
+    size_t size() const { return x.size(); }
+    void set(size_t i, const glm::vec3& centre, float r) {
+        x[i] = centre.x;
+        y[i] = centre.y;
+        z[i] = centre.z;
+        radius[i] = r;
+    }
+    SphereBoundsView view() const { return { x.data(), y.data(), z.data(), radius.data() }; }
+};
+
+// Tests bounding spheres against a frustum 8 (AVX2) or 16 (AVX-512) at a
+// time and keeps the indices of the ones that can be seen, in ascending
+// order, for the draw stage to gather.
+class FrustumCuller {
+public:
+    FrustumCuller();
+    explicit FrustumCuller(SimdLevel level);
+
+    SimdLevel level() const { return simdLevel; }
+
+    // Returns the number of visible spheres; visible() lists them until the
+    // next call.
+    size_t cull(const ViewFrustum& frustum, const SphereBounds& spheres);
+
+    const uint32_t* visible() const { return indices.data(); }
+    size_t visibleCount() const { return visibleTotal; }
+    size_t culledCount() const { return tested - visibleTotal; }
+
+private:
+    SimdLevel simdLevel;
+    AlignedVector<uint32_t> indices;
+    size_t visibleTotal = 0;
+    size_t tested = 0;
+};
+
+#endif
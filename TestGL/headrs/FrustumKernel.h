@@ -0,0 +1,63 @@
+#pragma once
+#ifndef FRUSTUM_KERNEL_H
+#define FRUSTUM_KERNEL_H
+
+// Bounding spheres against the six planes of a view frustum, written against
+// the same SIMD traits as KeplerKernel.h. Lanes run over spheres and the
+// planes are broadcast once, so each vector of spheres costs six fused
+// plane distances and one compaction of the surviving indices.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "KeplerKernel.h"
+
+struct SphereBoundsView {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* radius;
+};
+
+// `planes` is six (normal x, y, z, distance) quadruples; a sphere survives a
+// plane when dot(normal, centre) - distance > -radius. Writes the indices of
+// the spheres in [begin, end) that survive all six to `visible`, in order,
+// and returns how many there are. `visible` must have room for end - begin.
+size_t cullSpheresScalar(const SphereBoundsView& spheres, const float* planes, size_t begin, size_t end,
+    uint32_t* visible);
+size_t cullSpheresAvx2(const SphereBoundsView& spheres, const float* planes, size_t begin, size_t end,
+    uint32_t* visible);
+size_t cullSpheresAvx512(const SphereBoundsView& spheres, const float* planes, size_t begin, size_t end,
+    uint32_t* visible);
+
+template <typename S>
+inline size_t frustumKernel(const SphereBoundsView& s, const float* planes, size_t begin, size_t end,
+    uint32_t* visible) {
+    using F = typename S::F;
+    F nx[6], ny[6], nz[6], distance[6];
+    for (int p = 0; p < 6; ++p) {
+        nx[p] = S::set1(planes[4 * p]);
+        ny[p] = S::set1(planes[4 * p + 1]);
+        nz[p] = S::set1(planes[4 * p + 2]);
+        distance[p] = S::set1(planes[4 * p + 3]);
+    }
+
+    size_t count = 0;
+    size_t i = begin;
+    for (; i + S::width <= end; i += S::width) {
+        const F x = S::loadu(s.x + i), y = S::loadu(s.y + i), z = S::loadu(s.z + i);
+        const F limit = S::neg(S::loadu(s.radius + i));
+        auto inside = S::cmpGt(S::sub(S::fmadd(nz[0], z, S::fmadd(ny[0], y, S::mul(nx[0], x))), distance[0]), limit);
+        for (int p = 1; p < 6; ++p) {
+            const F signedDistance = S::sub(S::fmadd(nz[p], z, S::fmadd(ny[p], y, S::mul(nx[p], x))), distance[p]);
+            inside = S::maskAnd(inside, S::cmpGt(signedDistance, limit));
+        }
+        count += S::appendIndices(inside, static_cast<uint32_t>(i), visible + count);
+    }
+
+    if (i < end)
+        count += cullSpheresScalar(s, planes, i, end, visible + count);
+    return count;
+}
+
+#endif
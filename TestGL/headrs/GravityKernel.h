@@ -0,0 +1,59 @@
+#pragma once
+#ifndef GRAVITY_KERNEL_H
+#define GRAVITY_KERNEL_H
+
+// Pairwise gravity for one tile pair, written against the same kind of SIMD
+// traits as KeplerKernel.h and instantiated per instruction set. Lanes run
+// over receiving bodies and sources are broadcast, so accelerations stay in
+// registers for the whole source tile and no horizontal sums are needed.
+
+#include <cstddef>
+
+struct GravityView {
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* m;
+    double* ax;
+    double* ay;
+    double* az;
+};
+
+void accumulateGravityScalar(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd);
+void accumulateGravityAvx2(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd);
+void accumulateGravityAvx512(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd);
+
+// Adds the pull of bodies [jBegin, jEnd) on bodies [iBegin, iEnd), without G.
+// A body's pull on itself has zero offset; the clamp keeps its factor finite.
+template <typename S>
+inline void gravityKernel(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd) {
+    using F = typename S::F;
+    const F minR2 = S::set1(1e-100);
+
+    size_t i = iBegin;
+    for (; i + S::width <= iEnd; i += S::width) {
+        const F xi = S::loadu(v.x + i), yi = S::loadu(v.y + i), zi = S::loadu(v.z + i);
+        F ax = S::set1(0.0), ay = S::set1(0.0), az = S::set1(0.0);
+
+        for (size_t j = jBegin; j < jEnd; ++j) {
+            const F dx = S::sub(S::set1(v.x[j]), xi);
+            const F dy = S::sub(S::set1(v.y[j]), yi);
+            const F dz = S::sub(S::set1(v.z[j]), zi);
+            F r2 = S::fmadd(dz, dz, S::fmadd(dy, dy, S::mul(dx, dx)));
+            r2 = S::max(r2, minR2);
+            const F s = S::div(S::set1(v.m[j]), S::mul(r2, S::sqrt(r2)));
+            ax = S::fmadd(dx, s, ax);
+            ay = S::fmadd(dy, s, ay);
+            az = S::fmadd(dz, s, az);
+        }
+
+        S::storeu(v.ax + i, S::add(S::loadu(v.ax + i), ax));
+        S::storeu(v.ay + i, S::add(S::loadu(v.ay + i), ay));
+        S::storeu(v.az + i, S::add(S::loadu(v.az + i), az));
+    }
+
+    if (i < iEnd)
+        accumulateGravityScalar(v, i, iEnd, jBegin, jEnd);
+}
+
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef INSTANCE_CULLER_H
+#define INSTANCE_CULLER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "FrustumCulling.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include "Sphere.h"
+#include "SphereBatch.h"
+#include "StreamBuffer.h"
+
+// Culls a population of sphere instances and draws what is left, each at
+// the level of the sphere's LOD chain its size on screen calls for.
+//
+// On a GL 4.3 context the work stays on the GPU. The chosen occluders are
+// drawn into a small depth buffer, reduced to a pyramid of farthest depths
+// (Hi-Z), and a compute dispatch tests every instance's bounding sphere
+// against the frustum and the pyramid, picks its level and counts it into
+// that level's DrawElementsIndirectCommand. A second dispatch copies the
+// survivors into a compact instance buffer, one run per level, and one
+// glMultiDrawElementsIndirect draws every level; the CPU cost per frame
+// does not grow with the population.
+//
+// Otherwise the instances are kept on the CPU, their bounding spheres
+// tested against the frustum only by a FrustumCuller, and the survivors
+// drawn through one SphereBatch per level.
+class InstanceCuller {
+public:
+    static const int HIZ_WIDTH = 512;
+    static const int HIZ_HEIGHT = 256;
+
+    bool gpu = false;
+    bool occlusion = true;      // test against the pyramid as well as the frustum (GPU only)
+    SphereLodSettings lod;
+
+    // `allowGpu` false forces the CPU path.
+    explicit InstanceCuller(const Sphere& unitSphere, bool allowGpu = true);
+    ~InstanceCuller();
+    InstanceCuller(const InstanceCuller&) = delete;
+    InstanceCuller& operator=(const InstanceCuller&) = delete;
+
+    // Replaces the instances, written in place between the two calls.
+    SphereInstance* beginUpload(size_t count);
+    void endUpload();
+    // Culls the last upload for this camera and picks each survivor's
+    // level. The first `occluderCount` instances are drawn into the
+    // pyramid, so put the large bodies first. An instance's level depends on
+    // the one it had last frame, so keep the upload order stable. Leaves its
+    // own program, texture and depth state bound, so a GLStateCache has to
+    // be invalidated after it.
+    void cull(const glm::mat4& view, const glm::mat4& projection, int viewportHeight, size_t occluderCount);
+    // The survivors of the last cull, for the render queue: one indirect
+    // multi-draw on the GPU path, one draw per level on the CPU path.
+    size_t drawCount() const { return gpu ? 1 : levels; }
+    DrawGeometry geometry(size_t draw = 0) const;
+
+    size_t size() const { return instanceCount; }
+    size_t lodCount() const { return levels; }
+    // Survivors of the last cull, in all and per level, and the triangles
+    // they make. Reads the draw commands back on the GPU path, which waits
+    // for the dispatch; meant for statistics.
+    size_t readVisibleCount() const;
+    std::vector<size_t> readLodCounts() const;
+    size_t readTriangleCount() const;
+
+private:
+    void createGpuResources(const Sphere& unitSphere);
+    void buildPyramid(size_t occluderCount);
+    void dispatchPerInstance(Shader& program, size_t count);
+    void cullOnCpu(const ViewFrustum& frustum, const glm::vec3& eye, float focalPixels);
+
+    size_t instanceCount = 0;
+    unsigned int indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    std::vector<SphereLod> lods;
+    size_t levels = 0;
+
+    // GPU path.
+    std::unique_ptr<StreamBuffer> input;
+    std::unique_ptr<Shader> cullProgram, scatterProgram, depthProgram, reduceProgram;
+    UniformBuffer cullBuffer;
+    unsigned int visibleBuffer = 0;
+    unsigned int lodBuffer = 0;     // per instance: last level and this frame's slot
+    size_t visibleCapacity = 0;
+    unsigned int commandBuffer = 0;
+    std::vector<GLuint> commands;   // the DrawElementsIndirectCommands with no instances
+    unsigned int drawVAO = 0, occluderVAO = 0;
+    unsigned int pyramid = 0, pyramidDepth = 0, pyramidFBO = 0;
+    int pyramidLevels = 0;
+    size_t inputOffset = 0;
+    size_t storageAlignment = 1;
+    GLuint maxGroups = 65535;       // GL_MAX_COMPUTE_WORK_GROUP_COUNT in x
+
+    // CPU path.
+    std::vector<std::unique_ptr<SphereBatch>> batches;
+    std::vector<SphereInstance> instances;
+    std::vector<int> instanceLods;  // level each instance was last drawn at, -1 for none
+    std::vector<int> visibleLods;
+    std::vector<size_t> lodCounts;
+    SphereBounds bounds;
+    FrustumCuller frustumCuller;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef JULIAN_DATE_H
+#define JULIAN_DATE_H
+
+#include <string>
+
+const double J2000 = 2451545.0;
+
+// Gregorian calendar <-> Julian date (Meeus, Astronomical Algorithms ch. 7).
+double calendarToJulianDate(int year, int month, double day);
+void julianDateToCalendar(double jd, int& year, int& month, double& day);
+
+double currentJulianDate();
+std::string formatJulianDate(double jd);
+
+// Accepts "YYYY-MM-DD" or "YYYY-MM-DDThh:mm"; negative years are astronomical.
+bool parseCalendarDate(const char* text, double& jd);
+
+#endif
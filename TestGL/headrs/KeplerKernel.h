@@ -0,0 +1,110 @@
+#pragma once
+#ifndef KEPLER_KERNEL_H
+#define KEPLER_KERNEL_H
+
+// Shared Kepler solve, written once against a small SIMD traits interface and
+// instantiated per instruction set. The AVX2/AVX-512 translation units include
+// only this header so no standard library code is compiled with wider ISA
+// flags than the running CPU might support.
+
+#include <cstddef>
+
+enum class SimdLevel {
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+struct KeplerOrbitView {
+    const double* meanAnomalyAtEpoch;
+    const double* meanMotion;
+    const float* semiMajor;
+    const float* semiMinor;
+    const float* eccentricity;
+    const float* px;
+    const float* py;
+    const float* pz;
+    const float* qx;
+    const float* qy;
+    const float* qz;
+};
+
+void propagateKeplerScalar(const KeplerOrbitView& orbits, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations);
+void propagateKeplerAvx2(const KeplerOrbitView& orbits, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations);
+void propagateKeplerAvx512(const KeplerOrbitView& orbits, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations);
+
+// Cephes-style sincos: Cody-Waite reduction by pi/2, minimax polynomials on
+// [-pi/4, pi/4], quadrant fix-up with selects so every lane runs the same path.
+template <typename S>
+inline void simdSinCos(typename S::F x, typename S::F& s, typename S::F& c) {
+    using F = typename S::F;
+    const F q = S::round(S::mul(x, S::set1(0.63661977236758134f)));
+    F r = S::fnmadd(q, S::set1(1.5703125f), x);
+    r = S::fnmadd(q, S::set1(4.837512969970703125e-4f), r);
+    r = S::fnmadd(q, S::set1(7.54978995489188216e-8f), r);
+
+    const F r2 = S::mul(r, r);
+    F ps = S::fmadd(r2, S::set1(-1.9515295891e-4f), S::set1(8.3321608736e-3f));
+    ps = S::fmadd(r2, ps, S::set1(-1.6666654611e-1f));
+    ps = S::fmadd(S::mul(r2, r), ps, r);
+
+    F pc = S::fmadd(r2, S::set1(2.443315711809948e-5f), S::set1(-1.388731625493765e-3f));
+    pc = S::fmadd(r2, pc, S::set1(4.166664568298827e-2f));
+    pc = S::fmadd(S::mul(r2, r2), pc, S::fnmadd(S::set1(0.5f), r2, S::set1(1.0f)));
+
+    // Quadrant q mod 4 without integer lanes.
+    const F quadrant = S::fnmadd(S::set1(4.0f), S::floor(S::mul(q, S::set1(0.25f))), q);
+    const F shifted = S::fnmadd(S::set1(4.0f), S::floor(S::mul(S::add(q, S::set1(1.0f)), S::set1(0.25f))),
+        S::add(q, S::set1(1.0f)));
+    const auto odd = S::cmpEq(S::fnmadd(S::set1(2.0f), S::floor(S::mul(q, S::set1(0.5f))), q), S::set1(1.0f));
+
+    const F sinBase = S::select(odd, pc, ps);
+    const F cosBase = S::select(odd, ps, pc);
+    s = S::select(S::cmpGe(quadrant, S::set1(2.0f)), S::neg(sinBase), sinBase);
+    c = S::select(S::cmpGe(shifted, S::set1(2.0f)), S::neg(cosBase), cosBase);
+}
+
+// Solves E - e sin E = M with a fixed number of Halley steps from Danby's
+// starting guess, then maps the perifocal position through P/Q.
+template <typename S>
+inline void keplerKernel(const KeplerOrbitView& o, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations) {
+    using F = typename S::F;
+    alignas(64) float mean[S::width];
+
+    size_t i = begin;
+    for (; i + S::width <= end; i += S::width) {
+        S::meanAnomaly(o.meanAnomalyAtEpoch + i, o.meanMotion + i, dt, mean);
+        const F M = S::load(mean);
+        const F e = S::loadu(o.eccentricity + i);
+
+        F sinE, cosE;
+        simdSinCos<S>(M, sinE, cosE);
+        const F direction = S::select(S::cmpGe(sinE, S::set1(0.0f)), S::set1(1.0f), S::set1(-1.0f));
+        F E = S::fmadd(S::mul(S::set1(0.85f), e), direction, M);
+
+        for (int k = 0; k < iterations; ++k) {
+            simdSinCos<S>(E, sinE, cosE);
+            const F esin = S::mul(e, sinE);
+            const F f = S::sub(S::sub(E, esin), M);
+            const F fp = S::fnmadd(e, cosE, S::set1(1.0f));
+            const F halley = S::fnmadd(S::mul(S::set1(0.5f), f), S::div(esin, fp), fp);
+            E = S::sub(E, S::div(f, halley));
+        }
+        simdSinCos<S>(E, sinE, cosE);
+
+        const F X = S::mul(S::loadu(o.semiMajor + i), S::sub(cosE, e));
+        const F Y = S::mul(S::loadu(o.semiMinor + i), sinE);
+        S::storeu(x + i, S::fmadd(S::loadu(o.px + i), X, S::mul(S::loadu(o.qx + i), Y)));
+        S::storeu(y + i, S::fmadd(S::loadu(o.py + i), X, S::mul(S::loadu(o.qy + i), Y)));
+        S::storeu(z + i, S::fmadd(S::loadu(o.pz + i), X, S::mul(S::loadu(o.qz + i), Y)));
+    }
+
+    if (i < end)
+        propagateKeplerScalar(o, dt, x, y, z, i, end, iterations);
+}
+
+#endif
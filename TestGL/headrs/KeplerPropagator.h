@@ -0,0 +1,76 @@
+#pragma once
+#ifndef KEPLER_PROPAGATOR_H
+#define KEPLER_PROPAGATOR_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+#include "AlignedAllocator.h"
+#include "KeplerKernel.h"
+
+// Classical orbital elements. Angles are in radians, the mean motion is in
+// radians per unit of simulation time and the mean anomaly is taken at the
+// owning set's epoch.
+struct KeplerElements {
+    double semiMajor = 0.0;
+    double eccentricity = 0.0;
+    double inclination = 0.0;
+    double ascendingNode = 0.0;
+    double argPeriapsis = 0.0;
+    double meanAnomaly = 0.0;
+    double meanMotion = 0.0;
+};
+
+// Elements for many bodies in structure-of-arrays form. The orientation
+// angles are folded into the perifocal P/Q axes when a body is added, so
+// propagation is only the Kepler solve and two multiply-adds per axis.
+// P/Q are stored in scene axes: the reference plane is x-z with y up.
+class KeplerOrbitSet {
+public:
+    double epoch = 0.0;
+    AlignedVector<double> meanAnomalyAtEpoch;
+    AlignedVector<double> meanMotion;
+    AlignedVector<float> semiMajor;
+    AlignedVector<float> semiMinor;
+    AlignedVector<float> eccentricity;
+    AlignedVector<float> px, py, pz;
+    AlignedVector<float> qx, qy, qz;
+
+    size_t add(const KeplerElements& elements);
+    void set(size_t index, const KeplerElements& elements);
+    void reserve(size_t count);
+    void clear();
+    size_t size() const { return semiMajor.size(); }
+    KeplerOrbitView view() const;
+};
+
+class KeplerPropagator {
+public:
+    // Newton/Halley iterations per solve; 4 is enough for e < 0.95 in float.
+    int iterations = 4;
+
+    KeplerPropagator();
+    explicit KeplerPropagator(SimdLevel level);
+
+    SimdLevel level() const { return simdLevel; }
+
+    void propagate(const KeplerOrbitSet& orbits, double time, float* x, float* y, float* z) const;
+    void propagateRange(const KeplerOrbitSet& orbits, double time, float* x, float* y, float* z,
+        size_t begin, size_t end) const;
+    // Same for columns held elsewhere, such as a mapped ElementCatalog.
+    void propagateRange(const KeplerOrbitView& orbits, double epoch, double time, float* x, float* y, float* z,
+        size_t begin, size_t end) const;
+
+private:
+    SimdLevel simdLevel;
+};
+
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// Double-precision reference used for orbit paths and accuracy checks.
+glm::dvec3 keplerPositionAtAnomaly(const KeplerElements& elements, double eccentricAnomaly);
+glm::dvec3 keplerPosition(const KeplerElements& elements, double timeSinceEpoch);
+glm::dvec3 keplerVelocity(const KeplerElements& elements, double timeSinceEpoch);
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef MESH_REGISTRY_H
+#define MESH_REGISTRY_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "KeplerPropagator.h"
+#include "OrbitPath.h"
+#include "Sphere.h"
+
+// Geometry resident for the meshes in a registry.
+struct MeshMemory {
+    size_t meshes = 0;          // distinct meshes built
+    size_t requests = 0;        // lookups, repeats included
+    size_t cpuBytes = 0;        // geometry still held on the CPU: the spheres' LOD tables
+    size_t gpuBytes = 0;        // vertex and index buffers
+    size_t sharedBytes = 0;     // GPU bytes the repeat requests would have uploaded again
+};
+
+// Hands out one mesh per set of generator parameters, so everything drawing
+// the same sphere or orbit shares its buffers. A mesh is built on its first
+// request and lives as long as the registry, which must outlive whatever
+// draws it (SphereBatch and InstanceCuller keep its buffers bound).
+class MeshRegistry {
+public:
+    MeshRegistry() = default;
+    MeshRegistry(const MeshRegistry&) = delete;
+    MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+    // Same parameters as the Sphere constructors.
+    Sphere& sphere(float radius, int sectors = 36, int stacks = 18);
+    Sphere& sphere(float radius, const std::vector<int>& lodSectors);
+    Sphere& sphere(SphereTopology topology, const std::vector<int>& lodDetail);
+    OrbitPath& keplerOrbit(const KeplerElements& elements, int segments = 100);
+
+    MeshMemory memory() const;
+    // Deletes every mesh; references handed out before are left dangling.
+    void clear();
+
+private:
+    // What the mesh was built from: which generator, then its arguments.
+    struct Key {
+        int generator;
+        std::vector<double> parameters;
+        bool operator<(const Key& other) const {
+            return generator != other.generator ? generator < other.generator : parameters < other.parameters;
+        }
+    };
+
+    template <typename Mesh, typename Build>
+    Mesh& find(std::map<Key, std::unique_ptr<Mesh>>& meshes, Key key, Build build);
+
+    std::map<Key, std::unique_ptr<Sphere>> spheres;
+    std::map<Key, std::unique_ptr<OrbitPath>> orbits;
+    size_t requests = 0;
+    size_t sharedBytes = 0;
+};
+
+#endif
@@ -6,19 +6,24 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include "KeplerPropagator.h"
+#include "RenderQueue.h"
+
 class OrbitPath {
 public:
     unsigned int VAO, VBO;
     unsigned int pointCount;
+    size_t vertexBytes = 0;     // size of the GPU buffer; no copy of the points stays on the CPU
 
     OrbitPath();
     ~OrbitPath();
-    void generateEarthOrbit(float semiMajor, float semiMinor, int segments = 100);
-    void generateMoonOrbit(float radius, int segments = 100);
+    void generateKeplerOrbit(const KeplerElements& elements, int segments = 100);
     void Draw();
+    DrawGeometry geometry() const;
+    size_t gpuBytes() const { return vertexBytes; }
 
 private:
-    std::vector<float> vertices;
+    void upload(const std::vector<float>& vertices);
 };
 
 #endif
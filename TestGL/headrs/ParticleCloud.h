@@ -0,0 +1,28 @@
+#pragma once
+#ifndef PARTICLE_CLOUD_H
+#define PARTICLE_CLOUD_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+
+// Point sprites for simulated particles, streamed to the GPU whenever they
+// move.
+class ParticleCloud {
+public:
+    unsigned int VAO;
+    unsigned int pointCount;
+
+    ParticleCloud();
+    ~ParticleCloud();
+    void update(const float* x, const float* y, const float* z, size_t count);
+    void Draw();
+    DrawGeometry geometry() const;
+
+private:
+    StreamBuffer stream;
+};
+
+#endif
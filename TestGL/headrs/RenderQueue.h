@@ -0,0 +1,146 @@
+#pragma once
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class UniformBuffer;
+
+// What a mesh hands the render queue to be drawn: its vertex array and the
+// draw call to issue. indexType 0 means glDrawArrays, anything else the
+// type of the bound element buffer. A non-zero indirectBuffer holds
+// `drawCount` DrawElementsIndirectCommand records written on the GPU, which
+// replace count and instances (GL 4.3).
+struct DrawGeometry {
+    unsigned int vertexArray = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    GLenum indexType = 0;
+    GLsizei instances = 1;
+    unsigned int indirectBuffer = 0;
+    GLsizei drawCount = 0;
+    size_t indexOffset = 0;     // bytes into the element buffer
+};
+
+// GL calls made and skipped since the last reset.
+struct RenderStats {
+    unsigned int draws = 0;
+    unsigned int programSwitches = 0;
+    unsigned int textureBinds = 0;
+    unsigned int vertexArrayBinds = 0;
+    unsigned int stateChanges = 0;      // enables, depth and blend functions, line width, point size, buffer ranges
+    unsigned int redundantSkipped = 0;
+
+    void reset() { *this = RenderStats(); }
+};
+
+// Issues a GL call only when it changes what is bound or set. The cache only
+// knows about calls made through it, so invalidate() it after any GL code
+// that goes around it.
+class GLStateCache {
+public:
+    static const int TEXTURE_UNITS = 4;
+    static const int BUFFER_BINDINGS = 4;
+
+    RenderStats stats;
+
+    GLStateCache() { invalidate(); }
+    // Forgets everything, so the next call of each kind goes to GL.
+    void invalidate();
+
+    void useProgram(unsigned int program);
+    void bindTexture(unsigned int unit, GLenum target, unsigned int texture);
+    void bindVertexArray(unsigned int vertexArray);
+    void bindUniformRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size);
+    void setEnabled(GLenum capability, bool enabled);   // GL_BLEND, GL_DEPTH_TEST or GL_CULL_FACE
+    void depthFunc(GLenum func);
+    void depthMask(bool write);
+    void blendFunc(GLenum source, GLenum destination);
+    void lineWidth(float width);
+    void pointSize(float size);
+
+private:
+    unsigned int program;
+    unsigned int activeUnit;
+    GLenum textureTargets[TEXTURE_UNITS];
+    unsigned int textures[TEXTURE_UNITS];
+    unsigned int vertexArray;
+    struct BufferRange {
+        unsigned int buffer;
+        size_t offset;
+        size_t size;
+    };
+    BufferRange ranges[BUFFER_BINDINGS];
+    int enabled[3];                     // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE
+    GLenum depthFunction;
+    int depthWrite;
+    GLenum blendSource, blendDestination;
+    float width;
+    float pointDiameter;
+};
+
+// Draws are grouped by pass, which fixes the blend and depth state, then
+// sorted within a pass by their key.
+enum RenderPass : uint8_t {
+    PASS_OPAQUE,            // front to back, depth tested and written
+    PASS_SKY,               // at the far plane, after the opaque pass has filled the depth buffer
+    PASS_TRANSPARENT,       // back to front, alpha blended
+};
+
+struct TextureBinding {
+    GLenum target = 0;      // 0 leaves the unit alone
+    unsigned int texture = 0;
+};
+
+struct DrawItem {
+    RenderPass pass = PASS_OPAQUE;
+    unsigned int program = 0;
+    TextureBinding textures[GLStateCache::TEXTURE_UNITS];
+    DrawGeometry geometry;
+    size_t objectOffset = SIZE_MAX;     // Object block range in the queue's object buffer, SIZE_MAX for none
+    float depth = 0.0f;                 // distance from the camera
+    float lineWidth = 1.0f;
+    float pointSize = 1.0f;
+};
+
+// Collects a frame's draws, sorts them by a 64-bit key and submits them
+// through a GLStateCache. Opaque keys are, from the top bit down, pass (4),
+// program (12), texture (16), vertex array (16) and depth (16), so state
+// changes as rarely as it can and ties go front to back. Transparent keys
+// put the inverted depth right after the pass, since blending needs back to
+// front more than it needs fewer binds.
+class RenderQueue {
+public:
+    GLStateCache state;
+    const UniformBuffer* objectBuffer = nullptr;
+    float depthRange = 1000.0f;         // depths from 0 to this map onto the key's depth bits
+    // For comparisons: draw in submission order, and/or send every bind
+    // to GL as immediate-mode code would.
+    bool sorted = true;
+    bool filtered = true;
+
+    void submit(const DrawItem& item);
+    // Sorts and draws everything submitted since the last flush and clears
+    // the queue. Starts from an invalidated cache, so GL calls made between
+    // flushes are fine. Leaves blending off and depth testing and writes on.
+    void flush();
+
+    size_t size() const { return items.size(); }
+    uint64_t sortKey(const DrawItem& item) const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    void draw(const DrawItem& item);
+
+    std::vector<DrawItem> items;
+    std::vector<Entry> order;
+};
+
+#endif
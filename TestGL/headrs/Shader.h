@@ -3,30 +3,96 @@
 #define SHADER_H
 
 #include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// A uniform name and its 32-bit FNV-1a hash. String literals are hashed at
+// compile time, so passing one to a setter costs nothing at run time; other
+// strings have to be wrapped explicitly, and must outlive the lookup.
+class UniformName {
+public:
+    template <size_t N>
+    consteval UniformName(const char (&name)[N]) : text(name, N - 1), hash(fnv1a(text)) {}
+    explicit constexpr UniformName(std::string_view name) : text(name), hash(fnv1a(name)) {}
+
+    static constexpr uint32_t fnv1a(std::string_view name) {
+        uint32_t h = 2166136261u;
+        for (char c : name)
+            h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+        return h;
+    }
+
+    std::string_view text;
+    uint32_t hash;
+};
+
+// Uniform locations of one program by name hash, filled once after linking.
+// Names the program does not use resolve to -1, which glUniform* ignores.
+// The name is compared once the hash matches, so two names that collide
+// still find their own locations.
+class UniformTable {
+public:
+    // Returns false if the name is already in the table.
+    bool add(std::string_view name, int location);
+    int find(UniformName name) const;
+    size_t size() const { return count; }
+
+private:
+    // Open addressing on the low bits of the hash, at most half full, so a
+    // lookup is one or two probes.
+    struct Entry {
+        uint32_t hash;
+        int location;
+        uint32_t nameOffset;    // into names
+        uint32_t nameLength;
+    };
+    static const int EMPTY = -2;
+
+    void grow();
+    bool matches(const Entry& entry, uint32_t hash, std::string_view name) const {
+        return entry.hash == hash && std::string_view(names).substr(entry.nameOffset, entry.nameLength) == name;
+    }
+
+    std::vector<Entry> slots;
+    std::string names;          // every name, back to back
+    size_t count = 0;
+};
+
 class Shader {
 public:
     unsigned int ID; 
 
     Shader(const char* vertexPath, const char* fragmentPath);
+    // A compute program. Needs a GL 4.3 context.
+    explicit Shader(const char* computePath);
 
     void use();
 
-    void setBool(const std::string& name, bool value) const;
-    void setInt(const std::string& name, int value) const;
-    void setFloat(const std::string& name, float value) const;
-    void setMat4(const std::string& name, const glm::mat4& mat) const;
-    void setVec3(const std::string& name, const glm::vec3& value) const;
-    void setVec3(const std::string& name, float x, float y, float z) const;
+    void setBool(UniformName name, bool value) const;
+    void setInt(UniformName name, int value) const;
+    void setFloat(UniformName name, float value) const;
+    void setMat4(UniformName name, const glm::mat4& mat) const;
+    void setVec3(UniformName name, const glm::vec3& value) const;
+    void setVec3(UniformName name, float x, float y, float z) const;
+    // Attaches a uniform block to a buffer binding point. Returns false if the
+    // program has no active block of that name.
+    bool bindUniformBlock(const std::string& name, unsigned int binding) const;
+
+    const UniformTable& uniforms() const { return uniformTable; }
 
 private:
+    void reflectUniforms();
     void checkCompileErrors(unsigned int shader, std::string type);
+
+    UniformTable uniformTable;
 };
 
 #endif
\ No newline at end of file
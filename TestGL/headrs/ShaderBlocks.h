@@ -0,0 +1,114 @@
+#pragma once
+#ifndef SHADER_BLOCKS_H
+#define SHADER_BLOCKS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class Shader;
+
+// C++ mirrors of the std140 uniform blocks declared in the shaders. Members
+// are only vec4, ivec4 and mat4, which std140 lays out back to back, so the
+// offsets below are the std140 ones; checkBlockLayouts() compares them with
+// what the driver reports for each linked program.
+
+const unsigned int FRAME_BLOCK_BINDING = 0;
+const unsigned int OBJECT_BLOCK_BINDING = 1;
+const unsigned int CULL_BLOCK_BINDING = 2;
+
+const int MAX_OCCLUDERS = 16;
+
+// Uploaded once per frame and shared by every program.
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 viewPos;
+    glm::vec4 sunPos;                       // w = radius
+    glm::vec4 sunLight;                     // rgb = colour, a = intensity
+    glm::vec4 moonPos;
+    glm::vec4 moonLight;                    // rgb = colour, a = intensity
+    glm::vec4 occluders[MAX_OCCLUDERS];     // centre, radius
+    glm::ivec4 occluderCount;               // x
+};
+
+static_assert(offsetof(FrameBlock, projection) == 64, "Frame.projection");
+static_assert(offsetof(FrameBlock, viewPos) == 128, "Frame.viewPos");
+static_assert(offsetof(FrameBlock, sunPos) == 144, "Frame.sunPos");
+static_assert(offsetof(FrameBlock, sunLight) == 160, "Frame.sunLight");
+static_assert(offsetof(FrameBlock, moonPos) == 176, "Frame.moonPos");
+static_assert(offsetof(FrameBlock, moonLight) == 192, "Frame.moonLight");
+static_assert(offsetof(FrameBlock, occluders) == 208, "Frame.occluders");
+static_assert(offsetof(FrameBlock, occluderCount) == 208 + 16 * MAX_OCCLUDERS, "Frame.occluderCount");
+static_assert(sizeof(FrameBlock) == 224 + 16 * MAX_OCCLUDERS, "FrameBlock must match the std140 Frame block");
+
+// Bits of ObjectBlock::flags.y and SphereInstance::flags.y.
+const int OBJECT_USE_TEXTURE = 1;
+const int OBJECT_USE_NIGHT_TEXTURE = 2;
+const int OBJECT_USE_CLOUDS_TEXTURE = 4;
+const int OBJECT_USE_SHADOW_TEXTURE = 8;
+const int OBJECT_IS_MOON = 16;
+
+// One per draw; all of a frame's objects share a buffer and each draw binds
+// its own range.
+struct ObjectBlock {
+    glm::mat4 model;
+    glm::mat4 normalMatrix;     // inverse transpose of the model's 3x3
+    glm::vec4 color;
+    glm::ivec4 flags;           // x = object type, y = OBJECT_* bits, z = occluders to skip
+};
+
+static_assert(offsetof(ObjectBlock, normalMatrix) == 64, "Object.normalMatrix");
+static_assert(offsetof(ObjectBlock, color) == 128, "Object.color");
+static_assert(offsetof(ObjectBlock, flags) == 144, "Object.flags");
+static_assert(sizeof(ObjectBlock) == 160, "ObjectBlock must match the std140 Object block");
+
+// Read by the GPU culling programs of an InstanceCuller.
+struct CullBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 planes[6];        // world-space frustum planes, xyz = unit normal, pointing in
+    glm::vec4 hiz;              // pyramid width, height, mip levels, near plane
+    glm::ivec4 counts;          // x = instances, y = use the pyramid, z = levels in the LOD chain
+    glm::vec4 lod;              // x = focal length in pixels, y = pixel error, z = hysteresis
+    glm::vec4 lodErrors[2];     // SphereLod::error of each level, four to a vec4
+};
+
+static_assert(offsetof(CullBlock, projection) == 64, "Cull.projection");
+static_assert(offsetof(CullBlock, planes) == 128, "Cull.planes");
+static_assert(offsetof(CullBlock, hiz) == 224, "Cull.hiz");
+static_assert(offsetof(CullBlock, counts) == 240, "Cull.counts");
+static_assert(offsetof(CullBlock, lod) == 256, "Cull.lod");
+static_assert(offsetof(CullBlock, lodErrors) == 272, "Cull.lodErrors");
+static_assert(sizeof(CullBlock) == 304, "CullBlock must match the std140 Cull block");
+
+// A uniform buffer attached to one binding point.
+class UniformBuffer {
+public:
+    unsigned int id = 0;
+    unsigned int binding = 0;
+    size_t capacity = 0;
+
+    void create(unsigned int bindingPoint, size_t size);
+    // Replaces the first `size` bytes, growing the buffer if needed.
+    void upload(const void* data, size_t size);
+    // Attaches `size` bytes from `offset` to the binding point. `offset` must
+    // be a multiple of uniformOffsetAlignment().
+    void bindRange(size_t offset, size_t size) const;
+};
+
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of the current context.
+size_t uniformOffsetAlignment();
+
+// Attaches the Frame, Object and Cull blocks of a program to their binding
+// points and checks every member offset and the block sizes against the
+// structs above. Prints the differences and returns false on a mismatch.
+bool checkBlockLayouts(const Shader& shader, const char* programName);
+
+// Sets what the solar program still takes outside its blocks: the body
+// texture array on unit 0, the shadow map on unit 1 (sampler types must not
+// share a unit) and whether it reads CompactSphereVertex vertices. The
+// program must be in use.
+void setSolarUniforms(const Shader& solar, bool compactVertices);
+
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+#ifndef SHADOW_KERNEL_H
+#define SHADOW_KERNEL_H
+
+// Local circumstances of a solar eclipse for many surface points at once,
+// written against the same SIMD traits as KeplerKernel.h. Lanes run over
+// points and time steps are broadcast, so each point's running maxima stay
+// in registers for the whole batch of steps.
+//
+// An observer is inside the Moon's umbra when the Moon's disk covers the
+// Sun's, inside the antumbra when it sits within it, and inside the penumbra
+// when the disks overlap, so comparing the apparent disks seen from each
+// point is the shadow-cone test without building the cones.
+
+#include <cstddef>
+
+// Geocentric Sun and Moon in Earth radii, in the scene frame, and the
+// rotation of the Earth's body frame about +y at one instant. Points farther
+// than `cullRadius` from the shadow axis are outside the penumbra.
+struct ShadowStep {
+    float sunX, sunY, sunZ;
+    float moonX, moonY, moonZ;
+    float axisX, axisY, axisZ;      // unit, Sun towards Moon
+    float sunRadius;
+    float moonRadius;
+    float cullRadius;
+    float spinCos;
+    float spinSin;
+};
+
+// Unit surface points in the Earth's body frame, and the greatest value over
+// the steps of each output.
+struct ShadowRasterView {
+    const float* x;
+    const float* y;
+    const float* z;
+    float* obscuration;     // fraction of the Sun's disk covered
+    float* magnitude;       // fraction of its diameter; Moon/Sun ratio when central
+    float* central;         // 1 inside the umbra or antumbra
+};
+
+void shadeShadowScalar(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount, size_t begin, size_t end);
+void shadeShadowAvx2(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount, size_t begin, size_t end);
+void shadeShadowAvx512(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount, size_t begin, size_t end);
+
+// acos on [-1, 1] from Abramowitz & Stegun 4.4.46, error below 2e-8 before
+// rounding to float.
+template <typename S>
+inline typename S::F simdAcos(typename S::F x) {
+    using F = typename S::F;
+    const F a = S::abs(x);
+    F p = S::fmadd(a, S::set1(-0.0012624911f), S::set1(0.0066700901f));
+    p = S::fmadd(a, p, S::set1(-0.0170881256f));
+    p = S::fmadd(a, p, S::set1(0.0308918810f));
+    p = S::fmadd(a, p, S::set1(-0.0501743046f));
+    p = S::fmadd(a, p, S::set1(0.0889789874f));
+    p = S::fmadd(a, p, S::set1(-0.2145988016f));
+    p = S::fmadd(a, p, S::set1(1.5707963050f));
+    p = S::mul(p, S::sqrt(S::sub(S::set1(1.0f), a)));
+    return S::select(S::cmpLt(x, S::set1(0.0f)), S::sub(S::set1(3.14159265f), p), p);
+}
+
+template <typename S>
+inline void shadowKernel(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount,
+    size_t begin, size_t end) {
+    using F = typename S::F;
+    const F zero = S::set1(0.0f);
+    const F one = S::set1(1.0f);
+    const F invPi = S::set1(0.318309886f);
+
+    size_t i = begin;
+    for (; i + S::width <= end; i += S::width) {
+        const F lx = S::loadu(v.x + i), ly = S::loadu(v.y + i), lz = S::loadu(v.z + i);
+        F obscuration = zero, magnitude = zero, central = zero;
+
+        for (size_t k = 0; k < stepCount; ++k) {
+            const ShadowStep& step = steps[k];
+            const F c = S::set1(step.spinCos), s = S::set1(step.spinSin);
+            const F nx = S::fmadd(lx, c, S::mul(lz, s));
+            const F nz = S::fnmadd(lx, s, S::mul(lz, c));
+
+            // Most of the globe is outside the penumbra: skip whole vectors
+            // that are farther from the shadow axis than its widest radius.
+            const F qx = S::sub(nx, S::set1(step.moonX)), qy = S::sub(ly, S::set1(step.moonY));
+            const F qz = S::sub(nz, S::set1(step.moonZ));
+            const F along = S::fmadd(qz, S::set1(step.axisZ), S::fmadd(qy, S::set1(step.axisY),
+                S::mul(qx, S::set1(step.axisX))));
+            const F axisDistance2 = S::fnmadd(along, along, S::fmadd(qz, qz, S::fmadd(qy, qy, S::mul(qx, qx))));
+            if (!S::any(S::cmpLt(axisDistance2, S::set1(step.cullRadius * step.cullRadius))))
+                continue;
+
+            // Topocentric Sun and Moon.
+            const F sx = S::sub(S::set1(step.sunX), nx), sy = S::sub(S::set1(step.sunY), ly);
+            const F sz = S::sub(S::set1(step.sunZ), nz);
+            const F mx = S::neg(qx), my = S::neg(qy), mz = S::neg(qz);
+
+            const F sunDistance = S::sqrt(S::fmadd(sz, sz, S::fmadd(sy, sy, S::mul(sx, sx))));
+            const F moonDistance = S::sqrt(S::fmadd(mz, mz, S::fmadd(my, my, S::mul(mx, mx))));
+            const F cx = S::fnmadd(sz, my, S::mul(sy, mz));
+            const F cy = S::fnmadd(sx, mz, S::mul(sz, mx));
+            const F cz = S::fnmadd(sy, mx, S::mul(sx, my));
+            const F cross = S::sqrt(S::fmadd(cz, cz, S::fmadd(cy, cy, S::mul(cx, cx))));
+
+            // Apparent radii and separation are a few milliradians, where
+            // asin(x) and x agree to float precision.
+            const F rs = S::div(S::set1(step.sunRadius), sunDistance);
+            const F rm = S::div(S::set1(step.moonRadius), moonDistance);
+            const F d = S::max(S::div(cross, S::mul(sunDistance, moonDistance)), S::set1(1e-9f));
+
+            const F sunAltitude = S::fmadd(nz, sz, S::fmadd(ly, sy, S::mul(nx, sx)));
+            const F facing = S::fmadd(mz, sz, S::fmadd(my, sy, S::mul(mx, sx)));
+            const auto visible = S::maskAnd(S::cmpGt(sunAltitude, zero), S::cmpGt(facing, zero));
+            const auto overlapping = S::maskAnd(visible, S::cmpLt(d, S::add(rs, rm)));
+            const auto inside = S::maskAnd(visible, S::cmpLt(d, S::abs(S::sub(rs, rm))));
+
+            // Lens-shaped overlap of the two disks.
+            const F d2 = S::mul(d, d), rs2 = S::mul(rs, rs), rm2 = S::mul(rm, rm);
+            const F c1 = S::min(one, S::max(S::neg(one), S::div(S::add(d2, S::sub(rs2, rm2)), S::mul(S::add(d, d), rs))));
+            const F c2 = S::min(one, S::max(S::neg(one), S::div(S::add(d2, S::sub(rm2, rs2)), S::mul(S::add(d, d), rm))));
+            const F kite = S::mul(S::mul(S::sub(S::add(rs, rm), d), S::add(d, S::sub(rs, rm))),
+                S::mul(S::add(d, S::sub(rm, rs)), S::add(d, S::add(rs, rm))));
+            const F lens = S::fnmadd(S::set1(0.5f), S::sqrt(S::max(kite, zero)),
+                S::fmadd(rs2, simdAcos<S>(c1), S::mul(rm2, simdAcos<S>(c2))));
+
+            const F ratio = S::div(rm, rs);
+            F obscured = S::select(inside, S::min(one, S::mul(ratio, ratio)), S::mul(S::div(lens, rs2), invPi));
+            F covered = S::select(inside, ratio, S::div(S::sub(S::add(rs, rm), d), S::add(rs, rs)));
+            obscured = S::select(overlapping, obscured, zero);
+            covered = S::select(overlapping, covered, zero);
+
+            obscuration = S::max(obscuration, obscured);
+            magnitude = S::max(magnitude, covered);
+            central = S::select(inside, one, central);
+        }
+
+        S::storeu(v.obscuration + i, obscuration);
+        S::storeu(v.magnitude + i, magnitude);
+        S::storeu(v.central + i, central);
+    }
+
+    if (i < end)
+        shadeShadowScalar(v, steps, stepCount, i, end);
+}
+
+#endif
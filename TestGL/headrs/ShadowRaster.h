@@ -0,0 +1,74 @@
+#pragma once
+#ifndef SHADOW_RASTER_H
+#define SHADOW_RASTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AlignedAllocator.h"
+#include "EclipseSearch.h"
+#include "KeplerKernel.h"
+#include "ShadowKernel.h"
+
+class ThreadPool;
+
+struct ShadowLayer {
+    AlignedVector<float> obscuration;
+    AlignedVector<float> magnitude;
+    AlignedVector<float> central;
+};
+
+// Solar eclipse circumstances over the whole Earth, one point per texel of
+// an equirectangular raster laid out like the Sphere mesh's texture
+// coordinates, so the result can be drawn straight onto the Earth. `now`
+// holds the eclipse at one instant and `path` the greatest values over the
+// whole eclipse, which traces the ground track of the shadow.
+class ShadowRaster {
+public:
+    ShadowLayer now;
+    ShadowLayer path;
+
+    ShadowRaster();
+    explicit ShadowRaster(SimdLevel level);
+
+    SimdLevel level() const { return simdLevel; }
+
+    void resize(int width, int height);
+    int width() const { return rasterWidth; }
+    int height() const { return rasterHeight; }
+    size_t size() const { return pointX.size(); }
+
+    // The Earth's body frame is turned by `spinAngle` about +y at `time` and
+    // turns at `spinRate` radians per day. The path is sampled every
+    // `pathStep` days while the penumbra touches the Earth, and is only
+    // recomputed when `time` moves to another eclipse. Returns false, with
+    // every layer zero, when there is no eclipse at or around `time`.
+    bool compute(const EclipseModel& model, double time, double spinAngle, double spinRate, double pathStep,
+        ThreadPool& pool);
+
+    // Drops the cached path, for when the orbits or the spin change.
+    void invalidate();
+
+    // Point-steps evaluated by the last compute.
+    size_t evaluations() const { return lastEvaluations; }
+
+    // RGBA8 texels: obscuration now, obscuration along the path, central
+    // path, central now.
+    void packRGBA(uint8_t* pixels) const;
+
+private:
+    void shade(const ShadowStep* steps, size_t stepCount, ShadowLayer& layer, ThreadPool& pool);
+
+    int rasterWidth = 0;
+    int rasterHeight = 0;
+    AlignedVector<float> pointX, pointY, pointZ;
+    std::vector<ShadowStep> pathSteps;
+    long long pathFirst = 1;    // grid steps of the cached path, empty if first > last
+    long long pathLast = 0;
+    bool nowEclipsed = false;
+    SimdLevel simdLevel;
+    size_t lastEvaluations = 0;
+};
+
+#endif
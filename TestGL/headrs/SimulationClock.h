@@ -0,0 +1,41 @@
+#pragma once
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+#include <cstdint>
+
+// Decouples simulation from rendering: each rendered frame adds scaled real
+// time to an accumulator which is drained in fixed-size substeps, so the
+// simulation sees the same sequence of states at any frame rate. The
+// leftover fraction of a step is exposed for render interpolation.
+//
+// Simulation time is a Julian date kept as an epoch plus an integer step
+// count, so it is exact after any number of steps and seeking is O(1).
+class SimulationClock {
+public:
+    double step;
+    int maxSubsteps;
+    unsigned long long stepCount = 0;
+    double droppedTime = 0.0;
+
+    SimulationClock(double epoch, double step = 1.0 / 24.0, int maxSubsteps = 64);
+
+    double time() const { return epoch + static_cast<double>(tick) * step; }
+    void seek(double julianDate);
+    void advanceStep() { ++tick; }
+
+    // Returns how many fixed substeps to run for this frame. Anything past
+    // maxSubsteps is dropped so a slow frame cannot snowball into slower ones.
+    int beginFrame(double realDelta, double timeScale);
+    void discardAccumulated() { accumulator = 0.0; }
+
+    // Fraction of a step between the previous and current state, in [0, 1).
+    float alpha() const { return static_cast<float>(accumulator / step); }
+
+private:
+    double epoch;
+    int64_t tick = 0;
+    double accumulator = 0.0;
+};
+
+#endif
@@ -4,6 +4,8 @@
 
 #include <glad/glad.h>
 
+#include "RenderQueue.h"
+
 class Skybox {
 public:
     unsigned int VAO, VBO;
@@ -12,6 +14,8 @@ public:
     Skybox();
     ~Skybox();
     void Draw();
+    // The cube only; the texture is left to the caller.
+    DrawGeometry geometry() const;
     void loadTexture(const char* path);
 
 private:
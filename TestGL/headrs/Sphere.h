@@ -6,20 +6,73 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include "RenderQueue.h"
+#include "SphereMesh.h"
+
+const size_t MAX_SPHERE_LODS = 8;
+
+// One tessellation in a sphere's LOD chain. Every level indexes the same
+// vertex and element buffers.
+struct SphereLod {
+    int detail = 0;             // as buildCompactSphere takes it; sectors for the float UV sphere
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    float error = 0.0f;         // largest gap between the mesh and the true surface, per unit of radius
+};
+
+// How far a level may stray from the true sphere on screen before a finer
+// one is drawn. A level only gives way to a coarser one once the coarser
+// level's error is `hysteresis` below the budget, so a body sitting on a
+// threshold does not flicker between two levels.
+struct SphereLodSettings {
+    float pixelError = 0.5f;
+    float hysteresis = 0.25f;
+};
+
 class Sphere {
 public:
     unsigned int VAO, VBO, EBO;
-    unsigned int indexCount;
+    unsigned int indexCount;        // of the finest level, which Draw() and geometry() use
+    GLenum indexType = GL_UNSIGNED_INT;
+    bool compact = false;           // CompactSphereVertex vertices, which shaders decode
+    std::vector<SphereLod> lods;    // finest first
+    size_t vertexBytes = 0;         // sizes of the GPU buffers; no copy of the geometry stays on the CPU
+    size_t indexBytes = 0;
 
     Sphere(float radius = 1.0f, int sectors = 36, int stacks = 18);
+    // A LOD chain with one level per entry of `lodSectors`, finest first,
+    // each with half as many stacks as sectors.
+    Sphere(float radius, const std::vector<int>& lodSectors);
+    // A unit sphere in the compact format with 16-bit indices, one level per
+    // entry of `lodDetail`, finest first. Every level shares one buffer, so
+    // together they must stay within 65536 vertices.
+    Sphere(SphereTopology topology, const std::vector<int>& lodDetail);
     ~Sphere();
     void Draw();
+    DrawGeometry geometry() const;
+    size_t gpuBytes() const { return vertexBytes + indexBytes; }
 
 private:
-    void generateSphere(float radius, int sectors, int stacks);
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    void createBuffers(const void* vertexData, size_t vertexSize, const void* indexData, size_t indexSize);
+    void generateSphere(float radius, int sectors, int stacks, std::vector<float>& vertices,
+        std::vector<unsigned int>& indices);
 };
 
+// Set up the bound vertex array to read the sphere's vertices at locations 0
+// to 2 (position, normal, texture coordinates) and its element buffer. A
+// compact sphere feeds the octahedral normal to location 1 and the packed
+// texture coordinates to location 2, and leaves location 0 off.
+void bindSphereVertices(const Sphere& sphere);
+
+// Radius in pixels of a sphere `distance` away from the eye, for a
+// projection whose focal length is `focalPixels` (projection[1][1] times
+// half the viewport height). Infinite when the eye is inside.
+float projectedSphereRadius(float focalPixels, float distance, float radius);
+
+// The coarsest level whose error on screen stays within the budget, given
+// the level chosen last time (-1 for none).
+int selectSphereLod(const std::vector<SphereLod>& lods, float screenRadius, int previous,
+    const SphereLodSettings& settings);
+
 #endif
 
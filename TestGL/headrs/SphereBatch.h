@@ -0,0 +1,72 @@
+#pragma once
+#ifndef SPHERE_BATCH_H
+#define SPHERE_BATCH_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Sphere.h"
+#include "StreamBuffer.h"
+
+// One sphere drawn by a SphereBatch. The model matrix carries the radius as
+// a uniform scale, so the normal matrix is just its rotation.
+struct SphereInstance {
+    glm::mat4 model;
+    glm::vec4 color;
+    glm::ivec4 flags;       // x = object type, y = OBJECT_* bits, z = occluders to skip, w = texture layers
+};
+
+static_assert(sizeof(SphereInstance) == 96, "SphereInstance is read as tightly packed vertex attributes");
+
+// SphereInstance::flags.w: the day, night and cloud layers of the body
+// texture array, 8 bits each. A missing layer (-1) packs as 0; the matching
+// OBJECT_USE_* bit says whether the shader samples it.
+inline int packTextureLayers(int diffuse, int night, int clouds) {
+    return (std::max(diffuse, 0) & 0xFF) | (std::max(night, 0) & 0xFF) << 8 | (std::max(clouds, 0) & 0xFF) << 16;
+}
+
+// Set up the bound vertex array for instanced spheres: locations 3 to 8 from
+// SphereInstances starting `offset` bytes into `buffer`. The mesh's own
+// attributes come from bindSphereVertices.
+void bindSphereInstances(unsigned int buffer, size_t offset);
+
+// Draws any number of spheres from one level of a unit-sphere mesh with
+// instanced draws. The batch owns a vertex array that reads the mesh's
+// vertex and index buffers plus per-instance data, streamed through a
+// StreamBuffer, at attribute locations 3 to 8.
+class SphereBatch {
+public:
+    explicit SphereBatch(const Sphere& unitSphere, bool allowPersistent = true, size_t lod = 0);
+    ~SphereBatch();
+
+    // Replaces the instance data. beginUpload() returns write-only memory
+    // for `count` instances to be filled in place; endUpload() publishes it.
+    // Call them after the draws that read the previous upload are issued.
+    SphereInstance* beginUpload(size_t count);
+    void endUpload();
+    void upload(const SphereInstance* instances, size_t count);
+    // Draws instances [first, first + count) of the last upload.
+    void draw(size_t first, size_t count);
+    // Every instance of the last upload, for the render queue.
+    DrawGeometry geometry() const;
+
+    size_t size() const { return instanceCount; }
+    const StreamBuffer& stream() const { return instanceStream; }
+
+private:
+    void pointInstanceAttributes(size_t first);
+
+    StreamBuffer instanceStream;
+    unsigned int VAO = 0;
+    unsigned int indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    size_t indexOffset = 0;
+    size_t instanceCount = 0;
+    size_t dataOffset = 0;          // of the last upload in the stream
+    size_t attributeBase = SIZE_MAX;    // byte offset the attribute pointers start at
+};
+
+#endif
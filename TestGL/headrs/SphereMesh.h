@@ -0,0 +1,66 @@
+#pragma once
+#ifndef SPHERE_MESH_H
+#define SPHERE_MESH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SphereTopology {
+    UV_SPHERE,      // sectors by stacks; crowds its triangles at the poles
+    ICOSPHERE,      // a subdivided icosahedron
+    CUBE_SPHERE,    // a subdivided cube pushed out onto the sphere
+};
+
+// A vertex of a unit sphere in 8 bytes, against the 32 of Sphere's float
+// vertices. On a unit sphere the position is the normal, so only the normal
+// is kept, octahedral-encoded; the vertex shader scales it by the radius.
+struct CompactSphereVertex {
+    int16_t normal[2];          // octahedral, snorm16
+    uint16_t texCoord[2];       // unorm16, u halved so that copies on the texture seam can run past 1
+};
+
+static_assert(sizeof(CompactSphereVertex) == 8, "CompactSphereVertex is read as two attributes of 4 bytes");
+
+struct CompactSphereMesh {
+    std::vector<CompactSphereVertex> vertices;
+    std::vector<uint16_t> indices;
+    float error = 0.0f;         // largest gap between the mesh and the true surface, per unit of radius
+};
+
+// A unit sphere with Sphere's texture mapping: u runs around the z axis from
+// +x, v from +z down to -z. `detail` is the sectors of a UV sphere (with
+// half as many stacks), the subdivisions of an icosphere (each one
+// quadruples the triangles), or the cells along each cube face edge,
+// rounded up to even so that a vertex sits on each pole. Triangles come in
+// vertex cache order and vertices in the order the triangles first use them.
+CompactSphereMesh buildCompactSphere(SphereTopology topology, int detail);
+
+// Reorders triangles so that vertices are reused while a post-transform
+// cache still holds them (Forsyth's linear-speed optimizer).
+void optimizeVertexCache(std::vector<uint16_t>& indices, size_t vertexCount);
+
+// Average cache miss ratio: vertices transformed per triangle by a FIFO
+// cache of `cacheSize` entries. 3 is the worst; a closed mesh in a perfect
+// order approaches 0.5.
+template <typename Index>
+float averageCacheMissRatio(const Index* indices, size_t count, size_t cacheSize) {
+    if (count < 3)
+        return 0.0f;
+    size_t vertexCount = 0;
+    for (size_t i = 0; i < count; ++i)
+        vertexCount = std::max(vertexCount, static_cast<size_t>(indices[i]) + 1);
+    // The cache holds the last `cacheSize` misses, so a vertex is still in it
+    // if fewer than that many misses came after its own.
+    std::vector<size_t> missedAt(vertexCount, SIZE_MAX);
+    size_t misses = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t& at = missedAt[indices[i]];
+        if (at == SIZE_MAX || misses - at >= cacheSize)
+            at = misses++;
+    }
+    return static_cast<float>(misses) / static_cast<float>(count / 3);
+}
+
+#endif
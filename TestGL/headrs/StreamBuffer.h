@@ -0,0 +1,48 @@
+#pragma once
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// A buffer for data rewritten every time it changes, such as per-frame
+// instance transforms. With GL 4.4 buffer storage it is three regions of one
+// persistently mapped buffer: each write goes to the next region, after a
+// fence shows the GPU has finished reading it, so writers never wait on the
+// driver. Without buffer storage each write orphans the buffer and maps the
+// fresh storage instead.
+//
+// Data written between begin() and end() stays valid until the next begin().
+class StreamBuffer {
+public:
+    static const int REGIONS = 3;
+
+    unsigned int id = 0;
+    bool persistent = false;
+    size_t regionSize = 0;
+    unsigned int stalls = 0;        // begin() calls that found their region still in use
+
+    // `allowPersistent` false forces the orphaning path.
+    explicit StreamBuffer(GLenum target, bool allowPersistent = true);
+    ~StreamBuffer();
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Returns memory for `size` bytes. Fences the region written last, so
+    // call it after the draws that read the previous data have been issued.
+    void* begin(size_t size);
+    // Publishes what was written since begin(). Returns the byte offset in
+    // the buffer that draws should read from.
+    size_t end();
+
+private:
+    void allocate(size_t size);
+    void release();
+
+    GLenum target;
+    char* mapped = nullptr;         // the whole buffer, when persistent
+    int region = 0;
+    GLsync fences[REGIONS] = {};
+};
+
+#endif
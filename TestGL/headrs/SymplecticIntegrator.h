@@ -0,0 +1,60 @@
+#pragma once
+#ifndef SYMPLECTIC_INTEGRATOR_H
+#define SYMPLECTIC_INTEGRATOR_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+#include "AlignedAllocator.h"
+#include "KeplerKernel.h"
+
+enum class SymplecticScheme {
+    Leapfrog,       // 2nd order, one force evaluation per step
+    Yoshida4        // 4th order, three force evaluations per step
+};
+
+// Direct-summation gravity for small systems such as the major planets,
+// where a tree code costs more than it saves. State is double precision in
+// structure-of-arrays form. The pairwise loop is tiled so both tiles stay in
+// L1, and the tile kernel runs SIMD lanes over the receiving bodies with the
+// same runtime ISA dispatch as the Kepler propagator. Both schemes are
+// symplectic, so the energy error stays bounded instead of drifting.
+class SymplecticIntegrator {
+public:
+    SymplecticScheme scheme = SymplecticScheme::Yoshida4;
+    double gravitationalConstant = 1.0;
+
+    AlignedVector<double> posX, posY, posZ;
+    AlignedVector<double> velX, velY, velZ;
+    AlignedVector<double> accX, accY, accZ;
+    AlignedVector<double> mass;
+
+    SymplecticIntegrator();
+    explicit SymplecticIntegrator(SimdLevel level);
+
+    SimdLevel level() const { return simdLevel; }
+
+    size_t addBody(const glm::dvec3& position, const glm::dvec3& velocity, double bodyMass);
+    void reserve(size_t count);
+    void clear();
+    size_t size() const { return mass.size(); }
+
+    glm::dvec3 position(size_t index) const { return glm::dvec3(posX[index], posY[index], posZ[index]); }
+    glm::dvec3 velocity(size_t index) const { return glm::dvec3(velX[index], velY[index], velZ[index]); }
+
+    // Removes the centre-of-mass motion so the system does not drift.
+    void moveToBarycentricFrame();
+
+    void step(double dt);
+    void computeAccelerations();
+    double energy() const;
+
+private:
+    void drift(double dt);
+    void kick(double dt);
+
+    SimdLevel simdLevel;
+    bool accelerationValid = false;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <vector>
+
+// Images packed as the layers of one GL_TEXTURE_2D_ARRAY, so draws that
+// sample different images can share a texture binding and a draw call. All
+// layers have one size; images of another size are resampled on the GPU.
+class TextureArray {
+public:
+    unsigned int ID = 0;
+    int width = 0;
+    int height = 0;
+
+    // Creates one width x height layer per path, in order, with mipmaps.
+    // Returns the number of images that loaded; the others leave their
+    // layer empty and layer() reports -1 for them.
+    int load(const std::vector<const char*>& paths, int layerWidth, int layerHeight, bool flipVertically = true);
+
+    // The layer image `index` went to, or -1 if it failed to load.
+    int layer(int index) const;
+    int layerCount() const { return static_cast<int>(loaded.size()); }
+
+private:
+    void copyToLayer(const unsigned char* pixels, int imageWidth, int imageHeight, int layerIndex);
+
+    std::vector<bool> loaded;
+};
+
+#endif
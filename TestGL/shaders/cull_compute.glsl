@@ -0,0 +1,130 @@
+#version 430 core
+// Tests every SphereInstance against the frustum and the depth pyramid,
+// picks a level of the sphere's LOD chain for each survivor, and counts it
+// into that level's indirect draw command. cull_scatter_compute.glsl then
+// copies the survivors into a compact list grouped by level.
+layout(local_size_x = 64) in;
+
+// SphereInstance in SphereBatch.h.
+struct SphereInstance {
+    mat4 model;
+    vec4 color;
+    ivec4 flags;
+};
+
+layout(std430, binding = 0) readonly buffer Instances {
+    SphereInstance instances[];
+};
+// DrawElementsIndirectCommand, one per level; instanceCount is zeroed before
+// the dispatch.
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 2) buffer Commands {
+    DrawCommand commands[];
+};
+// Per instance: x = the level it was last drawn at, kept while it is culled
+// for the hysteresis, ~0 for none; y = this frame's level << 24 | its slot
+// among that level's survivors, ~0 when culled.
+layout(std430, binding = 3) buffer Lods {
+    uvec2 lodState[];
+};
+
+// Mirrored by CullBlock in ShaderBlocks.h.
+layout(std140) uniform Cull {
+    mat4 view;
+    mat4 projection;
+    vec4 planes[6];
+    vec4 hiz;
+    ivec4 counts;
+    vec4 lod;
+    vec4 lodErrors[2];
+} cull;
+
+// Where this dispatch's range starts; large counts take several dispatches.
+uniform int firstInstance;
+
+// Farthest depth of each texel's footprint, one mip level per halving.
+uniform sampler2D depthPyramid;
+
+bool inFrustum(vec3 centre, float radius) {
+    for (int i = 0; i < 6; ++i) {
+        if (dot(cull.planes[i].xyz, centre) + cull.planes[i].w < -radius)
+            return false;
+    }
+    return true;
+}
+
+// The sphere's screen rectangle is bounded by the tangents to it from the
+// eye, and is checked at the pyramid level where it covers at most 2x2
+// texels. Spheres reaching the near plane are never occluded.
+bool occluded(vec3 centre, float radius) {
+    vec3 c = (cull.view * vec4(centre, 1.0)).xyz;
+    float depth = -c.z;
+    if (depth - radius < cull.hiz.w)
+        return false;
+
+    float r2 = radius * radius;
+    float lx = sqrt(c.x * c.x + depth * depth - r2);
+    float ly = sqrt(c.y * c.y + depth * depth - r2);
+    vec4 rect = vec4(
+        (c.x * lx - depth * radius) / (c.x * radius + depth * lx) * cull.projection[0][0],
+        (c.y * ly - depth * radius) / (c.y * radius + depth * ly) * cull.projection[1][1],
+        (c.x * lx + depth * radius) / (depth * lx - c.x * radius) * cull.projection[0][0],
+        (c.y * ly + depth * radius) / (depth * ly - c.y * radius) * cull.projection[1][1]);
+    rect = clamp(rect * 0.5 + 0.5, 0.0, 1.0);
+
+    vec2 size = (rect.zw - rect.xy) * cull.hiz.xy;
+    // Level 0 holds single samples, not footprints, so start one level up.
+    float level = clamp(ceil(log2(max(max(size.x, size.y), 1.0))), 1.0, cull.hiz.z - 1.0);
+    float farthest = max(
+        max(textureLod(depthPyramid, rect.xy, level).r, textureLod(depthPyramid, rect.zy, level).r),
+        max(textureLod(depthPyramid, rect.xw, level).r, textureLod(depthPyramid, rect.zw, level).r));
+
+    vec4 nearest = cull.projection * vec4(0.0, 0.0, radius - depth, 1.0);
+    return nearest.z / nearest.w * 0.5 + 0.5 > farthest;
+}
+
+// selectSphereLod in Sphere.cpp.
+int coarsestWithin(float screenRadius, float pixelError) {
+    for (int level = cull.counts.z - 1; level > 0; --level) {
+        if (cull.lodErrors[level / 4][level % 4] * screenRadius <= pixelError)
+            return level;
+    }
+    return 0;
+}
+
+int selectLod(vec3 centre, float radius, int previous) {
+    float distance = length((cull.view * vec4(centre, 1.0)).xyz);
+    float tangent2 = distance * distance - radius * radius;
+    if (tangent2 <= 0.0)
+        return 0;
+    float screenRadius = cull.lod.x * radius / sqrt(tangent2);
+    int wanted = coarsestWithin(screenRadius, cull.lod.y);
+    if (previous < 0 || previous >= cull.counts.z || wanted <= previous)
+        return wanted;
+    return max(previous, coarsestWithin(screenRadius, cull.lod.y * (1.0 - cull.lod.z)));
+}
+
+void main() {
+    uint i = uint(firstInstance) + gl_GlobalInvocationID.x;
+    if (i >= uint(cull.counts.x))
+        return;
+
+    mat4 model = instances[i].model;
+    vec3 centre = model[3].xyz;
+    float radius = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    if (!inFrustum(centre, radius) || (cull.counts.y != 0 && occluded(centre, radius))) {
+        lodState[i].y = ~0u;
+        return;
+    }
+
+    int level = selectLod(centre, radius, int(lodState[i].x));
+    uint slot = atomicAdd(commands[level].instanceCount, 1u);
+    lodState[i] = uvec2(uint(level), uint(level) << 24 | slot);
+}
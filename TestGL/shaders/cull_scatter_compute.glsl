@@ -0,0 +1,70 @@
+#version 430 core
+// Second half of the GPU cull: with every level's survivors counted, places
+// each level's run after the ones before it, sets the commands' baseInstance
+// to match, and copies the survivors into their slots.
+layout(local_size_x = 64) in;
+
+// SphereInstance in SphereBatch.h.
+struct SphereInstance {
+    mat4 model;
+    vec4 color;
+    ivec4 flags;
+};
+
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Instances {
+    SphereInstance instances[];
+};
+layout(std430, binding = 1) writeonly buffer Visible {
+    SphereInstance visible[];
+};
+layout(std430, binding = 2) buffer Commands {
+    DrawCommand commands[];
+};
+// Written by cull_compute.glsl.
+layout(std430, binding = 3) readonly buffer Lods {
+    uvec2 lodState[];
+};
+
+// Mirrored by CullBlock in ShaderBlocks.h.
+layout(std140) uniform Cull {
+    mat4 view;
+    mat4 projection;
+    vec4 planes[6];
+    vec4 hiz;
+    ivec4 counts;
+    vec4 lod;
+    vec4 lodErrors[2];
+} cull;
+
+// Where this dispatch's range starts; large counts take several dispatches.
+uniform int firstInstance;
+
+void main() {
+    uint i = uint(firstInstance) + gl_GlobalInvocationID.x;
+    if (i == 0u) {
+        uint base = 0u;
+        for (int level = 0; level < cull.counts.z; ++level) {
+            commands[level].baseInstance = base;
+            base += commands[level].instanceCount;
+        }
+    }
+    if (i >= uint(cull.counts.x))
+        return;
+
+    uint placed = lodState[i].y;
+    if (placed == ~0u)
+        return;
+    uint level = placed >> 24;
+    uint base = 0u;
+    for (uint l = 0u; l < level; ++l)
+        base += commands[l].instanceCount;
+    visible[base + (placed & 0xFFFFFFu)] = instances[i];
+}
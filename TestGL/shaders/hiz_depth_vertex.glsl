@@ -0,0 +1,45 @@
+#version 430 core
+// Draws occluding spheres into level 0 of the depth pyramid.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 3) in mat4 aModel;
+
+// Mirrored by CullBlock in ShaderBlocks.h.
+layout(std140) uniform Cull {
+    mat4 view;
+    mat4 projection;
+    vec4 planes[6];
+    vec4 hiz;
+    ivec4 counts;
+    vec4 lod;
+    vec4 lodErrors[2];
+} cull;
+
+// The sphere's vertices are CompactSphereVertex (SphereMesh.h).
+uniform bool compactVertices;
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    vec3 position = compactVertices ? octahedralDecode(aNormal.xy) : aPos;
+    vec3 centre = aModel[3].xyz;
+    float radius = length(aModel[0].xyz);
+    float distance = -(cull.view * vec4(centre, 1.0)).z;
+    // The near plane would clip an occluder it cuts open; leave it out.
+    if (distance - radius < cull.hiz.w) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    // Pull the silhouette in by a pyramid texel, so that texels the sphere
+    // only partly covers stay at the far plane.
+    float texel = 2.0 * distance / (cull.hiz.x * cull.projection[0][0]);
+    float shrink = max(radius - texel, 0.0) / radius;
+
+    vec3 worldPos = centre + (mat3(aModel) * position) * shrink;
+    gl_Position = cull.projection * cull.view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 430 core
+// Builds one level of the depth pyramid from the level below: each texel
+// keeps the farthest of the four it covers. Reads past the edge of an odd
+// level return 0, which never wins.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r32f, binding = 0) readonly uniform image2D source;
+layout(r32f, binding = 1) writeonly uniform image2D destination;
+
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, imageSize(destination))))
+        return;
+    ivec2 base = texel * 2;
+    float farthest = max(
+        max(imageLoad(source, base).r, imageLoad(source, base + ivec2(1, 0)).r),
+        max(imageLoad(source, base + ivec2(0, 1)).r, imageLoad(source, base + ivec2(1, 1)).r));
+    imageStore(destination, texel, vec4(farthest));
+}
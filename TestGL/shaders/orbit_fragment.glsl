@@ -1,9 +1,14 @@
 #version 330 core
 out vec4 FragColor;
 
-uniform vec3 orbitColor;
+// Per-object data, mirrored by ObjectBlock in ShaderBlocks.h.
+layout(std140) uniform Object {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 color;
+    ivec4 flags;
+} object;
 
 void main() {
-    FragColor = vec4(orbitColor, 0.6);  // Semi-transparent white
+    FragColor = vec4(object.color.rgb, 0.6);  // Semi-transparent white
 }
-
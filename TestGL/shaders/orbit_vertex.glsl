@@ -1,11 +1,28 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame data, mirrored by FrameBlock in ShaderBlocks.h.
+const int MAX_OCCLUDERS = 16;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 sunPos;
+    vec4 sunLight;
+    vec4 moonPos;
+    vec4 moonLight;
+    vec4 occluders[MAX_OCCLUDERS];
+    ivec4 occluderCount;
+} frame;
+
+// Per-object data, mirrored by ObjectBlock in ShaderBlocks.h.
+layout(std140) uniform Object {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 color;
+    ivec4 flags;
+} object;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = frame.projection * frame.view * object.model * vec4(aPos, 1.0);
 }
-
@@ -3,12 +3,23 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+// Per-frame data, mirrored by FrameBlock in ShaderBlocks.h.
+const int MAX_OCCLUDERS = 16;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 sunPos;
+    vec4 sunLight;
+    vec4 moonPos;
+    vec4 moonLight;
+    vec4 occluders[MAX_OCCLUDERS];
+    ivec4 occluderCount;
+} frame;
 
 void main() {
     TexCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    // Rotation only, so the sky stays at infinity.
+    vec4 pos = frame.projection * mat4(mat3(frame.view)) * vec4(aPos, 1.0);
     gl_Position = pos.xyww;
 }
-
@@ -4,40 +4,107 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+in vec4 ObjectColor;
+// x = object type (0 = Sun, 1 = planet, 2 = Moon), y = the OBJECT_* bits
+// below, z = occluders to skip (the body itself, or a shadow the raster
+// already shows), w = day, night and cloud layers of bodyTextures, 8 bits each
+flat in ivec4 ObjectFlags;
 
-uniform vec3 objectColor;
-uniform vec3 viewPos;
+// Per-frame data, mirrored by FrameBlock in ShaderBlocks.h.
+const int MAX_OCCLUDERS = 16;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 sunPos;        // w = radius
+    vec4 sunLight;      // rgb = colour, a = intensity
+    vec4 moonPos;
+    vec4 moonLight;     // rgb = colour, a = intensity
+    // Spheres that can hide the Sun: xyz = centre, w = radius
+    vec4 occluders[MAX_OCCLUDERS];
+    ivec4 occluderCount;
+} frame;
 
-// Textures
-uniform sampler2D diffuseTexture;
-uniform sampler2D nightTexture;
-uniform sampler2D cloudsTexture;
-uniform bool useTexture;
-uniform bool useNightTexture;
-uniform bool useCloudsTexture;
+// Bits of ObjectFlags.y, OBJECT_* in ShaderBlocks.h.
+const int OBJECT_USE_TEXTURE = 1;
+const int OBJECT_USE_NIGHT_TEXTURE = 2;
+const int OBJECT_USE_CLOUDS_TEXTURE = 4;
+const int OBJECT_USE_SHADOW_TEXTURE = 8;
+const int OBJECT_IS_MOON = 16;
 
-// Sun light
-uniform vec3 sunPos;
-uniform vec3 sunColor;
-uniform float sunIntensity;
+// Every body's maps, one layer each (TextureArray.h)
+uniform sampler2DArray bodyTextures;
 
-// Moon light
-uniform vec3 moonPos;
-uniform vec3 moonColor;
-uniform float moonIntensity;
-uniform bool isMoon;
+// Solar eclipse raster: r = obscuration now, g = obscuration along the path,
+// b = central path, a = inside the umbra or antumbra now
+uniform sampler2D shadowTexture;
 
-// Object type: 0 = Sun, 1 = Earth, 2 = Moon
-uniform int objectType;
+// Fraction of a disk of angular radius rs covered by one of radius ro whose
+// centre is d away (all in radians).
+float diskCoverage(float rs, float ro, float d) {
+    if (d >= rs + ro)
+        return 0.0;
+    if (d <= abs(rs - ro))
+        return min(ro * ro / (rs * rs), 1.0);
+    float c1 = clamp((d * d + rs * rs - ro * ro) / (2.0 * d * rs), -1.0, 1.0);
+    float c2 = clamp((d * d + ro * ro - rs * rs) / (2.0 * d * ro), -1.0, 1.0);
+    float kite = (rs + ro - d) * (d + rs - ro) * (d - rs + ro) * (d + rs + ro);
+    float lens = rs * rs * acos(c1) + ro * ro * acos(c2) - 0.5 * sqrt(max(kite, 0.0));
+    return lens / (3.14159265 * rs * rs);
+}
+
+// Share of the Sun's disk visible from p, the same disk test as the eclipse
+// raster. Occluders rarely overlap each other, so their shadows multiply.
+float sunVisibility(vec3 p) {
+    vec3 toSun = frame.sunPos.xyz - p;
+    float sunDist = length(toSun);
+    vec3 sunDir = toSun / sunDist;
+    float rs = asin(min(frame.sunPos.w / sunDist, 1.0));
+
+    float visible = 1.0;
+    for (int i = 0; i < frame.occluderCount.x; ++i) {
+        if ((ObjectFlags.z & (1 << i)) != 0)
+            continue;
+        vec3 toOccluder = frame.occluders[i].xyz - p;
+        float occluderDist = length(toOccluder);
+        if (occluderDist >= sunDist || dot(toOccluder, sunDir) <= 0.0)
+            continue;
+        vec3 occluderDir = toOccluder / occluderDist;
+        float ro = asin(min(frame.occluders[i].w / occluderDist, 1.0));
+        // Separation from the chord, which keeps its precision near zero.
+        float d = 2.0 * asin(min(0.5 * length(occluderDir - sunDir), 1.0));
+        visible *= 1.0 - diskCoverage(rs, ro, d);
+    }
+    return visible;
+}
+
+vec3 bodyTexture(int shift) {
+    return texture(bodyTextures, vec3(TexCoord, float((ObjectFlags.w >> shift) & 0xFF))).rgb;
+}
 
 void main() {
+    vec3 objectColor = ObjectColor.rgb;
+    int objectType = ObjectFlags.x;
+    bool useTexture = (ObjectFlags.y & OBJECT_USE_TEXTURE) != 0;
+    bool useNightTexture = (ObjectFlags.y & OBJECT_USE_NIGHT_TEXTURE) != 0;
+    bool useCloudsTexture = (ObjectFlags.y & OBJECT_USE_CLOUDS_TEXTURE) != 0;
+    bool useShadowTexture = (ObjectFlags.y & OBJECT_USE_SHADOW_TEXTURE) != 0;
+    bool isMoon = (ObjectFlags.y & OBJECT_IS_MOON) != 0;
+    vec3 viewPos = frame.viewPos.xyz;
+    vec3 sunPos = frame.sunPos.xyz;
+    vec3 sunColor = frame.sunLight.rgb;
+    float sunIntensity = frame.sunLight.a;
+    vec3 moonPos = frame.moonPos.xyz;
+    vec3 moonColor = frame.moonLight.rgb;
+    float moonIntensity = frame.moonLight.a;
+
     vec3 color = objectColor;
     
     // Sun emits its own light
     if (objectType == 0) {
         vec3 sunGlow = vec3(1.0, 0.95, 0.8) * 2.0;
         if (useTexture) {
-            vec3 sunTex = texture(diffuseTexture, TexCoord).rgb;
+            vec3 sunTex = bodyTexture(0);
             sunGlow = sunTex * 2.5;
         }
         FragColor = vec4(sunGlow, 1.0);
@@ -50,45 +117,55 @@ void main() {
     // Get base color from texture or object color
     vec3 baseColor = objectColor;
     if (useTexture) {
-        baseColor = texture(diffuseTexture, TexCoord).rgb;
+        baseColor = bodyTexture(0);
     }
     
     // Sun lighting
     vec3 sunDir = normalize(sunPos - FragPos);
     float sunDist = length(sunPos - FragPos);
     float sunDiff = max(dot(norm, sunDir), 0.0);
+    float sunVisible = sunDiff > 0.0 ? sunVisibility(FragPos) : 1.0;
     
     // Ambient from sun
     float ambientStrength = 0.15;
     vec3 ambient = ambientStrength * sunColor * sunIntensity;
     
     // Diffuse from sun
-    vec3 sunDiffuse = sunDiff * sunColor * sunIntensity / (1.0 + sunDist * 0.01);
+    vec3 sunDiffuse = sunVisible * sunDiff * sunColor * sunIntensity / (1.0 + sunDist * 0.01);
     
     // Specular from sun
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 reflectDir = reflect(-sunDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 sunSpecular = 0.3 * spec * sunColor * sunIntensity;
+    vec3 sunSpecular = sunVisible * 0.3 * spec * sunColor * sunIntensity;
     
     result += (ambient + sunDiffuse + sunSpecular) * baseColor;
     
     // Add clouds texture for Earth
     if (useCloudsTexture && objectType == 1) {
-        vec3 clouds = texture(cloudsTexture, TexCoord).rgb;
+        vec3 clouds = bodyTexture(16);
         float cloudAlpha = clouds.r * 0.3;
         result = mix(result, clouds, cloudAlpha);
     }
     
     // Add night texture for Earth (dark side)
     if (useNightTexture && objectType == 1) {
-        float sunLight = max(dot(norm, sunDir), 0.0);
+        // Lights come on in an eclipse shadow as well as at night.
+        float sunLight = sunVisible * max(dot(norm, sunDir), 0.0);
         if (sunLight < 0.3) {
-            vec3 nightColor = texture(nightTexture, TexCoord).rgb;
+            vec3 nightColor = bodyTexture(8);
             result = mix(result, nightColor, (0.3 - sunLight) / 0.3);
         }
     }
     
+    // Moon's shadow: dim by the share of the Sun that is covered and trace the eclipse path
+    if (useShadowTexture && objectType == 1) {
+        vec4 shadow = texture(shadowTexture, TexCoord);
+        result *= 1.0 - 0.85 * shadow.r;
+        result = mix(result, vec3(1.0, 0.6, 0.2), 0.2 * shadow.g);
+        result = mix(result, vec3(1.0, 0.25, 0.1), 0.5 * shadow.b);
+    }
+    
     // Moon lighting (faint, only when sun is not visible)
     if (!isMoon && objectType == 1) { // Only Earth receives moon light
         vec3 moonDir = normalize(moonPos - FragPos);
@@ -113,7 +190,7 @@ void main() {
         // Moon glows faintly, more visible when not directly lit by sun
         vec3 moonGlow = vec3(0.9, 0.9, 0.95) * (0.2 + 0.1 * (1.0 - sunOnMoon));
         if (useTexture) {
-            vec3 moonTex = texture(diffuseTexture, TexCoord).rgb;
+            vec3 moonTex = bodyTexture(0);
             result = moonTex * (ambient + sunDiffuse) + moonGlow * 0.3;
         } else {
             result = baseColor * (ambient + sunDiffuse) + moonGlow;
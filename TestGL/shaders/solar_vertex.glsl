@@ -2,20 +2,52 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+// Per instance (SphereInstance in SphereBatch.h): the model matrix scales
+// the unit sphere uniformly, so its 3x3 part rotates normals correctly.
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec4 aColor;
+layout (location = 8) in ivec4 aFlags;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+out vec4 ObjectColor;
+flat out ivec4 ObjectFlags;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame data, mirrored by FrameBlock in ShaderBlocks.h.
+const int MAX_OCCLUDERS = 16;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 sunPos;
+    vec4 sunLight;
+    vec4 moonPos;
+    vec4 moonLight;
+    vec4 occluders[MAX_OCCLUDERS];
+    ivec4 occluderCount;
+} frame;
+
+// The sphere's vertices are CompactSphereVertex (SphereMesh.h): the
+// octahedral normal is the position on the unit sphere, and u is stored
+// halved.
+uniform bool compactVertices;
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoord = aTexCoord;
+    vec3 normal = compactVertices ? octahedralDecode(aNormal.xy) : aNormal;
+    vec3 position = compactVertices ? normal : aPos;
+    FragPos = vec3(aModel * vec4(position, 1.0));
+    Normal = mat3(aModel) * normal;
+    TexCoord = compactVertices ? aTexCoord * vec2(2.0, 1.0) : aTexCoord;
+    ObjectColor = aColor;
+    ObjectFlags = aFlags;
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = frame.projection * frame.view * vec4(FragPos, 1.0);
 }
-
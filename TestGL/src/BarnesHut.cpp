@@ -0,0 +1,480 @@
+#include "BarnesHut.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+
+const int MORTON_LEVELS = 16;      // bits per axis, so codes use 48 bits
+const int RADIX_BITS = 12;
+const uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+const int SUBTREE_LEVEL = 3;       // up to 512 independent subtrees
+
+uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+uint32_t octant(uint64_t code, int level) {
+    return static_cast<uint32_t>(code >> (3 * (MORTON_LEVELS - 1 - level))) & 7u;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct TreeInput {
+    const uint64_t* codes;
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* m;
+    uint32_t leafSize;
+    float rootSize;
+};
+
+bool isTerminal(const TreeInput& in, uint32_t begin, uint32_t end, int level) {
+    return end - begin <= in.leafSize || level == MORTON_LEVELS;
+}
+
+// Calls fn(childBegin, childEnd) for every non-empty octant of the range.
+template <typename Fn>
+void forEachChild(const TreeInput& in, uint32_t begin, uint32_t end, int level, Fn fn) {
+    uint32_t childBegin = begin;
+    for (uint32_t o = 0; o < 8 && childBegin < end; ++o) {
+        const uint64_t* first = in.codes + childBegin;
+        const uint64_t* last = in.codes + end;
+        uint32_t childEnd = static_cast<uint32_t>(
+            std::partition_point(first, last, [&](uint64_t c) { return octant(c, level) <= o; }) - in.codes);
+        if (childEnd > childBegin)
+            fn(childBegin, childEnd);
+        childBegin = childEnd;
+    }
+}
+
+OctreeNode makeNode(const TreeInput& in, uint32_t begin, uint32_t end, int level) {
+    OctreeNode node = {};
+    node.size = in.rootSize / static_cast<float>(1u << level);
+    node.begin = begin;
+    node.count = end - begin;
+    return node;
+}
+
+void finishNode(const TreeInput& in, std::vector<OctreeNode>& out, uint32_t index) {
+    OctreeNode& node = out[index];
+    node.next = static_cast<uint32_t>(out.size());
+
+    float m = 0.0f, cx = 0.0f, cy = 0.0f, cz = 0.0f;
+    if (node.leaf) {
+        for (uint32_t j = node.begin; j < node.begin + node.count; ++j) {
+            m += in.m[j];
+            cx += in.m[j] * in.x[j];
+            cy += in.m[j] * in.y[j];
+            cz += in.m[j] * in.z[j];
+        }
+    } else {
+        for (uint32_t c = index + 1; c < node.next; c = out[c].next) {
+            const OctreeNode& child = out[c];
+            m += child.mass;
+            cx += child.mass * child.comX;
+            cy += child.mass * child.comY;
+            cz += child.mass * child.comZ;
+        }
+    }
+
+    node.mass = m;
+    if (m > 0.0f) {
+        node.comX = cx / m;
+        node.comY = cy / m;
+        node.comZ = cz / m;
+    } else {
+        node.comX = in.x[node.begin];
+        node.comY = in.y[node.begin];
+        node.comZ = in.z[node.begin];
+    }
+}
+
+void buildSubtree(const TreeInput& in, std::vector<OctreeNode>& out, uint32_t begin, uint32_t end, int level) {
+    uint32_t index = static_cast<uint32_t>(out.size());
+    out.push_back(makeNode(in, begin, end, level));
+
+    if (isTerminal(in, begin, end, level)) {
+        out[index].leaf = 1;
+    } else {
+        forEachChild(in, begin, end, level, [&](uint32_t b, uint32_t e) {
+            buildSubtree(in, out, b, e, level + 1);
+        });
+    }
+    finishNode(in, out, index);
+}
+
+struct Subtree {
+    uint32_t begin, end;
+    int level;
+    std::vector<OctreeNode> nodes;
+};
+
+bool isSubtreeRoot(const TreeInput& in, uint32_t begin, uint32_t end, int level) {
+    return level == SUBTREE_LEVEL || isTerminal(in, begin, end, level);
+}
+
+void collectSubtrees(const TreeInput& in, std::vector<Subtree>& subtrees, uint32_t begin, uint32_t end, int level) {
+    if (isSubtreeRoot(in, begin, end, level)) {
+        subtrees.push_back({ begin, end, level, {} });
+        return;
+    }
+    forEachChild(in, begin, end, level, [&](uint32_t b, uint32_t e) {
+        collectSubtrees(in, subtrees, b, e, level + 1);
+    });
+}
+
+// Walks the same upper levels as collectSubtrees and splices each finished
+// subtree in, shifting its local `next` links to their global position.
+void assembleTree(const TreeInput& in, std::vector<OctreeNode>& out, std::vector<Subtree>& subtrees,
+    size_t& cursor, uint32_t begin, uint32_t end, int level) {
+    if (isSubtreeRoot(in, begin, end, level)) {
+        uint32_t offset = static_cast<uint32_t>(out.size());
+        for (OctreeNode node : subtrees[cursor++].nodes) {
+            node.next += offset;
+            out.push_back(node);
+        }
+        return;
+    }
+
+    uint32_t index = static_cast<uint32_t>(out.size());
+    out.push_back(makeNode(in, begin, end, level));
+    forEachChild(in, begin, end, level, [&](uint32_t b, uint32_t e) {
+        assembleTree(in, out, subtrees, cursor, b, e, level + 1);
+    });
+    finishNode(in, out, index);
+}
+
+}
+
+BarnesHutSimulation::BarnesHutSimulation(ThreadPool& pool) : pool(pool) {}
+
+uint32_t BarnesHutSimulation::addParticle(const glm::vec3& position, const glm::vec3& velocity, float particleMass) {
+    uint32_t index = static_cast<uint32_t>(size());
+    posX.push_back(position.x);
+    posY.push_back(position.y);
+    posZ.push_back(position.z);
+    velX.push_back(velocity.x);
+    velY.push_back(velocity.y);
+    velZ.push_back(velocity.z);
+    accX.push_back(0.0f);
+    accY.push_back(0.0f);
+    accZ.push_back(0.0f);
+    mass.push_back(particleMass);
+    id.push_back(index);
+    accelerationValid = false;
+    return index;
+}
+
+void BarnesHutSimulation::reserve(size_t count) {
+    posX.reserve(count);
+    posY.reserve(count);
+    posZ.reserve(count);
+    velX.reserve(count);
+    velY.reserve(count);
+    velZ.reserve(count);
+    accX.reserve(count);
+    accY.reserve(count);
+    accZ.reserve(count);
+    mass.reserve(count);
+    id.reserve(count);
+}
+
+void BarnesHutSimulation::clear() {
+    posX.clear();
+    posY.clear();
+    posZ.clear();
+    velX.clear();
+    velY.clear();
+    velZ.clear();
+    accX.clear();
+    accY.clear();
+    accZ.clear();
+    mass.clear();
+    id.clear();
+    nodes.clear();
+    accelerationValid = false;
+}
+
+void BarnesHutSimulation::step(float dt) {
+    if (!accelerationValid)
+        computeForces();
+
+    const float half = 0.5f * dt;
+    pool.parallelFor(size(), 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            velX[i] += accX[i] * half;
+            velY[i] += accY[i] * half;
+            velZ[i] += accZ[i] * half;
+            posX[i] += velX[i] * dt;
+            posY[i] += velY[i] * dt;
+            posZ[i] += velZ[i] * dt;
+        }
+    });
+
+    computeForces();
+
+    pool.parallelFor(size(), 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            velX[i] += accX[i] * half;
+            velY[i] += accY[i] * half;
+            velZ[i] += accZ[i] * half;
+        }
+    });
+}
+
+void BarnesHutSimulation::computeForces() {
+    const size_t n = size();
+    if (n == 0)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    sortByMorton();
+    buildTree();
+    lastBuildSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    const float theta2 = theta * theta;
+    const float eps2 = std::max(softening * softening, 1e-12f);
+    const OctreeNode* tree = nodes.data();
+    const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+    const float* x = posX.data();
+    const float* y = posY.data();
+    const float* z = posZ.data();
+    const float* m = mass.data();
+
+    pool.parallelFor(n, 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const float px = x[i], py = y[i], pz = z[i];
+            float ax = 0.0f, ay = 0.0f, az = 0.0f;
+
+            uint32_t k = 0;
+            while (k < nodeCount) {
+                const OctreeNode& node = tree[k];
+                float dx = node.comX - px, dy = node.comY - py, dz = node.comZ - pz;
+                float r2 = dx * dx + dy * dy + dz * dz;
+                bool containsSelf = i - node.begin < node.count;
+
+                if (!containsSelf && node.size * node.size < theta2 * r2) {
+                    r2 += eps2;
+                    float inv = 1.0f / std::sqrt(r2);
+                    float s = node.mass * inv * inv * inv;
+                    ax += dx * s;
+                    ay += dy * s;
+                    az += dz * s;
+                    k = node.next;
+                } else if (node.leaf) {
+                    // The particle's own term vanishes: zero offset times a finite softened factor.
+                    const uint32_t last = node.begin + node.count;
+                    for (uint32_t j = node.begin; j < last; ++j) {
+                        float ex = x[j] - px, ey = y[j] - py, ez = z[j] - pz;
+                        float d2 = ex * ex + ey * ey + ez * ez + eps2;
+                        float inv = 1.0f / std::sqrt(d2);
+                        float s = m[j] * inv * inv * inv;
+                        ax += ex * s;
+                        ay += ey * s;
+                        az += ez * s;
+                    }
+                    k = node.next;
+                } else {
+                    ++k;
+                }
+            }
+
+            accX[i] = ax * gravitationalConstant;
+            accY[i] = ay * gravitationalConstant;
+            accZ[i] = az * gravitationalConstant;
+        }
+    });
+
+    lastForceSeconds = secondsSince(start);
+    accelerationValid = true;
+}
+
+glm::vec3 BarnesHutSimulation::directAcceleration(size_t index) const {
+    const double eps2 = std::max(softening * softening, 1e-12f);
+    double ax = 0.0, ay = 0.0, az = 0.0;
+    for (size_t j = 0; j < size(); ++j) {
+        if (j == index)
+            continue;
+        double dx = posX[j] - posX[index], dy = posY[j] - posY[index], dz = posZ[j] - posZ[index];
+        double r2 = dx * dx + dy * dy + dz * dz + eps2;
+        double s = mass[j] / (r2 * std::sqrt(r2));
+        ax += dx * s;
+        ay += dy * s;
+        az += dz * s;
+    }
+    return glm::vec3(ax, ay, az) * gravitationalConstant;
+}
+
+void BarnesHutSimulation::sortByMorton() {
+    const size_t n = size();
+    const size_t chunkCount = pool.size();
+    const size_t chunkSize = (n + chunkCount - 1) / chunkCount;
+
+    // Bounding cube.
+    std::vector<glm::vec3> chunkMin(chunkCount, glm::vec3(INFINITY)), chunkMax(chunkCount, glm::vec3(-INFINITY));
+    pool.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            size_t end = std::min(n, (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i) {
+                glm::vec3 p(posX[i], posY[i], posZ[i]);
+                chunkMin[c] = glm::min(chunkMin[c], p);
+                chunkMax[c] = glm::max(chunkMax[c], p);
+            }
+        }
+    });
+    glm::vec3 lo(INFINITY), hi(-INFINITY);
+    for (size_t c = 0; c < chunkCount; ++c) {
+        lo = glm::min(lo, chunkMin[c]);
+        hi = glm::max(hi, chunkMax[c]);
+    }
+    glm::vec3 extent = hi - lo;
+    boundsSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) * 1.0001f;
+    boundsMin = lo;
+
+    codes.resize(n);
+    order.resize(n);
+    const float scale = 65536.0f / boundsSize;
+    pool.parallelFor(n, 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint64_t cx = std::min<uint64_t>(static_cast<uint64_t>((posX[i] - lo.x) * scale), 0xffff);
+            uint64_t cy = std::min<uint64_t>(static_cast<uint64_t>((posY[i] - lo.y) * scale), 0xffff);
+            uint64_t cz = std::min<uint64_t>(static_cast<uint64_t>((posZ[i] - lo.z) * scale), 0xffff);
+            codes[i] = spreadBits(cx) << 2 | spreadBits(cy) << 1 | spreadBits(cz);
+            order[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // LSD radix sort, one histogram row per chunk so every scatter is private.
+    codesScratch.resize(n);
+    orderScratch.resize(n);
+    histogram.resize(chunkCount * RADIX_BUCKETS);
+    for (int shift = 0; shift < 3 * MORTON_LEVELS; shift += RADIX_BITS) {
+        pool.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                uint32_t* row = histogram.data() + c * RADIX_BUCKETS;
+                std::fill(row, row + RADIX_BUCKETS, 0u);
+                size_t end = std::min(n, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i)
+                    ++row[(codes[i] >> shift) & (RADIX_BUCKETS - 1)];
+            }
+        });
+
+        uint32_t offset = 0;
+        bool trivial = false;
+        for (uint32_t d = 0; d < RADIX_BUCKETS; ++d) {
+            uint32_t bucketStart = offset;
+            for (size_t c = 0; c < chunkCount; ++c) {
+                uint32_t count = histogram[c * RADIX_BUCKETS + d];
+                histogram[c * RADIX_BUCKETS + d] = offset;
+                offset += count;
+            }
+            if (offset - bucketStart == n)
+                trivial = true;
+        }
+        if (trivial)
+            continue;
+
+        pool.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                uint32_t* row = histogram.data() + c * RADIX_BUCKETS;
+                size_t end = std::min(n, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i) {
+                    uint32_t dst = row[(codes[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+                    codesScratch[dst] = codes[i];
+                    orderScratch[dst] = order[i];
+                }
+            }
+        });
+        codes.swap(codesScratch);
+        order.swap(orderScratch);
+    }
+
+    // Move the particle state into Morton order.
+    floatScratch.resize(n);
+    AlignedVector<float>* fields[] = { &posX, &posY, &posZ, &velX, &velY, &velZ, &mass };
+    for (AlignedVector<float>* field : fields) {
+        const float* src = field->data();
+        pool.parallelFor(n, 16384, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                floatScratch[i] = src[order[i]];
+        });
+        field->swap(floatScratch);
+    }
+    idScratch.resize(n);
+    pool.parallelFor(n, 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            idScratch[i] = id[order[i]];
+    });
+    id.swap(idScratch);
+}
+
+void BarnesHutSimulation::buildTree() {
+    const uint32_t n = static_cast<uint32_t>(size());
+    TreeInput in = { codes.data(), posX.data(), posY.data(), posZ.data(), mass.data(),
+        std::max<uint32_t>(leafSize, 1), boundsSize };
+
+    std::vector<Subtree> subtrees;
+    collectSubtrees(in, subtrees, 0, n, 0);
+
+    // Largest ranges first so the tail of the loop is short jobs.
+    std::vector<uint32_t> schedule(subtrees.size());
+    for (uint32_t i = 0; i < schedule.size(); ++i)
+        schedule[i] = i;
+    std::sort(schedule.begin(), schedule.end(), [&](uint32_t a, uint32_t b) {
+        return subtrees[a].end - subtrees[a].begin > subtrees[b].end - subtrees[b].begin;
+    });
+
+    pool.parallelFor(schedule.size(), 1, [&](size_t first, size_t last) {
+        for (size_t s = first; s < last; ++s) {
+            Subtree& sub = subtrees[schedule[s]];
+            sub.nodes.reserve(2 * (sub.end - sub.begin) / in.leafSize + 1);
+            buildSubtree(in, sub.nodes, sub.begin, sub.end, sub.level);
+        }
+    });
+
+    size_t total = 0;
+    for (const Subtree& sub : subtrees)
+        total += sub.nodes.size();
+
+    nodes.clear();
+    nodes.reserve(total + 600);
+    size_t cursor = 0;
+    assembleTree(in, nodes, subtrees, cursor, 0, n, 0);
+}
+
+void addParticleDisk(BarnesHutSimulation& simulation, size_t count, const glm::vec3& center,
+    float centralMass, float diskMass, float innerRadius, float outerRadius, unsigned seed) {
+    const float TWO_PI = 6.28318530718f;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> thickness(0.0f, 0.01f);
+
+    const float particleMass = count > 0 ? diskMass / static_cast<float>(count) : 0.0f;
+    const float inner2 = innerRadius * innerRadius;
+    const float outer2 = outerRadius * outerRadius;
+    simulation.reserve(simulation.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        // Uniform surface density; orbital speed includes the disk mass inside r.
+        float r = std::sqrt(inner2 + unit(rng) * (outer2 - inner2));
+        float angle = unit(rng) * TWO_PI;
+        float enclosed = diskMass * (r * r - inner2) / (outer2 - inner2);
+        float speed = std::sqrt(simulation.gravitationalConstant * (centralMass + enclosed) / r);
+
+        glm::vec3 offset(r * std::cos(angle), r * thickness(rng), r * std::sin(angle));
+        glm::vec3 velocity(-std::sin(angle) * speed, 0.0f, std::cos(angle) * speed);
+        simulation.addParticle(center + offset, velocity, particleMass);
+    }
+}
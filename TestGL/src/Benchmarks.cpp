@@ -0,0 +1,56 @@
+#include "Benchmarks.h"
+#include <cstring>
+#include <iostream>
+
+struct BenchEntry {
+    const char* name;
+    void (*run)();
+};
+
+static const BenchEntry benchmarks[] = {
+    { "registry", benchBodyRegistry },
+    { "kepler", benchKeplerPropagator },
+    { "nbody", benchBarnesHut },
+    { "symplectic", benchSymplectic },
+    { "ephemeris", benchEphemeris },
+    { "ingest", benchCatalogIngest },
+    { "eclipse", benchEclipseSearch },
+    { "eclipsecatalog", benchEclipseCatalog },
+    { "shadow", benchShadowRaster },
+    { "conjunction", benchConjunctionSweep },
+    { "uniforms", benchUniformSetters },
+    { "instancing", benchSphereInstancing },
+    { "renderqueue", benchRenderQueue },
+    { "stream", benchStreamBuffer },
+    { "culling", benchCulling },
+    { "frustum", benchFrustumCulling },
+    { "lod", benchSphereLod },
+    { "mesh", benchSphereMeshes },
+    { "meshregistry", benchMeshRegistry },
+};
+
+int runBenchmarks(int argc, char** argv) {
+    bool ranAny = false;
+    for (const BenchEntry& entry : benchmarks) {
+        bool selected = argc == 0;
+        for (int i = 0; i < argc; ++i) {
+            if (std::strcmp(argv[i], entry.name) == 0)
+                selected = true;
+        }
+        if (!selected)
+            continue;
+
+        std::cout << "== " << entry.name << " ==" << std::endl;
+        entry.run();
+        ranAny = true;
+    }
+
+    if (!ranAny) {
+        std::cout << "Unknown benchmark. Available:";
+        for (const BenchEntry& entry : benchmarks)
+            std::cout << " " << entry.name;
+        std::cout << std::endl;
+        return 1;
+    }
+    return 0;
+}
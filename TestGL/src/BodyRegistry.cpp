@@ -0,0 +1,226 @@
+#include "BodyRegistry.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+uint32_t BodyRegistry::addBody(const BodyDesc& desc) {
+    uint32_t index = static_cast<uint32_t>(size());
+    int32_t parentIndex = desc.parent;
+    if (parentIndex >= static_cast<int32_t>(index)) {
+        std::cout << "ERROR: body " << desc.name << " added before its parent, orbiting the origin instead" << std::endl;
+        parentIndex = -1;
+    }
+
+    orbits.add(desc.orbit);
+    spinRate.push_back(desc.spinRate);
+    spinPhase.push_back(desc.spinPhase);
+    spinAngle.push_back(0.0f);
+    localX.push_back(0.0f);
+    localY.push_back(0.0f);
+    localZ.push_back(0.0f);
+    posX.push_back(0.0f);
+    posY.push_back(0.0f);
+    posZ.push_back(0.0f);
+    prevX.push_back(0.0f);
+    prevY.push_back(0.0f);
+    prevZ.push_back(0.0f);
+    prevSpin.push_back(0.0f);
+    radius.push_back(desc.radius);
+    parent.push_back(parentIndex);
+    materialId.push_back(desc.materialId);
+    names.push_back(desc.name);
+    dirty.push_back(0);
+
+    // Fixed frames get their offset once here; moving bodies join a batch run.
+    propagator.propagateRange(orbits, orbits.epoch, localX.data(), localY.data(), localZ.data(), index, index + 1);
+    if (desc.orbit.meanMotion != 0.0) {
+        if (!movingRuns.empty() && movingRuns.back().second == index)
+            movingRuns.back().second = index + 1;
+        else
+            movingRuns.push_back({ index, index + 1 });
+    }
+    markDirty(index, index + 1);
+
+    return index;
+}
+
+void BodyRegistry::reserve(size_t count) {
+    orbits.reserve(count);
+    spinRate.reserve(count);
+    spinPhase.reserve(count);
+    spinAngle.reserve(count);
+    localX.reserve(count);
+    localY.reserve(count);
+    localZ.reserve(count);
+    posX.reserve(count);
+    posY.reserve(count);
+    posZ.reserve(count);
+    prevX.reserve(count);
+    prevY.reserve(count);
+    prevZ.reserve(count);
+    prevSpin.reserve(count);
+    radius.reserve(count);
+    parent.reserve(count);
+    materialId.reserve(count);
+    names.reserve(count);
+    dirty.reserve(count);
+}
+
+void BodyRegistry::clear() {
+    time = 0.0;
+    orbits.clear();
+    spinRate.clear();
+    spinPhase.clear();
+    spinAngle.clear();
+    localX.clear();
+    localY.clear();
+    localZ.clear();
+    posX.clear();
+    posY.clear();
+    posZ.clear();
+    prevX.clear();
+    prevY.clear();
+    prevZ.clear();
+    prevSpin.clear();
+    radius.clear();
+    parent.clear();
+    materialId.clear();
+    names.clear();
+    dirty.clear();
+    firstDirty = 0;
+    movingRuns.clear();
+}
+
+int32_t BodyRegistry::find(const std::string& name) const {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name)
+            return static_cast<int32_t>(i);
+    }
+    return -1;
+}
+
+void BodyRegistry::evaluate(double julianDate) {
+    const size_t n = size();
+    evaluateSpin(julianDate);
+
+    float* x = localX.data();
+    float* y = localY.data();
+    float* z = localZ.data();
+
+    // Parent-relative positions, from the ephemeris when it covers this date,
+    // otherwise from batched Kepler solves over the moving bodies.
+    if (ephemeris && ephemeris->covers(julianDate)) {
+        ephemeris->evaluateRelative(julianDate, x, y, z);
+        markDirty(0, n);
+    } else {
+        for (const std::pair<uint32_t, uint32_t>& run : movingRuns) {
+            propagator.propagateRange(orbits, time, x, y, z, run.first, run.second);
+            markDirty(run.first, run.second);
+        }
+    }
+
+    updateWorldPositions();
+}
+
+void BodyRegistry::evaluateSpin(double julianDate) {
+    const double TWO_PI = 6.283185307179586;
+    const double dt = julianDate - orbits.epoch;
+    time = julianDate;
+
+    // Spin is reduced in double before narrowing, so it stays exact far from the epoch.
+    for (size_t i = 0; i < size(); ++i) {
+        double angle = spinPhase[i] + spinRate[i] * dt;
+        spinAngle[i] = static_cast<float>(angle - TWO_PI * std::floor(angle / TWO_PI));
+    }
+}
+
+void BodyRegistry::markDirty(size_t begin, size_t end) {
+    std::fill(dirty.begin() + begin, dirty.begin() + end, uint8_t(1));
+    firstDirty = std::min(firstDirty, begin);
+}
+
+void BodyRegistry::updateWorldPositions() {
+    const size_t n = size();
+    const float* lx = localX.data();
+    const float* ly = localY.data();
+    const float* lz = localZ.data();
+    float* x = posX.data();
+    float* y = posY.data();
+    float* z = posZ.data();
+    uint8_t* changed = dirty.data();
+
+    // Parents precede children, so one forward pass carries each change down
+    // to any depth. Nothing before the first dirty body can be affected.
+    for (size_t i = firstDirty; i < n; ++i) {
+        int32_t p = parent[i];
+        if (p >= 0)
+            changed[i] |= changed[p];
+        if (!changed[i])
+            continue;
+        if (p >= 0) {
+            x[i] = lx[i] + x[p];
+            y[i] = ly[i] + y[p];
+            z[i] = lz[i] + z[p];
+        } else {
+            x[i] = lx[i];
+            y[i] = ly[i];
+            z[i] = lz[i];
+        }
+    }
+
+    if (firstDirty < n)
+        std::fill(dirty.begin() + firstDirty, dirty.end(), uint8_t(0));
+    firstDirty = n;
+}
+
+bool BodyRegistry::useEphemeris(const Ephemeris* source) {
+    if (source && source->bodyCount() != size()) {
+        std::cout << "ERROR: ephemeris has " << source->bodyCount() << " bodies, expected " << size() << std::endl;
+        return false;
+    }
+    for (size_t i = 0; source && i < size(); ++i) {
+        const EphemerisBodyEntry& entry = source->body(i);
+        if (names[i] != entry.name || parent[i] != entry.parent) {
+            std::cout << "ERROR: ephemeris body " << i << " is " << entry.name << ", expected " << names[i] << std::endl;
+            return false;
+        }
+    }
+    ephemeris = source;
+    return true;
+}
+
+void BodyRegistry::storePreviousState() {
+    prevX = posX;
+    prevY = posY;
+    prevZ = posZ;
+    prevSpin = spinAngle;
+}
+
+glm::vec3 BodyRegistry::interpolatedPosition(uint32_t index, float alpha) const {
+    glm::vec3 previous(prevX[index], prevY[index], prevZ[index]);
+    return glm::mix(previous, position(index), alpha);
+}
+
+float BodyRegistry::interpolatedSpin(uint32_t index, float alpha) const {
+    const float PI = 3.14159265359f;
+    // Spin angles wrap at 2*pi; blend along the short way round.
+    float delta = spinAngle[index] - prevSpin[index];
+    if (delta > PI)
+        delta -= 2.0f * PI;
+    else if (delta < -PI)
+        delta += 2.0f * PI;
+    return prevSpin[index] + delta * alpha;
+}
+
+void BodyRegistry::setLocalPosition(uint32_t index, const glm::vec3& offset) {
+    localX[index] = offset.x;
+    localY[index] = offset.y;
+    localZ[index] = offset.z;
+    markDirty(index, index + 1);
+}
+
+void BodyRegistry::setPosition(uint32_t index, const glm::vec3& p) {
+    posX[index] = p.x;
+    posY[index] = p.y;
+    posZ[index] = p.z;
+}
@@ -0,0 +1,170 @@
+#include "ConjunctionSweep.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float PI = 3.14159265f;
+const float TWO_PI = 6.28318531f;
+// Caps the interval of a body right next to the observer, so no interval
+// reaches round the sky far enough to meet itself.
+const float MAX_REACH = 1.5f;
+
+// Half the longitude span of a circle of angular radius `reach` centred at
+// `latitude`: reach grows by 1/cos(latitude) towards the poles, and a circle
+// that reaches a pole covers every longitude (returns pi).
+float longitudeReach(float latitude, float reach) {
+    float edge = std::abs(latitude) + reach;
+    if (edge >= PI / 2.0f)
+        return PI;
+    return std::asin(std::min(1.0f, std::sin(reach) / std::cos(std::abs(latitude))));
+}
+
+float apparentRadius(float radius, float distance) {
+    return radius >= distance ? PI / 2.0f : std::asin(radius / distance);
+}
+
+// Separation from the chord between unit directions, which keeps its
+// precision for the small angles that matter here.
+float separation(const glm::vec3& a, const glm::vec3& b) {
+    return 2.0f * std::asin(std::min(1.0f, 0.5f * glm::length(a - b)));
+}
+
+bool classify(uint32_t a, uint32_t b, float sep, float radiusA, float radiusB, float distanceA, float distanceB,
+    float threshold, ConjunctionPair& pair) {
+    bool aNear = distanceA <= distanceB;
+    pair.nearBody = aNear ? a : b;
+    pair.farBody = aNear ? b : a;
+    pair.separation = sep;
+    if (sep < radiusA + radiusB) {
+        float nearRadius = aNear ? radiusA : radiusB, farRadius = aNear ? radiusB : radiusA;
+        pair.kind = nearRadius >= farRadius ? ConjunctionKind::Occultation : ConjunctionKind::Transit;
+        return true;
+    }
+    pair.kind = ConjunctionKind::Conjunction;
+    return sep < threshold;
+}
+
+}
+
+void ConjunctionSweep::project(const float* x, const float* y, const float* z, const float* radius, size_t count,
+    const glm::vec3& observer) {
+    dirX.resize(count);
+    dirY.resize(count);
+    dirZ.resize(count);
+    latitude.resize(count);
+    apparentRadius.resize(count);
+    reach.resize(count);
+    distance.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 d(x[i] - observer.x, y[i] - observer.y, z[i] - observer.z);
+        float length = std::max(glm::length(d), 1e-30f);
+        d /= length;
+        dirX[i] = d.x;
+        dirY[i] = d.y;
+        dirZ[i] = d.z;
+        distance[i] = length;
+        // Scene +y is the ecliptic pole.
+        latitude[i] = std::asin(std::max(-1.0f, std::min(1.0f, d.y)));
+        apparentRadius[i] = radius ? ::apparentRadius(radius[i], length) : 0.0f;
+        reach[i] = std::min(apparentRadius[i] + 0.5f * threshold, MAX_REACH);
+    }
+}
+
+void ConjunctionSweep::update(const float* x, const float* y, const float* z, const float* radius, size_t count,
+    const glm::vec3& observer, int64_t exclude) {
+    project(x, y, z, radius, count, observer);
+    found.clear();
+    lastStats = ConjunctionStats();
+
+    bool excluded = exclude >= 0 && static_cast<size_t>(exclude) < count;
+    size_t n = count - (excluded ? 1 : 0);
+    bool rebuild = order.size() != n || orderExclude != exclude;
+    if (rebuild) {
+        order.clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (i != exclude)
+                order.push_back({ 0.0f, 0.0f, 0.0f, 0.0f, i });
+        }
+        orderExclude = exclude;
+    }
+
+    for (Interval& interval : order) {
+        uint32_t i = interval.body;
+        float halfWidth = longitudeReach(latitude[i], reach[i]);
+        float start = halfWidth >= PI ? -PI : std::atan2(dirZ[i], dirX[i]) - halfWidth;
+        if (start < -PI)
+            start += TWO_PI;
+        interval.start = start;
+        interval.end = start + 2.0f * halfWidth;
+        interval.latitude = latitude[i];
+        interval.reach = reach[i];
+    }
+
+    if (rebuild) {
+        std::sort(order.begin(), order.end(), [](const Interval& a, const Interval& b) { return a.start < b.start; });
+    } else {
+        // Nearly sorted from the last update: each body moves a few places at most.
+        for (size_t k = 1; k < n; ++k) {
+            Interval moving = order[k];
+            size_t m = k;
+            for (; m > 0 && order[m - 1].start > moving.start; --m)
+                order[m] = order[m - 1];
+            order[m] = moving;
+            lastStats.swaps += k - m;
+        }
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+        const Interval& a = order[k];
+        for (size_t m = k + 1; m < n && order[m].start <= a.end; ++m) {
+            ++lastStats.candidates;
+            test(a, order[m]);
+        }
+
+        // Past +pi, the interval continues from the start of the order.
+        if (a.end > PI) {
+            float wrapped = a.end - TWO_PI;
+            for (size_t m = 0; m < k && order[m].start <= wrapped; ++m) {
+                if (order[m].end >= a.start)
+                    continue;   // already met in the sweep above
+                ++lastStats.candidates;
+                test(a, order[m]);
+            }
+        }
+    }
+    lastStats.bodies = n;
+}
+
+void ConjunctionSweep::test(const Interval& first, const Interval& second) {
+    if (std::abs(first.latitude - second.latitude) > first.reach + second.reach)
+        return;
+    uint32_t a = first.body, b = second.body;
+    float sep = separation(glm::vec3(dirX[a], dirY[a], dirZ[a]), glm::vec3(dirX[b], dirY[b], dirZ[b]));
+    ConjunctionPair pair;
+    if (classify(a, b, sep, apparentRadius[a], apparentRadius[b], distance[a], distance[b], threshold, pair))
+        found.push_back(pair);
+}
+
+void findConjunctionsBruteForce(const float* x, const float* y, const float* z, const float* radius, size_t count,
+    const glm::vec3& observer, float threshold, std::vector<ConjunctionPair>& pairs) {
+    std::vector<glm::vec3> directions(count);
+    std::vector<float> radii(count), distances(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 d(x[i] - observer.x, y[i] - observer.y, z[i] - observer.z);
+        distances[i] = std::max(glm::length(d), 1e-30f);
+        directions[i] = d / distances[i];
+        radii[i] = radius ? apparentRadius(radius[i], distances[i]) : 0.0f;
+    }
+
+    pairs.clear();
+    for (uint32_t a = 0; a < count; ++a) {
+        for (uint32_t b = a + 1; b < count; ++b) {
+            ConjunctionPair pair;
+            float sep = separation(directions[a], directions[b]);
+            if (classify(a, b, sep, radii[a], radii[b], distances[a], distances[b], threshold, pair))
+                pairs.push_back(pair);
+        }
+    }
+}
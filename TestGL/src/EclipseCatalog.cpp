@@ -0,0 +1,257 @@
+#include "EclipseCatalog.h"
+#include "JulianDate.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+// Each shard is searched by one thread from start to end. A year holds four
+// to seven eclipses, enough work to hide the scheduling.
+const double SHARD_DAYS = 365.25;
+// Shards per thread in each batch; a checkpoint is written after every batch.
+const size_t SHARDS_PER_THREAD = 8;
+
+const char CHECKPOINT_MAGIC[8] = { 'S', 'S', 'E', 'C', 'K', 'P', 'T', '\0' };
+const uint32_t CHECKPOINT_VERSION = 1;
+
+struct CatalogCheckpoint {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    double from;
+    double to;
+    double shardDays;
+    uint64_t nextShard;
+    uint64_t events;
+    uint64_t csvBytes;          // output sizes after shard `nextShard - 1`
+    uint64_t binaryBytes;
+};
+
+const char CSV_HEADER[] = "kind,type,greatest_jd,greatest_date,start_jd,end_jd,duration_min,magnitude\n";
+
+// Every eclipse whose greatest phase falls in (begin, end], in time order.
+void searchShard(const EclipseModel& model, double begin, double end, std::vector<EclipseRecord>& records) {
+    records.clear();
+    for (EclipseKind kind : { EclipseKind::Solar, EclipseKind::Lunar }) {
+        // Eclipses of one kind are at least a synodic month apart, so a day
+        // past the last one never skips the next.
+        for (double t = begin; t < end;) {
+            EclipseEvent event = findNextEclipse(model, kind, t, end - t);
+            if (event.type == EclipseType::None)
+                break;
+            EclipseRecord record = {};
+            record.maximum = event.maximum;
+            record.start = event.start;
+            record.end = event.end;
+            record.magnitude = static_cast<float>(event.magnitude);
+            record.kind = static_cast<uint8_t>(event.kind);
+            record.type = static_cast<uint8_t>(event.type);
+            records.push_back(record);
+            t = event.maximum + 1.0;
+        }
+    }
+    std::sort(records.begin(), records.end(),
+        [](const EclipseRecord& a, const EclipseRecord& b) { return a.maximum < b.maximum; });
+}
+
+void appendCsv(std::string& text, const EclipseRecord& record) {
+    char line[192];
+    int length = std::snprintf(line, sizeof(line), "%s,%s,%.6f,%s,%.6f,%.6f,%.2f,%.4f\n",
+        record.kind == static_cast<uint8_t>(EclipseKind::Solar) ? "solar" : "lunar",
+        eclipseTypeName(static_cast<EclipseType>(record.type)), record.maximum,
+        formatJulianDate(record.maximum).c_str(), record.start, record.end, (record.end - record.start) * 1440.0,
+        record.magnitude);
+    text.append(line, static_cast<size_t>(length));
+}
+
+bool readCheckpoint(const std::string& path, CatalogCheckpoint& checkpoint) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !in.read(reinterpret_cast<char*>(&checkpoint), sizeof(checkpoint))) {
+        std::cout << "ERROR: cannot read checkpoint " << path << std::endl;
+        return false;
+    }
+    if (std::memcmp(checkpoint.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0
+        || checkpoint.version != CHECKPOINT_VERSION || checkpoint.shardDays != SHARD_DAYS) {
+        std::cout << "ERROR: " << path << " is not a version " << CHECKPOINT_VERSION << " eclipse catalog checkpoint"
+            << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Written beside the real file and renamed over it, so a crash leaves either
+// the old checkpoint or the new one.
+bool writeCheckpoint(const std::string& path, const CatalogCheckpoint& checkpoint) {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&checkpoint), sizeof(checkpoint));
+        if (!out) {
+            std::cout << "ERROR: cannot write " << temporary << std::endl;
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cout << "ERROR: cannot replace " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Cuts an output back to the size recorded in the checkpoint, dropping
+// anything written after it.
+bool truncateTo(const std::string& path, uint64_t size) {
+    std::error_code error;
+    uint64_t actual = std::filesystem::file_size(path, error);
+    if (error || actual < size) {
+        std::cout << "ERROR: " << path << " is missing or shorter than its checkpoint" << std::endl;
+        return false;
+    }
+    std::filesystem::resize_file(path, size, error);
+    if (error) {
+        std::cout << "ERROR: cannot truncate " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool generateEclipseCatalog(const EclipseModel& model, const std::string& basePath, double from, double to,
+    bool resume, ThreadPool& pool, EclipseCatalogStats& stats, const std::atomic<bool>* cancel) {
+    auto begin = std::chrono::steady_clock::now();
+    stats = EclipseCatalogStats();
+
+    const std::string csvPath = basePath + ".csv";
+    const std::string binaryPath = basePath + ".ecl";
+    const std::string checkpointPath = basePath + ".checkpoint";
+
+    CatalogCheckpoint checkpoint = {};
+    if (resume) {
+        if (!readCheckpoint(checkpointPath, checkpoint))
+            return false;
+        if (!truncateTo(csvPath, checkpoint.csvBytes) || !truncateTo(binaryPath, checkpoint.binaryBytes))
+            return false;
+        from = checkpoint.from;
+        to = checkpoint.to;
+        stats.resumedEvents = static_cast<size_t>(checkpoint.events);
+    } else {
+        if (!(to > from)) {
+            std::cout << "ERROR: eclipse catalog range is empty" << std::endl;
+            return false;
+        }
+        std::memcpy(checkpoint.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        checkpoint.version = CHECKPOINT_VERSION;
+        checkpoint.from = from;
+        checkpoint.to = to;
+        checkpoint.shardDays = SHARD_DAYS;
+    }
+
+    const std::ios::openmode mode = std::ios::binary | (resume ? std::ios::app : std::ios::trunc);
+    std::ofstream csv(csvPath, mode);
+    std::ofstream binary(binaryPath, mode);
+    if (!csv || !binary) {
+        std::cout << "ERROR: cannot write " << (csv ? binaryPath : csvPath) << std::endl;
+        return false;
+    }
+    if (!resume) {
+        // The count is filled in once the catalog is complete.
+        EclipseCatalogHeader header = {};
+        std::memcpy(header.magic, ECLIPSE_CATALOG_MAGIC, sizeof(ECLIPSE_CATALOG_MAGIC));
+        header.version = ECLIPSE_CATALOG_VERSION;
+        header.from = from;
+        header.to = to;
+        binary.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        csv << CSV_HEADER;
+        checkpoint.csvBytes = sizeof(CSV_HEADER) - 1;
+        checkpoint.binaryBytes = sizeof(header);
+        csv.flush();
+        binary.flush();
+        if (!csv || !binary || !writeCheckpoint(checkpointPath, checkpoint))
+            return false;
+    }
+
+    EclipseModel catalogModel = model;
+    catalogModel.penumbralLunar = true;
+
+    const size_t shardCount = static_cast<size_t>(std::ceil((to - from) / SHARD_DAYS));
+    const size_t batchSize = pool.size() * SHARDS_PER_THREAD;
+    std::vector<std::vector<EclipseRecord>> shards(batchSize);
+    std::string text;
+
+    size_t shard = static_cast<size_t>(checkpoint.nextShard);
+    while (shard < shardCount) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            stats.interrupted = true;
+            break;
+        }
+
+        size_t count = std::min(batchSize, shardCount - shard);
+        pool.parallelFor(count, 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                double shardBegin = from + (shard + i) * SHARD_DAYS;
+                searchShard(catalogModel, shardBegin, std::min(shardBegin + SHARD_DAYS, to), shards[i]);
+            }
+        });
+
+        text.clear();
+        for (size_t i = 0; i < count; ++i) {
+            for (const EclipseRecord& record : shards[i]) {
+                appendCsv(text, record);
+                if (record.kind == static_cast<uint8_t>(EclipseKind::Solar))
+                    ++stats.solar;
+                else
+                    ++stats.lunar;
+            }
+            binary.write(reinterpret_cast<const char*>(shards[i].data()),
+                static_cast<std::streamsize>(shards[i].size() * sizeof(EclipseRecord)));
+            checkpoint.events += shards[i].size();
+            checkpoint.binaryBytes += shards[i].size() * sizeof(EclipseRecord);
+        }
+        csv.write(text.data(), static_cast<std::streamsize>(text.size()));
+        checkpoint.csvBytes += text.size();
+        csv.flush();
+        binary.flush();
+        if (!csv || !binary) {
+            std::cout << "ERROR: failed while writing " << basePath << " catalog" << std::endl;
+            return false;
+        }
+
+        shard += count;
+        checkpoint.nextShard = shard;
+        if (!writeCheckpoint(checkpointPath, checkpoint))
+            return false;
+    }
+    csv.close();
+    binary.close();
+
+    stats.events = static_cast<size_t>(checkpoint.events);
+    if (!stats.interrupted) {
+        std::fstream patch(binaryPath, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t count = checkpoint.events;
+        patch.seekp(offsetof(EclipseCatalogHeader, count));
+        patch.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        if (!patch) {
+            std::cout << "ERROR: cannot finish " << binaryPath << std::endl;
+            return false;
+        }
+        patch.close();
+        std::error_code error;
+        std::filesystem::remove(checkpointPath, error);
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return true;
+}
@@ -0,0 +1,319 @@
+#include "EclipseSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Days between samples of the bracketing scan. The Moon's elongation always
+// increases, so the separation is unimodal for about two weeks either side of
+// each new or full moon, and three samples four days apart with the middle
+// one lowest always bracket its minimum.
+const double SCAN_STEP = 4.0;
+// Contact and maximum times are refined to about 0.01 s.
+const double TIME_TOLERANCE = 1e-7;
+const int MAX_ITERATIONS = 100;
+
+double angleBetween(const glm::dvec3& a, const glm::dvec3& b) {
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+// Separation of the Moon from the Sun (solar) or from the shadow axis (lunar)
+// as seen from the Earth's centre, with the apparent radii and horizontal
+// parallaxes that set the eclipse limits at that instant.
+struct EclipseSample {
+    double separation;
+    double sunRadius;
+    double moonRadius;
+    double sunParallax;
+    double moonParallax;
+};
+
+struct EclipseGeometry {
+    const EclipseModel& model;
+    EclipseKind kind;
+    double origin;
+
+    EclipseSample evaluate(double t) const {
+        double dt = origin + t - model.epoch;
+        glm::dvec3 toSun = -keplerPosition(model.earthOrbit, dt);
+        glm::dvec3 toMoon = keplerPosition(model.moonOrbit, dt);
+        double sunDistance = glm::length(toSun);
+        double moonDistance = glm::length(toMoon);
+
+        EclipseSample sample;
+        sample.separation = angleBetween(kind == EclipseKind::Solar ? toSun : -toSun, toMoon);
+        sample.sunRadius = std::asin(model.sunRadius / sunDistance);
+        sample.moonRadius = std::asin(model.moonRadius / moonDistance);
+        sample.sunParallax = std::asin(model.earthRadius / sunDistance);
+        sample.moonParallax = std::asin(model.earthRadius / moonDistance);
+        return sample;
+    }
+
+    // Radii of the Earth's shadow cones at the Moon's distance.
+    double umbra(const EclipseSample& s) const {
+        return (s.moonParallax + s.sunParallax - s.sunRadius) * model.shadowEnlargement;
+    }
+    double penumbra(const EclipseSample& s) const {
+        return (s.moonParallax + s.sunParallax + s.sunRadius) * model.shadowEnlargement;
+    }
+
+    // Separation below which there is an eclipse: the Moon's penumbra reaches
+    // the Earth (solar), or the Moon overlaps the umbra or, if penumbral
+    // eclipses are wanted, the penumbra (lunar).
+    double limit(const EclipseSample& s) const {
+        if (kind == EclipseKind::Solar)
+            return s.sunRadius + s.moonRadius + s.moonParallax - s.sunParallax;
+        return (model.penumbralLunar ? penumbra(s) : umbra(s)) + s.moonRadius;
+    }
+
+    double separation(double t) const { return evaluate(t).separation; }
+
+    double overlap(double t) const {
+        EclipseSample sample = evaluate(t);
+        return sample.separation - limit(sample);
+    }
+
+    // Type and magnitude at greatest eclipse. Solar magnitude is the fraction
+    // of the Sun's diameter covered where the shadow axis passes closest to
+    // the Earth; lunar magnitude is the fraction of the Moon's diameter inside
+    // the umbra, or the penumbra for a penumbral eclipse.
+    void classify(const EclipseSample& s, EclipseEvent& event) const {
+        if (kind == EclipseKind::Solar) {
+            // Central when the axis of the Moon's shadow hits the Earth.
+            if (s.separation < s.moonParallax - s.sunParallax) {
+                event.type = s.moonRadius > s.sunRadius ? EclipseType::Total : EclipseType::Annular;
+                event.magnitude = s.moonRadius / s.sunRadius;
+            } else {
+                event.type = EclipseType::Partial;
+                event.magnitude = (limit(s) - s.separation) / (2.0 * s.sunRadius);
+            }
+            return;
+        }
+
+        double umbral = (umbra(s) + s.moonRadius - s.separation) / (2.0 * s.moonRadius);
+        if (umbral >= 1.0)
+            event.type = EclipseType::Total;
+        else if (umbral > 0.0)
+            event.type = EclipseType::Partial;
+        else
+            event.type = EclipseType::Penumbral;
+        event.magnitude = event.type == EclipseType::Penumbral
+            ? (penumbra(s) + s.moonRadius - s.separation) / (2.0 * s.moonRadius) : umbral;
+    }
+};
+
+// Brent's root finder: inverse quadratic or secant steps, falling back to
+// bisection whenever they would not shrink the bracket fast enough. f(a) and
+// f(b) must differ in sign.
+template <typename F>
+double brentRoot(const F& f, double a, double b, double fa, double fb) {
+    double c = b, fc = fb;
+    double d = b - a, e = d;
+    for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+        if ((fb > 0.0) == (fc > 0.0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (std::abs(fc) < std::abs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+
+        double tolerance = 2.0 * std::numeric_limits<double>::epsilon() * std::abs(b) + 0.5 * TIME_TOLERANCE;
+        double half = 0.5 * (c - b);
+        if (std::abs(half) <= tolerance || fb == 0.0)
+            return b;
+
+        if (std::abs(e) >= tolerance && std::abs(fa) > std::abs(fb)) {
+            double s = fb / fa, p, q;
+            if (a == c) {
+                p = 2.0 * half * s;
+                q = 1.0 - s;
+            } else {
+                double r = fb / fc;
+                q = fa / fc;
+                p = s * (2.0 * half * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0)
+                q = -q;
+            p = std::abs(p);
+            if (2.0 * p < std::min(3.0 * half * q - std::abs(tolerance * q), std::abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = e = half;
+            }
+        } else {
+            d = e = half;
+        }
+
+        a = b;
+        fa = fb;
+        b += std::abs(d) > tolerance ? d : std::copysign(tolerance, half);
+        fb = f(b);
+    }
+    return b;
+}
+
+// Brent's minimizer: parabolic interpolation through the three best points,
+// with golden-section steps when the parabola is not trustworthy.
+template <typename F>
+double brentMinimum(const F& f, double a, double b, double x) {
+    const double GOLDEN = 0.3819660112501051;
+    double w = x, v = x;
+    double fx = f(x), fw = fx, fv = fx;
+    double d = 0.0, e = 0.0;
+
+    for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+        double middle = 0.5 * (a + b);
+        double tolerance = 1e-10 * std::abs(x) + 0.5 * TIME_TOLERANCE;
+        if (std::abs(x - middle) <= 2.0 * tolerance - 0.5 * (b - a))
+            return x;
+
+        bool golden = true;
+        if (std::abs(e) > tolerance) {
+            double r = (x - w) * (fx - fv);
+            double q = (x - v) * (fx - fw);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2.0 * (q - r);
+            if (q > 0.0)
+                p = -p;
+            q = std::abs(q);
+            double previous = e;
+            if (std::abs(p) < std::abs(0.5 * q * previous) && p > q * (a - x) && p < q * (b - x)) {
+                e = d;
+                d = p / q;
+                double u = x + d;
+                if (u - a < 2.0 * tolerance || b - u < 2.0 * tolerance)
+                    d = std::copysign(tolerance, middle - x);
+                golden = false;
+            }
+        }
+        if (golden) {
+            e = (x >= middle ? a : b) - x;
+            d = GOLDEN * e;
+        }
+
+        double u = std::abs(d) >= tolerance ? x + d : x + std::copysign(tolerance, d);
+        double fu = f(u);
+        if (fu <= fx) {
+            if (u >= x)
+                a = x;
+            else
+                b = x;
+            v = w; fv = fw;
+            w = x; fw = fx;
+            x = u; fx = fu;
+        } else {
+            if (u < x)
+                a = u;
+            else
+                b = u;
+            if (fu <= fw || w == x) {
+                v = w; fv = fw;
+                w = u; fw = fu;
+            } else if (fu <= fv || v == x || v == w) {
+                v = u; fv = fu;
+            }
+        }
+    }
+    return x;
+}
+
+// Steps away from `inside` until the overlap turns positive, then refines the contact.
+double findContact(const EclipseGeometry& geometry, double inside, double direction) {
+    auto overlap = [&](double t) { return geometry.overlap(t); };
+    double a = inside, fa = overlap(a);
+    double b = a, fb = fa;
+    while (fb < 0.0) {
+        a = b;
+        fa = fb;
+        b += direction * SCAN_STEP;
+        fb = overlap(b);
+    }
+    return brentRoot(overlap, a, b, fa, fb);
+}
+
+}
+
+const char* eclipseTypeName(EclipseType type) {
+    switch (type) {
+    case EclipseType::Penumbral: return "penumbral";
+    case EclipseType::Partial: return "partial";
+    case EclipseType::Annular: return "annular";
+    case EclipseType::Total: return "total";
+    default: return "none";
+    }
+}
+
+EclipseEvent findNextEclipse(const EclipseModel& model, EclipseKind kind, double from, double maxDays,
+    const std::atomic<bool>* cancel) {
+    // Times inside the search are relative to `from` so the tolerances stay absolute.
+    EclipseGeometry geometry = { model, kind, from };
+    auto separation = [&](double t) { return geometry.separation(t); };
+
+    EclipseEvent event;
+    event.kind = kind;
+
+    double t0 = -SCAN_STEP, t1 = 0.0;
+    double s0 = separation(t0), s1 = separation(t1);
+    for (double t2 = SCAN_STEP; t2 <= maxDays + SCAN_STEP; t2 += SCAN_STEP) {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return event;
+
+        double s2 = separation(t2);
+        if (s1 < s0 && s1 <= s2) {
+            double peak = brentMinimum(separation, t0, t2, t1);
+            EclipseSample sample = geometry.evaluate(peak);
+            if (peak > 0.0 && peak <= maxDays && sample.separation < geometry.limit(sample)) {
+                event.maximum = from + peak;
+                event.start = from + findContact(geometry, peak, -1.0);
+                event.end = from + findContact(geometry, peak, 1.0);
+                event.separation = sample.separation;
+                geometry.classify(sample, event);
+                return event;
+            }
+        }
+        t0 = t1; s0 = s1;
+        t1 = t2; s1 = s2;
+    }
+    return event;
+}
+
+EclipseSearch::~EclipseSearch() {
+    cancel();
+}
+
+void EclipseSearch::start(const EclipseModel& model, EclipseKind kind, double from, double maxDays) {
+    cancel();
+    cancelRequested.store(false);
+    finished.store(false);
+    worker = std::thread([this, model, kind, from, maxDays] {
+        auto begin = std::chrono::steady_clock::now();
+        result = findNextEclipse(model, kind, from, maxDays, &cancelRequested);
+        resultSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        finished.store(true, std::memory_order_release);
+    });
+}
+
+void EclipseSearch::cancel() {
+    if (!worker.joinable())
+        return;
+    cancelRequested.store(true);
+    worker.join();
+    finished.store(false);
+}
+
+bool EclipseSearch::poll(EclipseEvent& event, double& seconds) {
+    if (!worker.joinable() || !finished.load(std::memory_order_acquire))
+        return false;
+    worker.join();
+    finished.store(false);
+    event = result;
+    seconds = resultSeconds;
+    return true;
+}
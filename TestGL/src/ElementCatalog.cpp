@@ -0,0 +1,357 @@
+#include "ElementCatalog.h"
+#include "JulianDate.h"
+#include "KeplerPropagator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const double DEG = 3.14159265358979323846 / 180.0;
+const double TWO_PI = 6.283185307179586;
+
+// Bytes read per chunk. The next chunk is read while this one is parsed.
+const size_t CHUNK_SIZE = size_t(32) << 20;
+const size_t SLICES_PER_THREAD = 4;
+
+// MPCORB columns, 0-based [begin, end).
+const size_t EPOCH_BEGIN = 20;
+const size_t MIN_RECORD_LENGTH = 103;
+struct Field {
+    size_t begin, end;
+};
+const Field MEAN_ANOMALY = { 26, 35 };
+const Field ARG_PERIHELION = { 37, 46 };
+const Field ASCENDING_NODE = { 48, 57 };
+const Field INCLINATION = { 59, 68 };
+const Field ECCENTRICITY = { 70, 79 };
+const Field MEAN_MOTION = { 80, 91 };
+const Field SEMI_MAJOR = { 92, 103 };
+
+const size_t COLUMN_COUNT = 11;
+
+uint64_t alignTo64(uint64_t offset) {
+    return (offset + 63) & ~uint64_t(63);
+}
+
+// Column offsets in KeplerOrbitView order; returns the file size.
+uint64_t catalogLayout(uint64_t count, uint64_t offsets[COLUMN_COUNT]) {
+    uint64_t offset = sizeof(ElementCatalogHeader);
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        offsets[c] = offset;
+        offset = alignTo64(offset + count * (c < 2 ? sizeof(double) : sizeof(float)));
+    }
+    return offset;
+}
+
+bool parseField(const char* line, Field field, double& value) {
+    const char* first = line + field.begin;
+    const char* last = line + field.end;
+    while (first < last && *first == ' ')
+        ++first;
+    while (last > first && last[-1] == ' ')
+        --last;
+    if (first == last)
+        return false;
+    std::from_chars_result result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+int unpackDigit(char c) {
+    if (c >= '1' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'V')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Packed epoch "K24AH": century letter, two-digit year, then month and day
+// as 1-9 followed by A, B, C, ...
+bool parsePackedEpoch(const char* text, double& julianDate) {
+    if (text[0] < 'I' || text[0] > 'K' || text[1] < '0' || text[1] > '9' || text[2] < '0' || text[2] > '9')
+        return false;
+    int year = (18 + text[0] - 'I') * 100 + (text[1] - '0') * 10 + (text[2] - '0');
+    int month = unpackDigit(text[3]);
+    int day = unpackDigit(text[4]);
+    if (month < 1 || month > 12 || day < 1)
+        return false;
+    julianDate = calendarToJulianDate(year, month, day);
+    return true;
+}
+
+bool parseRecord(const char* line, size_t length, KeplerElements& elements) {
+    if (length < MIN_RECORD_LENGTH)
+        return false;
+
+    double epoch, meanAnomaly, periapsis, node, inclination, eccentricity, motion, semiMajor;
+    if (!parsePackedEpoch(line + EPOCH_BEGIN, epoch) || !parseField(line, MEAN_ANOMALY, meanAnomaly)
+        || !parseField(line, ARG_PERIHELION, periapsis) || !parseField(line, ASCENDING_NODE, node)
+        || !parseField(line, INCLINATION, inclination) || !parseField(line, ECCENTRICITY, eccentricity)
+        || !parseField(line, MEAN_MOTION, motion) || !parseField(line, SEMI_MAJOR, semiMajor))
+        return false;
+
+    if (!(eccentricity >= 0.0 && eccentricity < 1.0) || !(semiMajor > 0.0) || !(motion > 0.0)
+        || !(inclination >= 0.0 && inclination <= 180.0) || !(meanAnomaly >= 0.0 && meanAnomaly < 360.0)
+        || !(periapsis >= 0.0 && periapsis < 360.0) || !(node >= 0.0 && node < 360.0))
+        return false;
+
+    // Every record is moved to the catalog epoch, J2000.
+    double mean = meanAnomaly * DEG + motion * DEG * (J2000 - epoch);
+    elements.semiMajor = semiMajor;
+    elements.eccentricity = eccentricity;
+    elements.inclination = inclination * DEG;
+    elements.ascendingNode = node * DEG;
+    elements.argPeriapsis = periapsis * DEG;
+    elements.meanAnomaly = mean - TWO_PI * std::nearbyint(mean / TWO_PI);
+    elements.meanMotion = motion * DEG;
+    return true;
+}
+
+struct SliceResult {
+    KeplerOrbitSet orbits;
+    size_t lines = 0;
+    size_t rejected = 0;
+    size_t firstRejected = 0;
+};
+
+void parseSlice(const char* begin, const char* end, SliceResult& result) {
+    result.orbits.clear();
+    result.orbits.reserve(static_cast<size_t>(end - begin) / 200 + 1);
+    result.lines = 0;
+    result.rejected = 0;
+    result.firstRejected = 0;
+
+    KeplerElements elements;
+    while (begin < end) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        const char* lineEnd = newline ? newline : end;
+        size_t length = static_cast<size_t>(lineEnd - begin);
+        if (length > 0 && begin[length - 1] == '\r')
+            --length;
+        ++result.lines;
+
+        if (length > 0) {
+            if (parseRecord(begin, length, elements)) {
+                result.orbits.add(elements);
+            } else {
+                if (result.rejected == 0)
+                    result.firstRejected = result.lines;
+                ++result.rejected;
+            }
+        }
+        begin = newline ? newline + 1 : end;
+    }
+}
+
+template <typename T>
+void appendColumn(AlignedVector<T>& to, const AlignedVector<T>& from) {
+    to.insert(to.end(), from.begin(), from.end());
+}
+
+void appendOrbits(KeplerOrbitSet& to, const KeplerOrbitSet& from) {
+    appendColumn(to.meanAnomalyAtEpoch, from.meanAnomalyAtEpoch);
+    appendColumn(to.meanMotion, from.meanMotion);
+    appendColumn(to.semiMajor, from.semiMajor);
+    appendColumn(to.semiMinor, from.semiMinor);
+    appendColumn(to.eccentricity, from.eccentricity);
+    appendColumn(to.px, from.px);
+    appendColumn(to.py, from.py);
+    appendColumn(to.pz, from.pz);
+    appendColumn(to.qx, from.qx);
+    appendColumn(to.qy, from.qy);
+    appendColumn(to.qz, from.qz);
+}
+
+size_t readChunk(std::ifstream& in, char* buffer, size_t capacity) {
+    in.read(buffer, static_cast<std::streamsize>(capacity));
+    return static_cast<size_t>(in.gcount());
+}
+
+// MPCORB.DAT starts with a text preamble that ends in a row of dashes.
+size_t skipPreamble(const char* data, size_t size, size_t& lines) {
+    const char* rule = "----------";
+    const size_t searchLimit = std::min<size_t>(size, 1 << 16);
+    for (size_t pos = 0; pos < searchLimit;) {
+        const char* newline = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+        size_t next = newline ? static_cast<size_t>(newline - data) + 1 : size;
+        if (next - pos > 10 && std::memcmp(data + pos, rule, 10) == 0) {
+            lines = 0;
+            for (size_t i = 0; i < next; ++i)
+                lines += data[i] == '\n';
+            return next;
+        }
+        pos = next;
+    }
+    return 0;
+}
+
+bool writeCatalog(const std::string& path, const KeplerOrbitSet& orbits) {
+    ElementCatalogHeader header = {};
+    std::memcpy(header.magic, ELEMENT_CATALOG_MAGIC, 8);
+    header.version = ELEMENT_CATALOG_VERSION;
+    header.count = orbits.size();
+    header.epoch = orbits.epoch;
+
+    uint64_t offsets[COLUMN_COUNT];
+    uint64_t fileSize = catalogLayout(header.count, offsets);
+
+    KeplerOrbitView view = orbits.view();
+    const void* columns[COLUMN_COUNT] = { view.meanAnomalyAtEpoch, view.meanMotion, view.semiMajor, view.semiMinor,
+        view.eccentricity, view.px, view.py, view.pz, view.qx, view.qy, view.qz };
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR: cannot write " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    const char zeros[64] = {};
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        out.write(zeros, static_cast<std::streamsize>(offsets[c] - static_cast<uint64_t>(out.tellp())));
+        size_t bytes = orbits.size() * (c < 2 ? sizeof(double) : sizeof(float));
+        out.write(static_cast<const char*>(columns[c]), static_cast<std::streamsize>(bytes));
+    }
+    out.write(zeros, static_cast<std::streamsize>(fileSize - static_cast<uint64_t>(out.tellp())));
+
+    if (!out) {
+        std::cout << "ERROR: failed while writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool ElementCatalog::open(const std::string& path) {
+    close();
+    if (!file.open(path))
+        return false;
+
+    const ElementCatalogHeader* candidate = reinterpret_cast<const ElementCatalogHeader*>(file.data());
+    if (file.size() < sizeof(ElementCatalogHeader) || std::memcmp(candidate->magic, ELEMENT_CATALOG_MAGIC, 8) != 0
+        || candidate->version != ELEMENT_CATALOG_VERSION) {
+        std::cout << "ERROR: " << path << " is not a version " << ELEMENT_CATALOG_VERSION << " element catalog"
+            << std::endl;
+        file.close();
+        return false;
+    }
+
+    uint64_t offsets[COLUMN_COUNT];
+    if (candidate->count > file.size() || catalogLayout(candidate->count, offsets) > file.size()) {
+        std::cout << "ERROR: " << path << " is truncated" << std::endl;
+        file.close();
+        return false;
+    }
+
+    const unsigned char* base = file.data();
+    auto doubles = [&](size_t c) { return reinterpret_cast<const double*>(base + offsets[c]); };
+    auto floats = [&](size_t c) { return reinterpret_cast<const float*>(base + offsets[c]); };
+    columns = { doubles(0), doubles(1), floats(2), floats(3), floats(4), floats(5), floats(6), floats(7),
+        floats(8), floats(9), floats(10) };
+    header = candidate;
+    return true;
+}
+
+void ElementCatalog::close() {
+    file.close();
+    header = nullptr;
+    columns = {};
+}
+
+bool ingestElementCatalog(const std::string& inputPath, const std::string& outputPath, ThreadPool& pool,
+    CatalogIngestStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    stats = CatalogIngestStats();
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cout << "ERROR: cannot open " << inputPath << std::endl;
+        return false;
+    }
+
+    KeplerOrbitSet catalog;
+    catalog.epoch = J2000;
+    std::vector<SliceResult> slices(pool.size() * SLICES_PER_THREAD);
+    std::vector<size_t> bounds(slices.size() + 1);
+
+    std::unique_ptr<char[]> current(new char[CHUNK_SIZE]), next(new char[CHUNK_SIZE]);
+    size_t filled = readChunk(in, current.get(), CHUNK_SIZE);
+    bool atEnd = filled < CHUNK_SIZE;
+    size_t lineBase = 0;
+    size_t skipped = skipPreamble(current.get(), filled, lineBase);
+    stats.bytes = filled;
+
+    while (filled > skipped) {
+        // Parse up to the last complete line and carry the rest over.
+        size_t usable = filled;
+        if (!atEnd) {
+            while (usable > skipped && current[usable - 1] != '\n')
+                --usable;
+            if (usable == skipped)
+                usable = filled;
+        }
+        size_t carry = filled - usable;
+        std::memcpy(next.get(), current.get() + usable, carry);
+
+        size_t nextFilled = carry;
+        bool nextAtEnd = atEnd;
+        std::thread reader;
+        if (!atEnd) {
+            reader = std::thread([&] {
+                size_t got = readChunk(in, next.get() + carry, CHUNK_SIZE - carry);
+                nextFilled += got;
+                nextAtEnd = got < CHUNK_SIZE - carry;
+            });
+        }
+
+        // Slice boundaries snap forward to the next line start.
+        const char* data = current.get();
+        bounds[0] = skipped;
+        for (size_t s = 1; s < slices.size(); ++s) {
+            size_t pos = std::max(bounds[s - 1], skipped + (usable - skipped) * s / slices.size());
+            while (pos < usable && pos > skipped && data[pos - 1] != '\n')
+                ++pos;
+            bounds[s] = pos;
+        }
+        bounds[slices.size()] = usable;
+
+        pool.parallelFor(slices.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s)
+                parseSlice(data + bounds[s], data + bounds[s + 1], slices[s]);
+        });
+
+        if (reader.joinable())
+            reader.join();
+
+        for (const SliceResult& slice : slices) {
+            appendOrbits(catalog, slice.orbits);
+            if (slice.rejected > 0 && stats.rejected == 0)
+                stats.firstRejectedLine = lineBase + slice.firstRejected;
+            stats.rejected += slice.rejected;
+            lineBase += slice.lines;
+        }
+
+        std::swap(current, next);
+        stats.bytes += nextFilled - carry;
+        filled = nextFilled;
+        atEnd = nextAtEnd;
+        skipped = 0;
+    }
+
+    stats.records = catalog.size();
+    if (catalog.size() == 0) {
+        std::cout << "ERROR: " << inputPath << " has no valid element records" << std::endl;
+        return false;
+    }
+    bool written = writeCatalog(outputPath, catalog);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return written;
+}
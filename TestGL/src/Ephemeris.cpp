@@ -0,0 +1,173 @@
+#include "Ephemeris.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+uint64_t alignTo64(uint64_t offset) {
+    return (offset + 63) & ~uint64_t(63);
+}
+
+}
+
+bool Ephemeris::open(const std::string& path) {
+    close();
+    if (!file.open(path))
+        return false;
+
+    const unsigned char* base = file.data();
+    const EphemerisHeader* candidate = reinterpret_cast<const EphemerisHeader*>(base);
+    if (file.size() < sizeof(EphemerisHeader) || std::memcmp(candidate->magic, EPHEMERIS_MAGIC, 8) != 0
+        || candidate->version != EPHEMERIS_VERSION) {
+        std::cout << "ERROR: " << path << " is not a version " << EPHEMERIS_VERSION << " ephemeris" << std::endl;
+        file.close();
+        return false;
+    }
+
+    // Check every body's block lies inside the file once, so lookups need no checks.
+    uint64_t indexEnd = sizeof(EphemerisHeader) + uint64_t(candidate->bodyCount) * sizeof(EphemerisBodyEntry);
+    bool valid = indexEnd <= file.size();
+    const EphemerisBodyEntry* index = reinterpret_cast<const EphemerisBodyEntry*>(base + sizeof(EphemerisHeader));
+    for (uint32_t i = 0; valid && i < candidate->bodyCount; ++i) {
+        const EphemerisBodyEntry& entry = index[i];
+        uint64_t bytes = uint64_t(entry.segmentCount) * entry.coefficientCount * 3 * sizeof(double);
+        valid = entry.segmentCount > 0 && entry.coefficientCount > 0 && entry.coefficientCount <= 64
+            && entry.segmentDays > 0.0 && entry.dataOffset % 8 == 0 && entry.dataOffset >= indexEnd
+            && entry.dataOffset + bytes <= file.size() && entry.parent < static_cast<int32_t>(i)
+            && entry.name[sizeof(entry.name) - 1] == '\0';
+    }
+    if (!valid) {
+        std::cout << "ERROR: " << path << " is truncated or corrupt" << std::endl;
+        file.close();
+        return false;
+    }
+
+    header = candidate;
+    entries = index;
+    return true;
+}
+
+void Ephemeris::close() {
+    file.close();
+    header = nullptr;
+    entries = nullptr;
+}
+
+bool Ephemeris::covers(double julianDate) const {
+    return header && julianDate >= header->startTime && julianDate <= header->endTime;
+}
+
+glm::dvec3 Ephemeris::relativePosition(size_t index, double julianDate) const {
+    const EphemerisBodyEntry& entry = entries[index];
+    const uint32_t n = entry.coefficientCount;
+
+    double t = (julianDate - header->startTime) / entry.segmentDays;
+    double segment = std::floor(t);
+    segment = std::min(std::max(segment, 0.0), static_cast<double>(entry.segmentCount - 1));
+    const double tau = 2.0 * (t - segment) - 1.0;
+
+    const double* c = reinterpret_cast<const double*>(file.data() + entry.dataOffset)
+        + static_cast<size_t>(segment) * n * 3;
+
+    // Clenshaw recurrence for all three axes at once.
+    double bx1 = 0.0, bx2 = 0.0, by1 = 0.0, by2 = 0.0, bz1 = 0.0, bz2 = 0.0;
+    const double twoTau = 2.0 * tau;
+    for (uint32_t k = n - 1; k > 0; --k) {
+        double bx = twoTau * bx1 - bx2 + c[k];
+        double by = twoTau * by1 - by2 + c[n + k];
+        double bz = twoTau * bz1 - bz2 + c[2 * n + k];
+        bx2 = bx1; bx1 = bx;
+        by2 = by1; by1 = by;
+        bz2 = bz1; bz1 = bz;
+    }
+    return glm::dvec3(tau * bx1 - bx2 + c[0], tau * by1 - by2 + c[n], tau * bz1 - bz2 + c[2 * n]);
+}
+
+void Ephemeris::evaluateRelative(double julianDate, float* x, float* y, float* z) const {
+    for (size_t i = 0; i < bodyCount(); ++i) {
+        glm::dvec3 p = relativePosition(i, julianDate);
+        x[i] = static_cast<float>(p.x);
+        y[i] = static_cast<float>(p.y);
+        z[i] = static_cast<float>(p.z);
+    }
+}
+
+bool writeEphemeris(const std::string& path, const std::vector<EphemerisBodySpec>& bodies,
+    double startTime, double endTime, const EphemerisSampler& sampler) {
+    if (!(endTime > startTime)) {
+        std::cout << "ERROR: ephemeris end time must be after its start" << std::endl;
+        return false;
+    }
+
+    EphemerisHeader header = {};
+    std::memcpy(header.magic, EPHEMERIS_MAGIC, 8);
+    header.version = EPHEMERIS_VERSION;
+    header.bodyCount = static_cast<uint32_t>(bodies.size());
+    header.startTime = startTime;
+    header.endTime = endTime;
+
+    std::vector<EphemerisBodyEntry> entries(bodies.size());
+    uint64_t offset = alignTo64(sizeof(EphemerisHeader) + bodies.size() * sizeof(EphemerisBodyEntry));
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        const EphemerisBodySpec& spec = bodies[i];
+        EphemerisBodyEntry& entry = entries[i];
+        std::memcpy(entry.name, spec.name.c_str(), std::min(spec.name.size(), sizeof(entry.name) - 1));
+        entry.parent = spec.parent;
+        entry.coefficientCount = std::max<uint32_t>(spec.coefficientCount, 1);
+        entry.segmentCount = static_cast<uint32_t>(std::ceil((endTime - startTime) / spec.segmentDays));
+        entry.segmentDays = spec.segmentDays;
+        entry.dataOffset = offset;
+        offset = alignTo64(offset + uint64_t(entry.segmentCount) * entry.coefficientCount * 3 * sizeof(double));
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR: cannot write " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(EphemerisBodyEntry));
+
+    std::vector<double> coefficients;
+    std::vector<glm::dvec3> samples;
+    const char zeros[64] = {};
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        const EphemerisBodyEntry& entry = entries[i];
+        const uint32_t n = entry.coefficientCount;
+        out.write(zeros, static_cast<std::streamsize>(entry.dataOffset - static_cast<uint64_t>(out.tellp())));
+
+        samples.resize(n);
+        coefficients.resize(size_t(entry.segmentCount) * n * 3);
+        for (uint32_t s = 0; s < entry.segmentCount; ++s) {
+            double segmentStart = startTime + s * entry.segmentDays;
+            for (uint32_t j = 0; j < n; ++j) {
+                double node = std::cos(PI * (j + 0.5) / n);
+                samples[j] = sampler(i, segmentStart + 0.5 * (node + 1.0) * entry.segmentDays);
+            }
+
+            double* c = coefficients.data() + size_t(s) * n * 3;
+            for (uint32_t k = 0; k < n; ++k) {
+                glm::dvec3 sum(0.0);
+                for (uint32_t j = 0; j < n; ++j)
+                    sum += samples[j] * std::cos(PI * k * (j + 0.5) / n);
+                sum *= (k == 0 ? 1.0 : 2.0) / n;
+                c[k] = sum.x;
+                c[n + k] = sum.y;
+                c[2 * n + k] = sum.z;
+            }
+        }
+        out.write(reinterpret_cast<const char*>(coefficients.data()), coefficients.size() * sizeof(double));
+    }
+    out.write(zeros, static_cast<std::streamsize>(offset - static_cast<uint64_t>(out.tellp())));
+
+    if (!out) {
+        std::cout << "ERROR: failed while writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#include "FrustumCulling.h"
+#include "KeplerPropagator.h"
+
+namespace {
+
+struct ScalarOps {
+    using F = float;
+    using M = bool;
+    static constexpr int width = 1;
+
+    static F set1(float v) { return v; }
+    static F loadu(const float* p) { return *p; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F neg(F a) { return -a; }
+    static F fmadd(F a, F b, F c) { return a * b + c; }
+    static M cmpGt(F a, F b) { return a > b; }
+    static M maskAnd(M a, M b) { return a && b; }
+    static size_t appendIndices(M m, uint32_t first, uint32_t* out) {
+        *out = first;
+        return m ? 1 : 0;
+    }
+};
+
+}
+
+size_t cullSpheresScalar(const SphereBoundsView& spheres, const float* planes, size_t begin, size_t end,
+    uint32_t* visible) {
+    return frustumKernel<ScalarOps>(spheres, planes, begin, end, visible);
+}
+
+// Gribb and Hartmann: each face is the last row of the matrix plus or minus
+// one of the others.
+ViewFrustum frustumFromMatrix(const glm::mat4& viewProjection) {
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r)
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+    ViewFrustum frustum;
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = 0; side < 2; ++side) {
+            glm::vec4 plane = side == 0 ? rows[3] + rows[axis] : rows[3] - rows[axis];
+            float length = glm::length(glm::vec3(plane));
+            frustum.faces[2 * axis + side] = { glm::vec3(plane) / length, -plane.w / length };
+        }
+    }
+    return frustum;
+}
+
+FrustumCuller::FrustumCuller() : simdLevel(detectSimdLevel()) {}
+
+FrustumCuller::FrustumCuller(SimdLevel level) : simdLevel(level) {
+    if (level > detectSimdLevel())
+        simdLevel = detectSimdLevel();
+}
+
+size_t FrustumCuller::cull(const ViewFrustum& frustum, const SphereBounds& spheres) {
+    tested = spheres.size();
+    if (indices.size() < tested)
+        indices.resize(tested);
+    const float* planes = &frustum.faces[0].normal.x;
+
+    switch (simdLevel) {
+    case SimdLevel::AVX512:
+        visibleTotal = cullSpheresAvx512(spheres.view(), planes, 0, tested, indices.data());
+        break;
+    case SimdLevel::AVX2:
+        visibleTotal = cullSpheresAvx2(spheres.view(), planes, 0, tested, indices.data());
+        break;
+    default:
+        visibleTotal = cullSpheresScalar(spheres.view(), planes, 0, tested, indices.data());
+        break;
+    }
+    return visibleTotal;
+}
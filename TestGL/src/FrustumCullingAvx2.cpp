@@ -0,0 +1,48 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "FrustumKernel.h"
+
+namespace {
+
+struct Avx2Ops {
+    using F = __m256;
+    using M = __m256;
+    static constexpr int width = 8;
+
+    static F set1(float v) { return _mm256_set1_ps(v); }
+    static F loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F neg(F a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static F fmadd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+    static M cmpGt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static M maskAnd(M a, M b) { return _mm256_and_ps(a, b); }
+
+    // Every lane is stored and only the set ones advance the output, so
+    // there is no branch per sphere.
+    static size_t appendIndices(M m, uint32_t first, uint32_t* out) {
+        const unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(m));
+        size_t count = 0;
+        for (unsigned lane = 0; lane < 8; ++lane) {
+            out[count] = first + lane;
+            count += (bits >> lane) & 1;
+        }
+        return count;
+    }
+};
+
+}
+
+size_t cullSpheresAvx2(const SphereBoundsView& spheres, const float* planes, size_t begin, size_t end,
+    uint32_t* visible) {
+    return frustumKernel<Avx2Ops>(spheres, planes, begin, end, visible);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,43 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f,popcnt")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,popcnt"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "FrustumKernel.h"
+
+namespace {
+
+struct Avx512Ops {
+    using F = __m512;
+    using M = __mmask16;
+    static constexpr int width = 16;
+
+    static F set1(float v) { return _mm512_set1_ps(v); }
+    static F loadu(const float* p) { return _mm512_loadu_ps(p); }
+    static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    static F neg(F a) { return _mm512_sub_ps(_mm512_setzero_ps(), a); }
+    static F fmadd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+    static M cmpGt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static M maskAnd(M a, M b) { return static_cast<M>(a & b); }
+
+    static size_t appendIndices(M m, uint32_t first, uint32_t* out) {
+        const __m512i lanes = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(first)),
+            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        _mm512_mask_compressstoreu_epi32(out, m, lanes);
+        return static_cast<size_t>(_mm_popcnt_u32(m));
+    }
+};
+
+}
+
+size_t cullSpheresAvx512(const SphereBoundsView& spheres, const float* planes, size_t begin, size_t end,
+    uint32_t* visible) {
+    return frustumKernel<Avx512Ops>(spheres, planes, begin, end, visible);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,320 @@
+#include "InstanceCuller.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const GLuint CULL_GROUP_SIZE = 64;      // local_size_x of cull_compute.glsl
+const GLuint REDUCE_GROUP_SIZE = 8;     // local_size_x and _y of hiz_reduce_compute.glsl
+// The cull packs each survivor's slot in its level into 24 bits.
+const size_t MAX_GPU_INSTANCES = size_t(1) << 24;
+
+float boundingRadius(const glm::mat4& model) {
+    return std::max(glm::length(glm::vec3(model[0])),
+        std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+}
+
+}
+
+static_assert(sizeof(CullBlock::lodErrors) == MAX_SPHERE_LODS * sizeof(float), "Cull.lodErrors holds every level");
+
+InstanceCuller::InstanceCuller(const Sphere& unitSphere, bool allowGpu)
+    : indexCount(unitSphere.indexCount), indexType(unitSphere.indexType), lods(unitSphere.lods),
+      levels(unitSphere.lods.size()) {
+    // Compute shaders, storage buffers and indirect multi-draw are all GL 4.3.
+    gpu = allowGpu && GLAD_GL_VERSION_4_3;
+    if (gpu) {
+        createGpuResources(unitSphere);
+        return;
+    }
+    for (size_t level = 0; level < levels; ++level)
+        batches.push_back(std::make_unique<SphereBatch>(unitSphere, true, level));
+    lodCounts.resize(levels);
+}
+
+InstanceCuller::~InstanceCuller() {
+    if (!gpu)
+        return;
+    glDeleteVertexArrays(1, &drawVAO);
+    glDeleteVertexArrays(1, &occluderVAO);
+    glDeleteBuffers(1, &visibleBuffer);
+    glDeleteBuffers(1, &lodBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &cullBuffer.id);
+    glDeleteFramebuffers(1, &pyramidFBO);
+    glDeleteRenderbuffers(1, &pyramidDepth);
+    glDeleteTextures(1, &pyramid);
+}
+
+void InstanceCuller::createGpuResources(const Sphere& unitSphere) {
+    cullProgram = std::make_unique<Shader>("shaders/cull_compute.glsl");
+    scatterProgram = std::make_unique<Shader>("shaders/cull_scatter_compute.glsl");
+    depthProgram = std::make_unique<Shader>("shaders/hiz_depth_vertex.glsl", "shaders/hiz_depth_fragment.glsl");
+    reduceProgram = std::make_unique<Shader>("shaders/hiz_reduce_compute.glsl");
+    checkBlockLayouts(*cullProgram, "cull");
+    checkBlockLayouts(*scatterProgram, "cull scatter");
+    checkBlockLayouts(*depthProgram, "hiz depth");
+    cullProgram->use();
+    cullProgram->setInt("depthPyramid", 0);
+    depthProgram->use();
+    depthProgram->setBool("compactVertices", unitSphere.compact);
+    cullBuffer.create(CULL_BLOCK_BINDING, sizeof(CullBlock));
+
+    // Instances are read as a storage buffer range, whose offset has its own
+    // alignment; uploads are padded to it so every stream region starts on one.
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    storageAlignment = static_cast<size_t>(std::max(alignment, 1));
+    GLint groupLimit = 65535;
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &groupLimit);
+    maxGroups = static_cast<GLuint>(std::max(groupLimit, 1));
+    input = std::make_unique<StreamBuffer>(GL_SHADER_STORAGE_BUFFER);
+
+    // A DrawElementsIndirectCommand per level: count, instanceCount,
+    // firstIndex, baseVertex, baseInstance. The cull fills in instanceCount
+    // and baseInstance.
+    for (size_t level = 0; level < levels; ++level) {
+        const GLuint command[5] = { lods[level].indexCount, 0, lods[level].firstIndex, 0, 0 };
+        commands.insert(commands.end(), command, command + 5);
+    }
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(commands.size() * sizeof(GLuint)),
+        commands.data(), GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &visibleBuffer);
+    glGenBuffers(1, &lodBuffer);
+
+    glGenVertexArrays(1, &drawVAO);
+    glBindVertexArray(drawVAO);
+    bindSphereVertices(unitSphere);
+    bindSphereInstances(visibleBuffer, 0);
+    glGenVertexArrays(1, &occluderVAO);
+    glBindVertexArray(occluderVAO);
+    bindSphereVertices(unitSphere);
+    glBindVertexArray(0);
+
+    pyramidLevels = 1;
+    while ((std::max(HIZ_WIDTH, HIZ_HEIGHT) >> pyramidLevels) > 0)
+        ++pyramidLevels;
+    glGenTextures(1, &pyramid);
+    glBindTexture(GL_TEXTURE_2D, pyramid);
+    glTexStorage2D(GL_TEXTURE_2D, pyramidLevels, GL_R32F, HIZ_WIDTH, HIZ_HEIGHT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGenRenderbuffers(1, &pyramidDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, pyramidDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, HIZ_WIDTH, HIZ_HEIGHT);
+    glGenFramebuffers(1, &pyramidFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pyramidFBO);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pyramid, 0);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, pyramidDepth);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR: depth pyramid framebuffer is incomplete" << std::endl;
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+}
+
+SphereInstance* InstanceCuller::beginUpload(size_t count) {
+    instanceCount = count;
+    if (!gpu) {
+        instances.resize(count);
+        return instances.data();
+    }
+    size_t bytes = count * sizeof(SphereInstance);
+    bytes = (bytes + storageAlignment - 1) / storageAlignment * storageAlignment;
+    return static_cast<SphereInstance*>(input->begin(bytes));
+}
+
+void InstanceCuller::endUpload() {
+    if (!gpu)
+        return;
+    inputOffset = input->end();
+    glBindVertexArray(occluderVAO);
+    bindSphereInstances(input->id, inputOffset);
+    glBindVertexArray(0);
+
+    if (instanceCount > visibleCapacity) {
+        if (instanceCount > MAX_GPU_INSTANCES) {
+            std::cout << "ERROR: the GPU cull handles at most " << MAX_GPU_INSTANCES << " instances; the other "
+                << instanceCount - MAX_GPU_INSTANCES << " are not drawn" << std::endl;
+        }
+        visibleCapacity = std::max(instanceCount, visibleCapacity * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(visibleCapacity * sizeof(SphereInstance)),
+            nullptr, GL_DYNAMIC_COPY);
+        // Growing forgets every instance's last level.
+        const GLuint none = ~0u;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, lodBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(visibleCapacity * 2 * sizeof(GLuint)),
+            nullptr, GL_DYNAMIC_COPY);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &none);
+    }
+}
+
+void InstanceCuller::cull(const glm::mat4& view, const glm::mat4& projection, int viewportHeight,
+    size_t occluderCount) {
+    ViewFrustum frustum = frustumFromMatrix(projection * view);
+    float focalPixels = projection[1][1] * static_cast<float>(viewportHeight) * 0.5f;
+    if (!gpu) {
+        cullOnCpu(frustum, glm::vec3(glm::inverse(view)[3]), focalPixels);
+        return;
+    }
+
+    bool useHiZ = occlusion && occluderCount > 0;
+    CullBlock block = CullBlock();
+    block.view = view;
+    block.projection = projection;
+    for (int i = 0; i < 6; ++i)
+        block.planes[i] = glm::vec4(frustum.faces[i].normal, -frustum.faces[i].distance);
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    block.hiz = glm::vec4(HIZ_WIDTH, HIZ_HEIGHT, pyramidLevels, nearPlane);
+    const size_t culled = std::min(instanceCount, MAX_GPU_INSTANCES);
+    block.counts = glm::ivec4(static_cast<int>(culled), useHiZ ? 1 : 0, static_cast<int>(levels), 0);
+    block.lod = glm::vec4(focalPixels, lod.pixelError, lod.hysteresis, 0.0f);
+    for (size_t level = 0; level < levels; ++level)
+        block.lodErrors[level / 4][level % 4] = lods[level].error;
+    cullBuffer.upload(&block, sizeof(block));
+
+    if (useHiZ)
+        buildPyramid(std::min(occluderCount, instanceCount));
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(commands.size() * sizeof(GLuint)),
+        commands.data());
+    if (instanceCount == 0)
+        return;
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, input->id, static_cast<GLintptr>(inputOffset),
+        static_cast<GLsizeiptr>(instanceCount * sizeof(SphereInstance)));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lodBuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pyramid);
+    dispatchPerInstance(*cullProgram, culled);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    dispatchPerInstance(*scatterProgram, culled);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+// One invocation per instance. A dispatch holds at most maxGroups groups
+// (65535 on some 4.3 drivers, about four million instances), so larger
+// counts go out in several, each told where its range starts.
+void InstanceCuller::dispatchPerInstance(Shader& program, size_t count) {
+    program.use();
+    const size_t perDispatch = static_cast<size_t>(maxGroups) * CULL_GROUP_SIZE;
+    for (size_t first = 0; first < count; first += perDispatch) {
+        size_t n = std::min(perDispatch, count - first);
+        program.setInt("firstInstance", static_cast<int>(first));
+        glDispatchCompute(static_cast<GLuint>((n + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+    }
+}
+
+// Draws the occluders into level 0, then builds each level from the one
+// below.
+void InstanceCuller::buildPyramid(size_t occluderCount) {
+    GLint previousFramebuffer = 0, viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pyramidFBO);
+    glViewport(0, 0, HIZ_WIDTH, HIZ_HEIGHT);
+    const float farthest = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, &farthest);
+    glClearBufferfv(GL_DEPTH, 0, &farthest);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    depthProgram->use();
+    glBindVertexArray(occluderVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, static_cast<GLsizei>(occluderCount));
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    reduceProgram->use();
+    for (int level = 1; level < pyramidLevels; ++level) {
+        glBindImageTexture(0, pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        GLuint width = std::max(HIZ_WIDTH >> level, 1), height = std::max(HIZ_HEIGHT >> level, 1);
+        glDispatchCompute((width + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE,
+            (height + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void InstanceCuller::cullOnCpu(const ViewFrustum& frustum, const glm::vec3& eye, float focalPixels) {
+    bounds.resize(instanceCount);
+    for (size_t i = 0; i < instanceCount; ++i)
+        bounds.set(i, glm::vec3(instances[i].model[3]), boundingRadius(instances[i].model));
+    size_t visible = frustumCuller.cull(frustum, bounds);
+
+    const uint32_t* indices = frustumCuller.visible();
+    instanceLods.resize(instanceCount, -1);
+    visibleLods.resize(visible);
+    std::fill(lodCounts.begin(), lodCounts.end(), 0);
+    for (size_t k = 0; k < visible; ++k) {
+        uint32_t i = indices[k];
+        glm::vec3 centre(bounds.x[i], bounds.y[i], bounds.z[i]);
+        float screenRadius = projectedSphereRadius(focalPixels, glm::length(centre - eye), bounds.radius[i]);
+        int level = selectSphereLod(lods, screenRadius, instanceLods[i], lod);
+        instanceLods[i] = level;
+        visibleLods[k] = level;
+        ++lodCounts[level];
+    }
+
+    SphereInstance* out[MAX_SPHERE_LODS];
+    for (size_t level = 0; level < levels; ++level)
+        out[level] = batches[level]->beginUpload(lodCounts[level]);
+    for (size_t k = 0; k < visible; ++k)
+        *out[visibleLods[k]]++ = instances[indices[k]];
+    for (size_t level = 0; level < levels; ++level)
+        batches[level]->endUpload();
+}
+
+DrawGeometry InstanceCuller::geometry(size_t draw) const {
+    if (!gpu)
+        return batches[draw]->geometry();
+    DrawGeometry geometry;
+    geometry.vertexArray = drawVAO;
+    geometry.mode = GL_TRIANGLES;
+    geometry.count = static_cast<GLsizei>(indexCount);
+    geometry.indexType = indexType;
+    geometry.indirectBuffer = commandBuffer;
+    geometry.drawCount = static_cast<GLsizei>(levels);
+    return geometry;
+}
+
+size_t InstanceCuller::readVisibleCount() const {
+    size_t visible = 0;
+    for (size_t count : readLodCounts())
+        visible += count;
+    return visible;
+}
+
+std::vector<size_t> InstanceCuller::readLodCounts() const {
+    if (!gpu)
+        return lodCounts;
+    std::vector<GLuint> written(commands.size());
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(written.size() * sizeof(GLuint)),
+        written.data());
+    std::vector<size_t> counts(levels);
+    for (size_t level = 0; level < levels; ++level)
+        counts[level] = written[level * 5 + 1];
+    return counts;
+}
+
+size_t InstanceCuller::readTriangleCount() const {
+    std::vector<size_t> counts = readLodCounts();
+    size_t triangles = 0;
+    for (size_t level = 0; level < levels; ++level)
+        triangles += counts[level] * (lods[level].indexCount / 3);
+    return triangles;
+}
@@ -0,0 +1,59 @@
+#include "JulianDate.h"
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+double calendarToJulianDate(int year, int month, double day) {
+    if (month <= 2) {
+        year -= 1;
+        month += 12;
+    }
+    int a = static_cast<int>(std::floor(year / 100.0));
+    int b = 2 - a + static_cast<int>(std::floor(a / 4.0));
+    return std::floor(365.25 * (year + 4716)) + std::floor(30.6001 * (month + 1)) + day + b - 1524.5;
+}
+
+void julianDateToCalendar(double jd, int& year, int& month, double& day) {
+    double z = std::floor(jd + 0.5);
+    double f = jd + 0.5 - z;
+    double alpha = std::floor((z - 1867216.25) / 36524.25);
+    double a = z + 1 + alpha - std::floor(alpha / 4.0);
+    double b = a + 1524;
+    double c = std::floor((b - 122.1) / 365.25);
+    double d = std::floor(365.25 * c);
+    double e = std::floor((b - d) / 30.6001);
+
+    day = b - d - std::floor(30.6001 * e) + f;
+    month = static_cast<int>(e < 14 ? e - 1 : e - 13);
+    year = static_cast<int>(month > 2 ? c - 4716 : c - 4715);
+}
+
+double currentJulianDate() {
+    // The Unix epoch is JD 2440587.5.
+    return 2440587.5 + static_cast<double>(std::time(nullptr)) / 86400.0;
+}
+
+std::string formatJulianDate(double jd) {
+    int year, month;
+    double day;
+    // Round to the nearest minute before splitting so 12:00 never prints as 11:59.
+    julianDateToCalendar(jd + 0.5 / 1440.0, year, month, day);
+
+    int wholeDay = static_cast<int>(day);
+    int minutes = static_cast<int>((day - wholeDay) * 1440.0);
+    char text[48];
+    std::snprintf(text, sizeof(text), "%d-%02d-%02d %02d:%02d", year, month, wholeDay, minutes / 60, minutes % 60);
+    return text;
+}
+
+bool parseCalendarDate(const char* text, double& jd) {
+    int year, month, day, hour = 0, minute = 0;
+    int fields = std::sscanf(text, "%d-%d-%dT%d:%d", &year, &month, &day, &hour, &minute);
+    if (fields != 3 && fields != 5)
+        return false;
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23 || minute < 0 || minute > 59)
+        return false;
+
+    jd = calendarToJulianDate(year, month, day + (hour + minute / 60.0) / 24.0);
+    return true;
+}
@@ -0,0 +1,256 @@
+#include "KeplerPropagator.h"
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+const double TWO_PI = 6.283185307179586;
+
+struct ScalarOps {
+    using F = float;
+    using M = bool;
+    static constexpr int width = 1;
+
+    static F set1(float v) { return v; }
+    static F load(const float* p) { return *p; }
+    static F loadu(const float* p) { return *p; }
+    static void storeu(float* p, F v) { *p = v; }
+    static F add(F a, F b) { return a + b; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F div(F a, F b) { return a / b; }
+    static F neg(F a) { return -a; }
+    static F fmadd(F a, F b, F c) { return a * b + c; }
+    static F fnmadd(F a, F b, F c) { return c - a * b; }
+    static F round(F a) { return std::nearbyint(a); }
+    static F floor(F a) { return std::floor(a); }
+    static M cmpEq(F a, F b) { return a == b; }
+    static M cmpGe(F a, F b) { return a >= b; }
+    static F select(M m, F a, F b) { return m ? a : b; }
+
+    static void meanAnomaly(const double* m0, const double* n, double dt, float* out) {
+        double m = m0[0] + n[0] * dt;
+        m -= TWO_PI * std::nearbyint(m / TWO_PI);
+        out[0] = static_cast<float>(m);
+    }
+};
+
+}
+
+void propagateKeplerScalar(const KeplerOrbitView& orbits, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations) {
+    keplerKernel<ScalarOps>(orbits, dt, x, y, z, begin, end, iterations);
+}
+
+size_t KeplerOrbitSet::add(const KeplerElements& elements) {
+    size_t index = size();
+    meanAnomalyAtEpoch.push_back(0.0);
+    meanMotion.push_back(0.0);
+    semiMajor.push_back(0.0f);
+    semiMinor.push_back(0.0f);
+    eccentricity.push_back(0.0f);
+    px.push_back(0.0f);
+    py.push_back(0.0f);
+    pz.push_back(0.0f);
+    qx.push_back(0.0f);
+    qy.push_back(0.0f);
+    qz.push_back(0.0f);
+    set(index, elements);
+    return index;
+}
+
+void KeplerOrbitSet::set(size_t index, const KeplerElements& elements) {
+    double cosNode = std::cos(elements.ascendingNode), sinNode = std::sin(elements.ascendingNode);
+    double cosPeri = std::cos(elements.argPeriapsis), sinPeri = std::sin(elements.argPeriapsis);
+    double cosInc = std::cos(elements.inclination), sinInc = std::sin(elements.inclination);
+
+    // Ecliptic P/Q, then swizzled so the ecliptic pole becomes scene +y.
+    double Px = cosNode * cosPeri - sinNode * sinPeri * cosInc;
+    double Py = sinNode * cosPeri + cosNode * sinPeri * cosInc;
+    double Pz = sinPeri * sinInc;
+    double Qx = -cosNode * sinPeri - sinNode * cosPeri * cosInc;
+    double Qy = -sinNode * sinPeri + cosNode * cosPeri * cosInc;
+    double Qz = cosPeri * sinInc;
+
+    meanAnomalyAtEpoch[index] = elements.meanAnomaly;
+    meanMotion[index] = elements.meanMotion;
+    semiMajor[index] = static_cast<float>(elements.semiMajor);
+    semiMinor[index] = static_cast<float>(elements.semiMajor * std::sqrt(1.0 - elements.eccentricity * elements.eccentricity));
+    eccentricity[index] = static_cast<float>(elements.eccentricity);
+    px[index] = static_cast<float>(Px);
+    py[index] = static_cast<float>(Pz);
+    pz[index] = static_cast<float>(Py);
+    qx[index] = static_cast<float>(Qx);
+    qy[index] = static_cast<float>(Qz);
+    qz[index] = static_cast<float>(Qy);
+}
+
+void KeplerOrbitSet::reserve(size_t count) {
+    meanAnomalyAtEpoch.reserve(count);
+    meanMotion.reserve(count);
+    semiMajor.reserve(count);
+    semiMinor.reserve(count);
+    eccentricity.reserve(count);
+    px.reserve(count);
+    py.reserve(count);
+    pz.reserve(count);
+    qx.reserve(count);
+    qy.reserve(count);
+    qz.reserve(count);
+}
+
+void KeplerOrbitSet::clear() {
+    meanAnomalyAtEpoch.clear();
+    meanMotion.clear();
+    semiMajor.clear();
+    semiMinor.clear();
+    eccentricity.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    qx.clear();
+    qy.clear();
+    qz.clear();
+}
+
+KeplerOrbitView KeplerOrbitSet::view() const {
+    return { meanAnomalyAtEpoch.data(), meanMotion.data(), semiMajor.data(), semiMinor.data(), eccentricity.data(),
+        px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data() };
+}
+
+KeplerPropagator::KeplerPropagator() : simdLevel(detectSimdLevel()) {}
+
+KeplerPropagator::KeplerPropagator(SimdLevel level) : simdLevel(level) {
+    if (level > detectSimdLevel())
+        simdLevel = detectSimdLevel();
+}
+
+void KeplerPropagator::propagate(const KeplerOrbitSet& orbits, double time, float* x, float* y, float* z) const {
+    propagateRange(orbits, time, x, y, z, 0, orbits.size());
+}
+
+void KeplerPropagator::propagateRange(const KeplerOrbitSet& orbits, double time, float* x, float* y, float* z,
+    size_t begin, size_t end) const {
+    propagateRange(orbits.view(), orbits.epoch, time, x, y, z, begin, end);
+}
+
+void KeplerPropagator::propagateRange(const KeplerOrbitView& view, double epoch, double time, float* x, float* y,
+    float* z, size_t begin, size_t end) const {
+    double dt = time - epoch;
+
+    switch (simdLevel) {
+    case SimdLevel::AVX512:
+        propagateKeplerAvx512(view, dt, x, y, z, begin, end, iterations);
+        break;
+    case SimdLevel::AVX2:
+        propagateKeplerAvx2(view, dt, x, y, z, begin, end, iterations);
+        break;
+    default:
+        propagateKeplerScalar(view, dt, x, y, z, begin, end, iterations);
+        break;
+    }
+}
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel detected = [] {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return SimdLevel::Scalar;
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool fma = (info[2] & (1 << 12)) != 0;
+        if (!osxsave)
+            return SimdLevel::Scalar;
+
+        unsigned long long xcr0 = _xgetbv(0);
+        bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+        bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        bool avx512f = (info[1] & (1 << 16)) != 0;
+
+        if (avx512f && zmmEnabled)
+            return SimdLevel::AVX512;
+        if (avx2 && fma && ymmEnabled)
+            return SimdLevel::AVX2;
+        return SimdLevel::Scalar;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return SimdLevel::AVX2;
+        return SimdLevel::Scalar;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }();
+    return detected;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512: return "AVX-512";
+    case SimdLevel::AVX2: return "AVX2";
+    default: return "scalar";
+    }
+}
+
+static void perifocalAxes(const KeplerElements& elements, glm::dvec3& P, glm::dvec3& Q) {
+    double cosNode = std::cos(elements.ascendingNode), sinNode = std::sin(elements.ascendingNode);
+    double cosPeri = std::cos(elements.argPeriapsis), sinPeri = std::sin(elements.argPeriapsis);
+    double cosInc = std::cos(elements.inclination), sinInc = std::sin(elements.inclination);
+
+    P = glm::dvec3(cosNode * cosPeri - sinNode * sinPeri * cosInc, sinPeri * sinInc,
+        sinNode * cosPeri + cosNode * sinPeri * cosInc);
+    Q = glm::dvec3(-cosNode * sinPeri - sinNode * cosPeri * cosInc, cosPeri * sinInc,
+        -sinNode * sinPeri + cosNode * cosPeri * cosInc);
+}
+
+glm::dvec3 keplerPositionAtAnomaly(const KeplerElements& elements, double eccentricAnomaly) {
+    glm::dvec3 P, Q;
+    perifocalAxes(elements, P, Q);
+
+    double e = elements.eccentricity;
+    double X = elements.semiMajor * (std::cos(eccentricAnomaly) - e);
+    double Y = elements.semiMajor * std::sqrt(1.0 - e * e) * std::sin(eccentricAnomaly);
+    return P * X + Q * Y;
+}
+
+static double solveKeplerEquation(const KeplerElements& elements, double timeSinceEpoch) {
+    double M = elements.meanAnomaly + elements.meanMotion * timeSinceEpoch;
+    M -= TWO_PI * std::nearbyint(M / TWO_PI);
+
+    double e = elements.eccentricity;
+    double E = M + 0.85 * e * (std::sin(M) >= 0.0 ? 1.0 : -1.0);
+    for (int k = 0; k < 50; ++k) {
+        double dE = (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+        E -= dE;
+        if (std::abs(dE) < 1e-15)
+            break;
+    }
+    return E;
+}
+
+glm::dvec3 keplerPosition(const KeplerElements& elements, double timeSinceEpoch) {
+    return keplerPositionAtAnomaly(elements, solveKeplerEquation(elements, timeSinceEpoch));
+}
+
+glm::dvec3 keplerVelocity(const KeplerElements& elements, double timeSinceEpoch) {
+    glm::dvec3 P, Q;
+    perifocalAxes(elements, P, Q);
+
+    double E = solveKeplerEquation(elements, timeSinceEpoch);
+    double e = elements.eccentricity;
+    double rate = elements.meanMotion / (1.0 - e * std::cos(E));
+    double dX = -elements.semiMajor * std::sin(E) * rate;
+    double dY = elements.semiMajor * std::sqrt(1.0 - e * e) * std::cos(E) * rate;
+    return P * dX + Q * dY;
+}
@@ -0,0 +1,56 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "KeplerKernel.h"
+
+namespace {
+
+struct Avx2Ops {
+    using F = __m256;
+    using M = __m256;
+    static constexpr int width = 8;
+
+    static F set1(float v) { return _mm256_set1_ps(v); }
+    static F load(const float* p) { return _mm256_load_ps(p); }
+    static F loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static void storeu(float* p, F v) { _mm256_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm256_div_ps(a, b); }
+    static F neg(F a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static F fmadd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+    static F fnmadd(F a, F b, F c) { return _mm256_fnmadd_ps(a, b, c); }
+    static F round(F a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static F floor(F a) { return _mm256_floor_ps(a); }
+    static M cmpEq(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static M cmpGe(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+
+    static void meanAnomaly(const double* m0, const double* n, double dt, float* out) {
+        const __m256d vdt = _mm256_set1_pd(dt);
+        const __m256d twoPi = _mm256_set1_pd(6.283185307179586);
+        const __m256d invTwoPi = _mm256_set1_pd(0.15915494309189535);
+        for (int h = 0; h < 2; ++h) {
+            __m256d m = _mm256_fmadd_pd(_mm256_loadu_pd(n + 4 * h), vdt, _mm256_loadu_pd(m0 + 4 * h));
+            __m256d k = _mm256_round_pd(_mm256_mul_pd(m, invTwoPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            m = _mm256_fnmadd_pd(k, twoPi, m);
+            _mm_store_ps(out + 4 * h, _mm256_cvtpd_ps(m));
+        }
+    }
+};
+
+}
+
+void propagateKeplerAvx2(const KeplerOrbitView& orbits, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations) {
+    keplerKernel<Avx2Ops>(orbits, dt, x, y, z, begin, end, iterations);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,56 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "KeplerKernel.h"
+
+namespace {
+
+struct Avx512Ops {
+    using F = __m512;
+    using M = __mmask16;
+    static constexpr int width = 16;
+
+    static F set1(float v) { return _mm512_set1_ps(v); }
+    static F load(const float* p) { return _mm512_load_ps(p); }
+    static F loadu(const float* p) { return _mm512_loadu_ps(p); }
+    static void storeu(float* p, F v) { _mm512_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm512_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm512_div_ps(a, b); }
+    static F neg(F a) { return _mm512_sub_ps(_mm512_setzero_ps(), a); }
+    static F fmadd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+    static F fnmadd(F a, F b, F c) { return _mm512_fnmadd_ps(a, b, c); }
+    static F round(F a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static F floor(F a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static M cmpEq(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static M cmpGe(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    static F select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+
+    static void meanAnomaly(const double* m0, const double* n, double dt, float* out) {
+        const __m512d vdt = _mm512_set1_pd(dt);
+        const __m512d twoPi = _mm512_set1_pd(6.283185307179586);
+        const __m512d invTwoPi = _mm512_set1_pd(0.15915494309189535);
+        for (int h = 0; h < 2; ++h) {
+            __m512d m = _mm512_fmadd_pd(_mm512_loadu_pd(n + 8 * h), vdt, _mm512_loadu_pd(m0 + 8 * h));
+            __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(m, invTwoPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            m = _mm512_fnmadd_pd(k, twoPi, m);
+            _mm256_store_ps(out + 8 * h, _mm512_cvtpd_ps(m));
+        }
+    }
+};
+
+}
+
+void propagateKeplerAvx512(const KeplerOrbitView& orbits, double dt, float* x, float* y, float* z,
+    size_t begin, size_t end, int iterations) {
+    keplerKernel<Avx512Ops>(orbits, dt, x, y, z, begin, end, iterations);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,71 @@
+#include "MeshRegistry.h"
+
+namespace {
+
+enum Generator {
+    UV_SPHERE,
+    UV_SPHERE_CHAIN,
+    COMPACT_SPHERE,
+    KEPLER_ORBIT,
+};
+
+}
+
+template <typename Mesh, typename Build>
+Mesh& MeshRegistry::find(std::map<Key, std::unique_ptr<Mesh>>& meshes, Key key, Build build) {
+    ++requests;
+    auto found = meshes.find(key);
+    if (found != meshes.end()) {
+        sharedBytes += found->second->gpuBytes();
+        return *found->second;
+    }
+    return *meshes.emplace(std::move(key), build()).first->second;
+}
+
+Sphere& MeshRegistry::sphere(float radius, int sectors, int stacks) {
+    return find(spheres, Key{ UV_SPHERE, { radius, static_cast<double>(sectors), static_cast<double>(stacks) } },
+        [&] { return std::make_unique<Sphere>(radius, sectors, stacks); });
+}
+
+Sphere& MeshRegistry::sphere(float radius, const std::vector<int>& lodSectors) {
+    Key key{ UV_SPHERE_CHAIN, { radius } };
+    key.parameters.insert(key.parameters.end(), lodSectors.begin(), lodSectors.end());
+    return find(spheres, std::move(key), [&] { return std::make_unique<Sphere>(radius, lodSectors); });
+}
+
+Sphere& MeshRegistry::sphere(SphereTopology topology, const std::vector<int>& lodDetail) {
+    Key key{ COMPACT_SPHERE, { static_cast<double>(topology) } };
+    key.parameters.insert(key.parameters.end(), lodDetail.begin(), lodDetail.end());
+    return find(spheres, std::move(key), [&] { return std::make_unique<Sphere>(topology, lodDetail); });
+}
+
+OrbitPath& MeshRegistry::keplerOrbit(const KeplerElements& elements, int segments) {
+    Key key{ KEPLER_ORBIT, { elements.semiMajor, elements.eccentricity, elements.inclination, elements.ascendingNode,
+        elements.argPeriapsis, elements.meanAnomaly, elements.meanMotion, static_cast<double>(segments) } };
+    return find(orbits, std::move(key), [&] {
+        auto orbit = std::make_unique<OrbitPath>();
+        orbit->generateKeplerOrbit(elements, segments);
+        return orbit;
+    });
+}
+
+MeshMemory MeshRegistry::memory() const {
+    MeshMemory memory;
+    memory.meshes = spheres.size() + orbits.size();
+    memory.requests = requests;
+    memory.sharedBytes = sharedBytes;
+    for (const auto& entry : spheres) {
+        memory.cpuBytes += entry.second->lods.capacity() * sizeof(SphereLod);
+        memory.gpuBytes += entry.second->gpuBytes();
+    }
+    for (const auto& entry : orbits)
+        memory.gpuBytes += entry.second->gpuBytes();
+    return memory;
+}
+
+void MeshRegistry::clear() {
+    spheres.clear();
+    orbits.clear();
+    requests = 0;
+    sharedBytes = 0;
+}
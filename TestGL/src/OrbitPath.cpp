@@ -13,49 +13,31 @@ OrbitPath::~OrbitPath() {
     glDeleteBuffers(1, &VBO);
 }
 
-void OrbitPath::generateEarthOrbit(float semiMajor, float semiMinor, int segments) {
-    vertices.clear();
-    const float PI = 3.14159265359f;
-    
+void OrbitPath::generateKeplerOrbit(const KeplerElements& elements, int segments) {
+    std::vector<float> vertices;
+    const double PI = 3.14159265358979323846;
+
+    // Sampling by eccentric anomaly keeps the spacing even around the ellipse.
     for (int i = 0; i <= segments; ++i) {
-        float angle = 2.0f * PI * i / segments;
-        float x = semiMajor * cosf(angle);
-        float z = semiMinor * sinf(angle);
-        
-        vertices.push_back(x);
-        vertices.push_back(0.0f);
-        vertices.push_back(z);
+        double anomaly = 2.0 * PI * i / segments;
+        glm::dvec3 p = keplerPositionAtAnomaly(elements, anomaly);
+
+        vertices.push_back(static_cast<float>(p.x));
+        vertices.push_back(static_cast<float>(p.y));
+        vertices.push_back(static_cast<float>(p.z));
     }
-    
-    pointCount = vertices.size() / 3;
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+
+    upload(vertices);
 }
 
-void OrbitPath::generateMoonOrbit(float radius, int segments) {
-    vertices.clear();
-    const float PI = 3.14159265359f;
-    
-    for (int i = 0; i <= segments; ++i) {
-        float angle = 2.0f * PI * i / segments;
-        float x = radius * cosf(angle);
-        float z = radius * sinf(angle);
-        
-        vertices.push_back(x);
-        vertices.push_back(0.0f);
-        vertices.push_back(z);
-    }
-    
-    pointCount = vertices.size() / 3;
-    
+// The points are only staging: nothing is kept once the buffer holds them.
+void OrbitPath::upload(const std::vector<float>& vertices) {
+    pointCount = static_cast<unsigned int>(vertices.size() / 3);
+    vertexBytes = vertices.size() * sizeof(float);
+
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     glBindVertexArray(0);
@@ -67,3 +49,7 @@ void OrbitPath::Draw() {
     glBindVertexArray(0);
 }
 
+DrawGeometry OrbitPath::geometry() const {
+    return { VAO, GL_LINE_STRIP, static_cast<GLsizei>(pointCount), 0, 1 };
+}
+
@@ -0,0 +1,40 @@
+#include "ParticleCloud.h"
+
+ParticleCloud::ParticleCloud() : stream(GL_ARRAY_BUFFER) {
+    glGenVertexArrays(1, &VAO);
+    pointCount = 0;
+}
+
+ParticleCloud::~ParticleCloud() {
+    glDeleteVertexArrays(1, &VAO);
+}
+
+// Interleaves straight into the stream's memory; the data moves within the
+// stream on every update, so the attribute pointer follows it.
+void ParticleCloud::update(const float* x, const float* y, const float* z, size_t count) {
+    float* vertices = static_cast<float*>(stream.begin(count * 3 * sizeof(float)));
+    for (size_t i = 0; i < count; ++i) {
+        vertices[i * 3 + 0] = x[i];
+        vertices[i * 3 + 1] = y[i];
+        vertices[i * 3 + 2] = z[i];
+    }
+    size_t offset = stream.end();
+    pointCount = static_cast<unsigned int>(count);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.id);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)offset);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleCloud::Draw() {
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_POINTS, 0, pointCount);
+    glBindVertexArray(0);
+}
+
+DrawGeometry ParticleCloud::geometry() const {
+    return { VAO, GL_POINTS, static_cast<GLsizei>(pointCount), 0, 1 };
+}
@@ -0,0 +1,238 @@
+#include "RenderQueue.h"
+#include "ShaderBlocks.h"
+#include <algorithm>
+
+namespace {
+
+const unsigned int UNKNOWN = ~0u;
+
+// Quantizes a depth to 16 bits, 0 at the camera.
+uint64_t depthBits(float depth, float range) {
+    float t = std::clamp(depth / range, 0.0f, 1.0f);
+    return static_cast<uint64_t>(t * 65535.0f);
+}
+
+}
+
+void GLStateCache::invalidate() {
+    program = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (int unit = 0; unit < TEXTURE_UNITS; ++unit) {
+        textureTargets[unit] = 0;
+        textures[unit] = UNKNOWN;
+    }
+    vertexArray = UNKNOWN;
+    for (BufferRange& range : ranges)
+        range = { UNKNOWN, 0, 0 };
+    for (int& state : enabled)
+        state = -1;
+    depthFunction = 0;
+    depthWrite = -1;
+    blendSource = blendDestination = 0;
+    width = -1.0f;
+    pointDiameter = -1.0f;
+}
+
+void GLStateCache::useProgram(unsigned int id) {
+    if (id == program) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glUseProgram(id);
+    program = id;
+    ++stats.programSwitches;
+}
+
+// Units past TEXTURE_UNITS are bound every time.
+void GLStateCache::bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+    bool cached = unit < TEXTURE_UNITS;
+    if (cached && textures[unit] == texture && textureTargets[unit] == target) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    if (unit != activeUnit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    glBindTexture(target, texture);
+    if (cached) {
+        textureTargets[unit] = target;
+        textures[unit] = texture;
+    }
+    ++stats.textureBinds;
+}
+
+void GLStateCache::bindVertexArray(unsigned int id) {
+    if (id == vertexArray) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glBindVertexArray(id);
+    vertexArray = id;
+    ++stats.vertexArrayBinds;
+}
+
+void GLStateCache::bindUniformRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size) {
+    bool cached = binding < BUFFER_BINDINGS;
+    if (cached) {
+        const BufferRange& range = ranges[binding];
+        if (range.buffer == buffer && range.offset == offset && range.size == size) {
+            ++stats.redundantSkipped;
+            return;
+        }
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, static_cast<GLintptr>(offset),
+        static_cast<GLsizeiptr>(size));
+    if (cached)
+        ranges[binding] = { buffer, offset, size };
+    ++stats.stateChanges;
+}
+
+void GLStateCache::setEnabled(GLenum capability, bool on) {
+    int index = capability == GL_BLEND ? 0 : capability == GL_DEPTH_TEST ? 1 : 2;
+    if (enabled[index] == int(on)) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    if (on)
+        glEnable(capability);
+    else
+        glDisable(capability);
+    enabled[index] = on;
+    ++stats.stateChanges;
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+    if (func == depthFunction) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glDepthFunc(func);
+    depthFunction = func;
+    ++stats.stateChanges;
+}
+
+void GLStateCache::depthMask(bool write) {
+    if (depthWrite == int(write)) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+    depthWrite = write;
+    ++stats.stateChanges;
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination) {
+    if (source == blendSource && destination == blendDestination) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glBlendFunc(source, destination);
+    blendSource = source;
+    blendDestination = destination;
+    ++stats.stateChanges;
+}
+
+void GLStateCache::lineWidth(float lineWidth) {
+    if (lineWidth == width) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glLineWidth(lineWidth);
+    width = lineWidth;
+    ++stats.stateChanges;
+}
+
+void GLStateCache::pointSize(float size) {
+    if (size == pointDiameter) {
+        ++stats.redundantSkipped;
+        return;
+    }
+    glPointSize(size);
+    pointDiameter = size;
+    ++stats.stateChanges;
+}
+
+void RenderQueue::submit(const DrawItem& item) {
+    order.push_back({ sortKey(item), static_cast<uint32_t>(items.size()) });
+    items.push_back(item);
+}
+
+uint64_t RenderQueue::sortKey(const DrawItem& item) const {
+    uint64_t pass = uint64_t(item.pass & 0xF) << 60;
+    uint64_t program = uint64_t(item.program & 0xFFF);
+    uint64_t texture = uint64_t(item.textures[0].texture & 0xFFFF);
+    uint64_t mesh = uint64_t(item.geometry.vertexArray & 0xFFFF);
+    uint64_t depth = depthBits(item.depth, depthRange);
+    if (item.pass == PASS_TRANSPARENT)
+        return pass | (0xFFFF - depth) << 44 | program << 32 | texture << 16 | mesh;
+    return pass | program << 48 | texture << 32 | mesh << 16 | depth;
+}
+
+void RenderQueue::flush() {
+    if (sorted) {
+        std::sort(order.begin(), order.end(), [](const Entry& a, const Entry& b) {
+            return a.key != b.key ? a.key < b.key : a.item < b.item;
+        });
+    }
+
+    state.invalidate();
+    for (const Entry& entry : order) {
+        const DrawItem& item = items[entry.item];
+        if (!filtered)
+            state.invalidate();
+        // Each pass's fixed-function state, filtered like the rest.
+        bool transparent = item.pass == PASS_TRANSPARENT;
+        state.setEnabled(GL_BLEND, transparent);
+        if (transparent)
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        state.depthFunc(item.pass == PASS_SKY ? GL_LEQUAL : GL_LESS);
+        state.depthMask(!transparent);
+        draw(item);
+    }
+
+    state.setEnabled(GL_BLEND, false);
+    state.depthFunc(GL_LESS);
+    state.depthMask(true);
+    state.bindVertexArray(0);
+    items.clear();
+    order.clear();
+}
+
+void RenderQueue::draw(const DrawItem& item) {
+    const DrawGeometry& geometry = item.geometry;
+    if (geometry.count == 0 || geometry.instances == 0)
+        return;
+
+    state.useProgram(item.program);
+    for (unsigned int unit = 0; unit < GLStateCache::TEXTURE_UNITS; ++unit) {
+        if (item.textures[unit].target != 0)
+            state.bindTexture(unit, item.textures[unit].target, item.textures[unit].texture);
+    }
+    if (item.objectOffset != SIZE_MAX && objectBuffer)
+        state.bindUniformRange(objectBuffer->binding, objectBuffer->id, item.objectOffset, sizeof(ObjectBlock));
+    if (geometry.mode == GL_LINES || geometry.mode == GL_LINE_STRIP || geometry.mode == GL_LINE_LOOP)
+        state.lineWidth(item.lineWidth);
+    if (geometry.mode == GL_POINTS)
+        state.pointSize(item.pointSize);
+    state.bindVertexArray(geometry.vertexArray);
+
+    if (geometry.indirectBuffer != 0) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, geometry.indirectBuffer);
+        glMultiDrawElementsIndirect(geometry.mode, geometry.indexType, nullptr, geometry.drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else if (geometry.indexType == 0) {
+        if (geometry.instances == 1)
+            glDrawArrays(geometry.mode, 0, geometry.count);
+        else
+            glDrawArraysInstanced(geometry.mode, 0, geometry.count, geometry.instances);
+    } else {
+        if (geometry.instances == 1)
+            glDrawElements(geometry.mode, geometry.count, geometry.indexType,
+                reinterpret_cast<const void*>(geometry.indexOffset));
+        else
+            glDrawElementsInstanced(geometry.mode, geometry.count, geometry.indexType,
+                reinterpret_cast<const void*>(geometry.indexOffset), geometry.instances);
+    }
+    ++state.stats.draws;
+}
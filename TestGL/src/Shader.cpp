@@ -1,4 +1,5 @@
 ﻿#include "Shader.h"
+#include <algorithm>
 #include <filesystem>
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
@@ -53,37 +54,142 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
     glAttachShader(ID, fragment);
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+    reflectUniforms();
 
     glDeleteShader(vertex);
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const char* computePath) {
+    std::string computeCode;
+    std::ifstream cShaderFile;
+    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try {
+        cShaderFile.open(computePath);
+        std::stringstream cShaderStream;
+        cShaderStream << cShaderFile.rdbuf();
+        cShaderFile.close();
+        computeCode = cShaderStream.str();
+    }
+    catch (std::ifstream::failure& e) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        std::cout << "Compute path: " << computePath << std::endl;
+    }
+
+    const char* cShaderCode = computeCode.c_str();
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, NULL);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+    reflectUniforms();
+
+    glDeleteShader(compute);
+}
+
+bool UniformTable::add(std::string_view name, int location) {
+    if (2 * (count + 1) > slots.size())
+        grow();
+    uint32_t hash = UniformName(name).hash;
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    for (; slots[i].location != EMPTY; i = (i + 1) & mask) {
+        if (matches(slots[i], hash, name))
+            return false;
+    }
+    slots[i] = { hash, location, static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size()) };
+    names.append(name);
+    ++count;
+    return true;
+}
+
+int UniformTable::find(UniformName name) const {
+    if (slots.empty())
+        return -1;
+    size_t mask = slots.size() - 1;
+    for (size_t i = name.hash & mask; slots[i].location != EMPTY; i = (i + 1) & mask) {
+        if (matches(slots[i], name.hash, name.text))
+            return slots[i].location;
+    }
+    return -1;
+}
+
+void UniformTable::grow() {
+    std::vector<Entry> old = std::move(slots);
+    slots.assign(std::max<size_t>(16, old.size() * 2), { 0, EMPTY, 0, 0 });
+    size_t mask = slots.size() - 1;
+    for (const Entry& entry : old) {
+        if (entry.location == EMPTY)
+            continue;
+        size_t i = entry.hash & mask;
+        while (slots[i].location != EMPTY)
+            i = (i + 1) & mask;
+        slots[i] = entry;
+    }
+}
+
+// Reads every active uniform once, so the setters never look a name up in
+// the driver.
+void Shader::reflectUniforms() {
+    int count = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; ++i) {
+        char name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), sizeof(name), &length, &size, &type, name);
+        int location = glGetUniformLocation(ID, name);
+        if (location < 0)
+            continue;   // member of a uniform block
+
+        // Arrays are listed as "name[0]"; the bare name addresses the first element.
+        std::string_view key(name, static_cast<size_t>(length));
+        if (key.size() > 3 && key.substr(key.size() - 3) == "[0]")
+            key.remove_suffix(3);
+        if (!uniformTable.add(key, location))
+            std::cout << "ERROR::SHADER::DUPLICATE_UNIFORM: " << key << std::endl;
+    }
+}
+
 void Shader::use() {
     glUseProgram(ID);
 }
 
-void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+void Shader::setBool(UniformName name, bool value) const {
+    glUniform1i(uniformTable.find(name), (int)value);
+}
+
+void Shader::setInt(UniformName name, int value) const {
+    glUniform1i(uniformTable.find(name), value);
 }
 
-void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setFloat(UniformName name, float value) const {
+    glUniform1f(uniformTable.find(name), value);
 }
 
-void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setMat4(UniformName name, const glm::mat4& mat) const {
+    glUniformMatrix4fv(uniformTable.find(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+void Shader::setVec3(UniformName name, const glm::vec3& value) const {
+    glUniform3fv(uniformTable.find(name), 1, &value[0]);
 }
 
-void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setVec3(UniformName name, float x, float y, float z) const {
+    glUniform3f(uniformTable.find(name), x, y, z);
 }
 
-void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+bool Shader::bindUniformBlock(const std::string& name, unsigned int binding) const {
+    unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+    if (index == GL_INVALID_INDEX)
+        return false;
+    glUniformBlockBinding(ID, index, binding);
+    return true;
 }
 
 void Shader::checkCompileErrors(unsigned int shader, std::string type) {
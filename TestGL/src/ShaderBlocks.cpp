@@ -0,0 +1,119 @@
+#include "ShaderBlocks.h"
+#include "Shader.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+struct BlockMember {
+    const char* name;
+    size_t offset;
+};
+
+const BlockMember FRAME_MEMBERS[] = {
+    { "Frame.view", offsetof(FrameBlock, view) },
+    { "Frame.projection", offsetof(FrameBlock, projection) },
+    { "Frame.viewPos", offsetof(FrameBlock, viewPos) },
+    { "Frame.sunPos", offsetof(FrameBlock, sunPos) },
+    { "Frame.sunLight", offsetof(FrameBlock, sunLight) },
+    { "Frame.moonPos", offsetof(FrameBlock, moonPos) },
+    { "Frame.moonLight", offsetof(FrameBlock, moonLight) },
+    { "Frame.occluders", offsetof(FrameBlock, occluders) },
+    { "Frame.occluderCount", offsetof(FrameBlock, occluderCount) },
+};
+
+const BlockMember OBJECT_MEMBERS[] = {
+    { "Object.model", offsetof(ObjectBlock, model) },
+    { "Object.normalMatrix", offsetof(ObjectBlock, normalMatrix) },
+    { "Object.color", offsetof(ObjectBlock, color) },
+    { "Object.flags", offsetof(ObjectBlock, flags) },
+};
+
+const BlockMember CULL_MEMBERS[] = {
+    { "Cull.view", offsetof(CullBlock, view) },
+    { "Cull.projection", offsetof(CullBlock, projection) },
+    { "Cull.planes", offsetof(CullBlock, planes) },
+    { "Cull.hiz", offsetof(CullBlock, hiz) },
+    { "Cull.counts", offsetof(CullBlock, counts) },
+    { "Cull.lod", offsetof(CullBlock, lod) },
+    { "Cull.lodErrors", offsetof(CullBlock, lodErrors) },
+};
+
+// A block the program does not declare is fine; one it declares must match
+// member for member. Members the program never reads may be reported as
+// inactive and are skipped.
+template <size_t N>
+bool checkBlock(const Shader& shader, const char* programName, const char* block, unsigned int binding,
+    size_t size, const BlockMember (&members)[N]) {
+    if (!shader.bindUniformBlock(block, binding))
+        return true;
+
+    bool ok = true;
+    GLuint blockIndex = glGetUniformBlockIndex(shader.ID, block);
+    GLint dataSize = 0;
+    glGetActiveUniformBlockiv(shader.ID, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    if (static_cast<size_t>(dataSize) != size) {
+        std::cout << "ERROR: " << programName << " block " << block << " is " << dataSize << " bytes, C++ has "
+            << size << std::endl;
+        ok = false;
+    }
+
+    for (const BlockMember& member : members) {
+        GLuint index = GL_INVALID_INDEX;
+        glGetUniformIndices(shader.ID, 1, &member.name, &index);
+        if (index == GL_INVALID_INDEX)
+            continue;
+        GLint offset = -1;
+        glGetActiveUniformsiv(shader.ID, 1, &index, GL_UNIFORM_OFFSET, &offset);
+        if (static_cast<size_t>(offset) != member.offset) {
+            std::cout << "ERROR: " << programName << " " << member.name << " is at offset " << offset
+                << ", C++ has " << member.offset << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+}
+
+void UniformBuffer::create(unsigned int bindingPoint, size_t size) {
+    binding = bindingPoint;
+    capacity = size;
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
+
+void UniformBuffer::upload(const void* data, size_t size) {
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    if (size > capacity) {
+        capacity = std::max(size, capacity * 2);
+        glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+}
+
+void UniformBuffer::bindRange(size_t offset, size_t size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+}
+
+size_t uniformOffsetAlignment() {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return static_cast<size_t>(std::max(alignment, 1));
+}
+
+bool checkBlockLayouts(const Shader& shader, const char* programName) {
+    bool frame = checkBlock(shader, programName, "Frame", FRAME_BLOCK_BINDING, sizeof(FrameBlock), FRAME_MEMBERS);
+    bool object = checkBlock(shader, programName, "Object", OBJECT_BLOCK_BINDING, sizeof(ObjectBlock),
+        OBJECT_MEMBERS);
+    bool cull = checkBlock(shader, programName, "Cull", CULL_BLOCK_BINDING, sizeof(CullBlock), CULL_MEMBERS);
+    return frame && object && cull;
+}
+
+void setSolarUniforms(const Shader& solar, bool compactVertices) {
+    solar.setInt("bodyTextures", 0);
+    solar.setInt("shadowTexture", 1);
+    solar.setBool("compactVertices", compactVertices);
+}
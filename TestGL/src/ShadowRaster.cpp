@@ -0,0 +1,216 @@
+#include "ShadowRaster.h"
+#include "KeplerPropagator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Points per pool task; a few rows of a typical raster.
+const size_t SHADOW_GRAIN = 4096;
+// A solar eclipse lasts at most about six hours from first to last contact.
+const double MAX_PATH_DAYS = 0.3;
+
+struct ScalarOps {
+    using F = float;
+    using M = bool;
+    static constexpr int width = 1;
+
+    static F set1(float v) { return v; }
+    static F loadu(const float* p) { return *p; }
+    static void storeu(float* p, F v) { *p = v; }
+    static F add(F a, F b) { return a + b; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F div(F a, F b) { return a / b; }
+    static F sqrt(F a) { return std::sqrt(a); }
+    static F min(F a, F b) { return a < b ? a : b; }
+    static F max(F a, F b) { return a > b ? a : b; }
+    static F neg(F a) { return -a; }
+    static F abs(F a) { return std::abs(a); }
+    static F fmadd(F a, F b, F c) { return a * b + c; }
+    static F fnmadd(F a, F b, F c) { return c - a * b; }
+    static M cmpLt(F a, F b) { return a < b; }
+    static M cmpGt(F a, F b) { return a > b; }
+    static M maskAnd(M a, M b) { return a && b; }
+    static bool any(M m) { return m; }
+    static F select(M m, F a, F b) { return m ? a : b; }
+};
+
+double angleBetween(const glm::dvec3& a, const glm::dvec3& b) {
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+// Geometry at one instant, or false if no point on the Earth can see the
+// Moon touch the Sun: the topocentric shift of the Moon against the Sun is at
+// most the difference of their parallaxes, and the Moon looks largest from
+// the point nearest it.
+bool shadowStep(const EclipseModel& model, double t, double spin, ShadowStep& step) {
+    glm::dvec3 sun = -keplerPosition(model.earthOrbit, t - model.epoch) / model.earthRadius;
+    glm::dvec3 moon = keplerPosition(model.moonOrbit, t - model.epoch) / model.earthRadius;
+    double sunDistance = glm::length(sun), moonDistance = glm::length(moon);
+    double sunRadius = model.sunRadius / model.earthRadius;
+    double moonRadius = model.moonRadius / model.earthRadius;
+
+    double limit = std::asin(sunRadius / (sunDistance - 1.0)) + std::asin(moonRadius / (moonDistance - 1.0))
+        + std::asin(1.0 / moonDistance) - std::asin(1.0 / sunDistance);
+    if (angleBetween(sun, moon) >= limit)
+        return false;
+
+    // The penumbra widens away from the Moon at the angle subtended by the
+    // Sun's and Moon's radii together; take its radius at the far side of
+    // the Earth, plus a margin for float rounding in the kernel.
+    glm::dvec3 axis = glm::normalize(moon - sun);
+    double spread = std::tan(std::asin((sunRadius + moonRadius) / glm::length(moon - sun)));
+    double penumbra = moonRadius + (glm::dot(-moon, axis) + 1.0) * spread + 0.02;
+
+    step.sunX = static_cast<float>(sun.x);
+    step.sunY = static_cast<float>(sun.y);
+    step.sunZ = static_cast<float>(sun.z);
+    step.moonX = static_cast<float>(moon.x);
+    step.moonY = static_cast<float>(moon.y);
+    step.moonZ = static_cast<float>(moon.z);
+    step.axisX = static_cast<float>(axis.x);
+    step.axisY = static_cast<float>(axis.y);
+    step.axisZ = static_cast<float>(axis.z);
+    step.cullRadius = static_cast<float>(penumbra);
+    step.sunRadius = static_cast<float>(sunRadius);
+    step.moonRadius = static_cast<float>(moonRadius);
+    step.spinCos = static_cast<float>(std::cos(spin));
+    step.spinSin = static_cast<float>(std::sin(spin));
+    return true;
+}
+
+void clearLayer(ShadowLayer& layer) {
+    std::fill(layer.obscuration.begin(), layer.obscuration.end(), 0.0f);
+    std::fill(layer.magnitude.begin(), layer.magnitude.end(), 0.0f);
+    std::fill(layer.central.begin(), layer.central.end(), 0.0f);
+}
+
+uint8_t unitToByte(float value) {
+    return static_cast<uint8_t>(std::min(value, 1.0f) * 255.0f + 0.5f);
+}
+
+}
+
+void shadeShadowScalar(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount, size_t begin, size_t end) {
+    shadowKernel<ScalarOps>(v, steps, stepCount, begin, end);
+}
+
+ShadowRaster::ShadowRaster() : simdLevel(detectSimdLevel()) {}
+
+ShadowRaster::ShadowRaster(SimdLevel level) : simdLevel(level) {
+    if (level > detectSimdLevel())
+        simdLevel = detectSimdLevel();
+}
+
+void ShadowRaster::resize(int width, int height) {
+    const double PI = 3.14159265358979323846;
+    rasterWidth = width;
+    rasterHeight = height;
+    invalidate();
+    nowEclipsed = false;
+    size_t count = static_cast<size_t>(width) * height;
+    pointX.resize(count);
+    pointY.resize(count);
+    pointZ.resize(count);
+    for (ShadowLayer* layer : { &now, &path }) {
+        layer->obscuration.assign(count, 0.0f);
+        layer->magnitude.assign(count, 0.0f);
+        layer->central.assign(count, 0.0f);
+    }
+
+    // Texel centres, with the Sphere mesh's mapping: v runs from the +z pole
+    // to the -z pole and u once round the z axis.
+    for (int y = 0; y < height; ++y) {
+        double stack = PI / 2.0 - (y + 0.5) / height * PI;
+        for (int x = 0; x < width; ++x) {
+            double sector = (x + 0.5) / width * 2.0 * PI;
+            size_t i = static_cast<size_t>(y) * width + x;
+            pointX[i] = static_cast<float>(std::cos(stack) * std::cos(sector));
+            pointY[i] = static_cast<float>(std::cos(stack) * std::sin(sector));
+            pointZ[i] = static_cast<float>(std::sin(stack));
+        }
+    }
+}
+
+bool ShadowRaster::compute(const EclipseModel& model, double time, double spinAngle, double spinRate,
+    double pathStep, ThreadPool& pool) {
+    lastEvaluations = 0;
+
+    ShadowStep current;
+    bool eclipsed = shadowStep(model, time, spinAngle, current);
+    if (eclipsed)
+        shade(&current, 1, now, pool);
+    else if (nowEclipsed)
+        clearLayer(now);
+    nowEclipsed = eclipsed;
+
+    // The path samples a fixed grid of absolute times, so every time within
+    // one eclipse finds the same run of steps and reuses the same path.
+    ShadowStep step;
+    auto stepAt = [&](long long k) {
+        double t = k * pathStep;
+        return shadowStep(model, t, spinAngle + spinRate * (t - time), step);
+    };
+    const long long maxSteps = static_cast<long long>(MAX_PATH_DAYS / pathStep) + 1;
+    long long first = static_cast<long long>(std::floor(time / pathStep));
+    if (!stepAt(first) && !stepAt(++first)) {
+        if (pathFirst <= pathLast)
+            clearLayer(path);
+        pathFirst = 1;
+        pathLast = 0;
+        return eclipsed;
+    }
+    long long last = first;
+    while (first > last - maxSteps && stepAt(first - 1))
+        --first;
+    while (last < first + maxSteps && stepAt(last + 1))
+        ++last;
+
+    if (first != pathFirst || last != pathLast) {
+        pathSteps.clear();
+        for (long long k = first; k <= last; ++k) {
+            if (stepAt(k))
+                pathSteps.push_back(step);
+        }
+        shade(pathSteps.data(), pathSteps.size(), path, pool);
+        pathFirst = first;
+        pathLast = last;
+    }
+    return true;
+}
+
+void ShadowRaster::invalidate() {
+    pathFirst = 1;
+    pathLast = 0;
+}
+
+void ShadowRaster::shade(const ShadowStep* steps, size_t stepCount, ShadowLayer& layer, ThreadPool& pool) {
+    ShadowRasterView view = { pointX.data(), pointY.data(), pointZ.data(), layer.obscuration.data(),
+        layer.magnitude.data(), layer.central.data() };
+    const SimdLevel level = simdLevel;
+    pool.parallelFor(size(), SHADOW_GRAIN, [&](size_t begin, size_t end) {
+        switch (level) {
+        case SimdLevel::AVX512:
+            shadeShadowAvx512(view, steps, stepCount, begin, end);
+            break;
+        case SimdLevel::AVX2:
+            shadeShadowAvx2(view, steps, stepCount, begin, end);
+            break;
+        default:
+            shadeShadowScalar(view, steps, stepCount, begin, end);
+            break;
+        }
+    });
+    lastEvaluations += size() * stepCount;
+}
+
+void ShadowRaster::packRGBA(uint8_t* pixels) const {
+    for (size_t i = 0; i < size(); ++i) {
+        pixels[4 * i + 0] = unitToByte(now.obscuration[i]);
+        pixels[4 * i + 1] = unitToByte(path.obscuration[i]);
+        pixels[4 * i + 2] = unitToByte(path.central[i]);
+        pixels[4 * i + 3] = unitToByte(now.central[i]);
+    }
+}
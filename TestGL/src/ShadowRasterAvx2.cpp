@@ -0,0 +1,46 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "ShadowKernel.h"
+
+namespace {
+
+struct Avx2Ops {
+    using F = __m256;
+    using M = __m256;
+    static constexpr int width = 8;
+
+    static F set1(float v) { return _mm256_set1_ps(v); }
+    static F loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static void storeu(float* p, F v) { _mm256_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm256_div_ps(a, b); }
+    static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+    static F min(F a, F b) { return _mm256_min_ps(a, b); }
+    static F max(F a, F b) { return _mm256_max_ps(a, b); }
+    static F neg(F a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static F fmadd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+    static F fnmadd(F a, F b, F c) { return _mm256_fnmadd_ps(a, b, c); }
+    static M cmpLt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static M cmpGt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static M maskAnd(M a, M b) { return _mm256_and_ps(a, b); }
+    static bool any(M m) { return _mm256_movemask_ps(m) != 0; }
+    static F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+};
+
+}
+
+void shadeShadowAvx2(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount, size_t begin, size_t end) {
+    shadowKernel<Avx2Ops>(v, steps, stepCount, begin, end);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,46 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "ShadowKernel.h"
+
+namespace {
+
+struct Avx512Ops {
+    using F = __m512;
+    using M = __mmask16;
+    static constexpr int width = 16;
+
+    static F set1(float v) { return _mm512_set1_ps(v); }
+    static F loadu(const float* p) { return _mm512_loadu_ps(p); }
+    static void storeu(float* p, F v) { _mm512_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm512_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm512_div_ps(a, b); }
+    static F sqrt(F a) { return _mm512_sqrt_ps(a); }
+    static F min(F a, F b) { return _mm512_min_ps(a, b); }
+    static F max(F a, F b) { return _mm512_max_ps(a, b); }
+    static F neg(F a) { return _mm512_sub_ps(_mm512_setzero_ps(), a); }
+    static F abs(F a) { return _mm512_abs_ps(a); }
+    static F fmadd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+    static F fnmadd(F a, F b, F c) { return _mm512_fnmadd_ps(a, b, c); }
+    static M cmpLt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static M cmpGt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static M maskAnd(M a, M b) { return static_cast<M>(a & b); }
+    static bool any(M m) { return m != 0; }
+    static F select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+};
+
+}
+
+void shadeShadowAvx512(const ShadowRasterView& v, const ShadowStep* steps, size_t stepCount, size_t begin, size_t end) {
+    shadowKernel<Avx512Ops>(v, steps, stepCount, begin, end);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,27 @@
+#include "SimulationClock.h"
+#include <cmath>
+
+SimulationClock::SimulationClock(double epoch, double step, int maxSubsteps)
+    : step(step), maxSubsteps(maxSubsteps), epoch(epoch) {}
+
+void SimulationClock::seek(double julianDate) {
+    epoch = julianDate;
+    tick = 0;
+    accumulator = 0.0;
+}
+
+int SimulationClock::beginFrame(double realDelta, double timeScale) {
+    if (realDelta > 0.0 && timeScale > 0.0)
+        accumulator += realDelta * timeScale;
+
+    int steps = static_cast<int>(std::floor(accumulator / step));
+    if (steps > maxSubsteps) {
+        droppedTime += (steps - maxSubsteps) * step;
+        steps = maxSubsteps;
+    }
+    accumulator -= steps * step;
+    if (accumulator >= step)
+        accumulator = std::fmod(accumulator, step);
+    stepCount += steps;
+    return steps;
+}
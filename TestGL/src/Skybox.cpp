@@ -85,3 +85,7 @@ void Skybox::Draw() {
     glBindVertexArray(0);
 }
 
+DrawGeometry Skybox::geometry() const {
+    return { VAO, GL_TRIANGLES, 36, 0, 1 };
+}
+
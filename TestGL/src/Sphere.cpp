@@ -1,10 +1,60 @@
 #include "Sphere.h"
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <limits>
 
+// The vertices and indices are only staging for glBufferData, so they go
+// out of scope once the buffers hold them.
 Sphere::Sphere(float radius, int sectors, int stacks) {
-    generateSphere(radius, sectors, stacks);
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    generateSphere(radius, sectors, stacks, vertices, indices);
+    createBuffers(vertices.data(), vertices.size() * sizeof(float), indices.data(), indices.size() * sizeof(unsigned int));
+}
+
+Sphere::Sphere(float radius, const std::vector<int>& lodSectors) {
+    if (lodSectors.size() > MAX_SPHERE_LODS)
+        std::cout << "ERROR: a sphere LOD chain holds at most " << MAX_SPHERE_LODS << " levels" << std::endl;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for (size_t level = 0; level < lodSectors.size() && level < MAX_SPHERE_LODS; ++level)
+        generateSphere(radius, lodSectors[level], std::max(lodSectors[level] / 2, 2), vertices, indices);
+    createBuffers(vertices.data(), vertices.size() * sizeof(float), indices.data(), indices.size() * sizeof(unsigned int));
+}
+
+Sphere::Sphere(SphereTopology topology, const std::vector<int>& lodDetail)
+    : indexType(GL_UNSIGNED_SHORT), compact(true) {
+    if (lodDetail.size() > MAX_SPHERE_LODS)
+        std::cout << "ERROR: a sphere LOD chain holds at most " << MAX_SPHERE_LODS << " levels" << std::endl;
+    std::vector<CompactSphereVertex> packed;
+    std::vector<uint16_t> packedIndices;
+    for (size_t level = 0; level < lodDetail.size() && level < MAX_SPHERE_LODS; ++level) {
+        CompactSphereMesh mesh = buildCompactSphere(topology, lodDetail[level]);
+        if (packed.size() + mesh.vertices.size() > 65536) {
+            std::cout << "ERROR: sphere LOD " << level << " does not fit in 16-bit indices" << std::endl;
+            break;
+        }
+        SphereLod lod;
+        lod.detail = lodDetail[level];
+        lod.firstIndex = static_cast<unsigned int>(packedIndices.size());
+        lod.indexCount = static_cast<unsigned int>(mesh.indices.size());
+        lod.error = mesh.error;
+        lods.push_back(lod);
+        const uint16_t base = static_cast<uint16_t>(packed.size());
+        for (uint16_t index : mesh.indices)
+            packedIndices.push_back(static_cast<uint16_t>(base + index));
+        packed.insert(packed.end(), mesh.vertices.begin(), mesh.vertices.end());
+    }
+    indexCount = lods.empty() ? 0 : lods[0].indexCount;
+    createBuffers(packed.data(), packed.size() * sizeof(CompactSphereVertex), packedIndices.data(),
+        packedIndices.size() * sizeof(uint16_t));
+}
 
+void Sphere::createBuffers(const void* vertexData, size_t vertexSize, const void* indexData, size_t indexSize) {
+    vertexBytes = vertexSize;
+    indexBytes = indexSize;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -12,19 +62,34 @@ Sphere::Sphere(float radius, int sectors, int stacks) {
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW);
 
+    bindSphereVertices(*this);
+
+    glBindVertexArray(0);
+}
+
+void bindSphereVertices(const Sphere& sphere) {
+    glBindBuffer(GL_ARRAY_BUFFER, sphere.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere.EBO);
+    if (sphere.compact) {
+        const GLsizei stride = sizeof(CompactSphereVertex);
+        glDisableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(CompactSphereVertex, normal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(CompactSphereVertex, texCoord));
+        glEnableVertexAttribArray(2);
+        return;
+    }
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
 }
 
 Sphere::~Sphere() {
@@ -33,11 +98,17 @@ Sphere::~Sphere() {
     glDeleteBuffers(1, &EBO);
 }
 
-void Sphere::generateSphere(float radius, int sectors, int stacks) {
+// Appends one level to the chain.
+void Sphere::generateSphere(float radius, int sectors, int stacks, std::vector<float>& vertices,
+    std::vector<unsigned int>& indices) {
     const float PI = 3.14159265359f;
     float sectorStep = 2 * PI / sectors;
     float stackStep = PI / stacks;
     float sectorAngle, stackAngle;
+    const unsigned int firstVertex = static_cast<unsigned int>(vertices.size() / 8);
+    SphereLod lod;
+    lod.detail = sectors;
+    lod.firstIndex = static_cast<unsigned int>(indices.size());
 
     for (int i = 0; i <= stacks; ++i) {
         stackAngle = PI / 2 - i * stackStep;
@@ -68,7 +139,7 @@ void Sphere::generateSphere(float radius, int sectors, int stacks) {
 
     unsigned int k1, k2;
     for (int i = 0; i < stacks; ++i) {
-        k1 = i * (sectors + 1);
+        k1 = firstVertex + i * (sectors + 1);
         k2 = k1 + sectors + 1;
 
         for (int j = 0; j < sectors; ++j, ++k1, ++k2) {
@@ -86,12 +157,50 @@ void Sphere::generateSphere(float radius, int sectors, int stacks) {
         }
     }
 
-    indexCount = indices.size();
+    // The cells are widest at the equator, where the middle of one sits
+    // about 1 - cos(a/2)cos(b/2) inside the surface.
+    lod.indexCount = static_cast<unsigned int>(indices.size()) - lod.firstIndex;
+    lod.error = 1.0f - cosf(sectorStep / 2) * cosf(stackStep / 2);
+    lods.push_back(lod);
+    indexCount = lods[0].indexCount;
 }
 
 void Sphere::Draw() {
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
     glBindVertexArray(0);
 }
 
+DrawGeometry Sphere::geometry() const {
+    return { VAO, GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType, 1 };
+}
+
+float projectedSphereRadius(float focalPixels, float distance, float radius) {
+    float tangent2 = distance * distance - radius * radius;
+    if (tangent2 <= 0.0f)
+        return std::numeric_limits<float>::infinity();
+    return focalPixels * radius / std::sqrt(tangent2);
+}
+
+namespace {
+
+int coarsestWithin(const std::vector<SphereLod>& lods, float screenRadius, float pixelError) {
+    for (int level = static_cast<int>(lods.size()) - 1; level > 0; --level) {
+        if (lods[level].error * screenRadius <= pixelError)
+            return level;
+    }
+    return 0;
+}
+
+}
+
+// Refining happens as soon as the current level is over budget; coarsening
+// waits until the coarser level is comfortably under it. cull_compute.glsl
+// makes the same choice on the GPU.
+int selectSphereLod(const std::vector<SphereLod>& lods, float screenRadius, int previous,
+    const SphereLodSettings& settings) {
+    int wanted = coarsestWithin(lods, screenRadius, settings.pixelError);
+    if (previous < 0 || previous >= static_cast<int>(lods.size()) || wanted <= previous)
+        return wanted;
+    return std::max(previous, coarsestWithin(lods, screenRadius, settings.pixelError * (1.0f - settings.hysteresis)));
+}
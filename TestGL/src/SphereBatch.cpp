@@ -0,0 +1,80 @@
+#include "SphereBatch.h"
+#include <cstdint>
+#include <cstring>
+
+void bindSphereInstances(unsigned int buffer, size_t offset) {
+    const GLsizei stride = sizeof(SphereInstance);
+    const uintptr_t base = offset;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (unsigned int column = 0; column < 4; ++column) {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, stride,
+            (void*)(base + offsetof(SphereInstance, model) + column * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SphereInstance, color)));
+    glVertexAttribIPointer(8, 4, GL_INT, stride, (void*)(base + offsetof(SphereInstance, flags)));
+    for (unsigned int location = 3; location <= 8; ++location) {
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+}
+
+SphereBatch::SphereBatch(const Sphere& unitSphere, bool allowPersistent, size_t lod)
+    : instanceStream(GL_ARRAY_BUFFER, allowPersistent), indexCount(unitSphere.lods[lod].indexCount),
+      indexType(unitSphere.indexType),
+      indexOffset(unitSphere.lods[lod].firstIndex * (unitSphere.indexType == GL_UNSIGNED_SHORT ? 2 : 4)) {
+    glGenVertexArrays(1, &VAO);
+
+    glBindVertexArray(VAO);
+    bindSphereVertices(unitSphere);
+
+    // The instance attributes are pointed at the stream once it has data.
+    glBindVertexArray(0);
+}
+
+SphereBatch::~SphereBatch() {
+    glDeleteVertexArrays(1, &VAO);
+}
+
+// The stream moves the data on every upload, and GL 3.3 has no base
+// instance, so both are handled by moving the attribute pointers. Expects
+// the vertex array to be bound.
+void SphereBatch::pointInstanceAttributes(size_t first) {
+    attributeBase = dataOffset + first * sizeof(SphereInstance);
+    bindSphereInstances(instanceStream.id, attributeBase);
+}
+
+SphereInstance* SphereBatch::beginUpload(size_t count) {
+    instanceCount = count;
+    return static_cast<SphereInstance*>(instanceStream.begin(count * sizeof(SphereInstance)));
+}
+
+void SphereBatch::endUpload() {
+    dataOffset = instanceStream.end();
+    // geometry() draws from the first instance.
+    glBindVertexArray(VAO);
+    pointInstanceAttributes(0);
+    glBindVertexArray(0);
+}
+
+void SphereBatch::upload(const SphereInstance* instances, size_t count) {
+    std::memcpy(beginUpload(count), instances, count * sizeof(SphereInstance));
+    endUpload();
+}
+
+void SphereBatch::draw(size_t first, size_t count) {
+    if (count == 0)
+        return;
+    glBindVertexArray(VAO);
+    if (dataOffset + first * sizeof(SphereInstance) != attributeBase)
+        pointInstanceAttributes(first);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, reinterpret_cast<const void*>(indexOffset),
+        static_cast<GLsizei>(count));
+    glBindVertexArray(0);
+}
+
+DrawGeometry SphereBatch::geometry() const {
+    DrawGeometry geometry = { VAO, GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType,
+        static_cast<GLsizei>(instanceCount) };
+    geometry.indexOffset = indexOffset;
+    return geometry;
+}
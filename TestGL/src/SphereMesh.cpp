@@ -0,0 +1,357 @@
+#include "SphereMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+namespace {
+
+const float PI = 3.14159265359f;
+const float POLE_EPSILON = 1e-6f;
+const size_t MAX_VERTICES = 65536;      // addressable by 16-bit indices
+
+// Forsyth's tuning for a 32-entry cache.
+const int CACHE_SIZE = 32;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float CACHE_DECAY_POWER = 1.5f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// Triangles over shared points of the unit sphere, before texture
+// coordinates split any of them.
+struct RawSphere {
+    std::vector<glm::vec3> points;
+    std::vector<uint32_t> triangles;
+};
+
+// Like Sphere's, but with one vertex per pole and none repeated on the seam.
+RawSphere uvSphere(int sectors) {
+    sectors = std::max(sectors, 3);
+    const int stacks = std::max(sectors / 2, 2);
+    RawSphere raw;
+    raw.points.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+    for (int i = 1; i < stacks; ++i) {
+        float stackAngle = PI / 2 - i * PI / stacks;
+        for (int j = 0; j < sectors; ++j) {
+            float sectorAngle = j * 2 * PI / sectors;
+            raw.points.push_back(glm::vec3(cosf(stackAngle) * cosf(sectorAngle), cosf(stackAngle) * sinf(sectorAngle),
+                sinf(stackAngle)));
+        }
+    }
+    raw.points.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+
+    const uint32_t south = static_cast<uint32_t>(raw.points.size() - 1);
+    auto ring = [&](int i, int j) { return static_cast<uint32_t>(1 + (i - 1) * sectors + j % sectors); };
+    for (int j = 0; j < sectors; ++j) {
+        raw.triangles.insert(raw.triangles.end(), { 0, ring(1, j), ring(1, j + 1) });
+        raw.triangles.insert(raw.triangles.end(), { ring(stacks - 1, j), south, ring(stacks - 1, j + 1) });
+        for (int i = 1; i < stacks - 1; ++i) {
+            raw.triangles.insert(raw.triangles.end(), { ring(i, j), ring(i + 1, j), ring(i, j + 1) });
+            raw.triangles.insert(raw.triangles.end(), { ring(i, j + 1), ring(i + 1, j), ring(i + 1, j + 1) });
+        }
+    }
+    return raw;
+}
+
+// An icosahedron standing on a vertex at each pole, each face split into
+// four per subdivision with the new points pushed out onto the sphere.
+RawSphere icosphere(int subdivisions) {
+    RawSphere raw;
+    const float ringZ = 1.0f / std::sqrt(5.0f), ringRadius = 2.0f / std::sqrt(5.0f);
+    raw.points.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+    for (int k = 0; k < 5; ++k) {
+        float angle = k * 2 * PI / 5;
+        raw.points.push_back(glm::vec3(ringRadius * cosf(angle), ringRadius * sinf(angle), ringZ));
+    }
+    for (int k = 0; k < 5; ++k) {
+        float angle = (k + 0.5f) * 2 * PI / 5;
+        raw.points.push_back(glm::vec3(ringRadius * cosf(angle), ringRadius * sinf(angle), -ringZ));
+    }
+    raw.points.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+    for (uint32_t k = 0; k < 5; ++k) {
+        uint32_t upper = 1 + k, upperNext = 1 + (k + 1) % 5, lower = 6 + k, lowerNext = 6 + (k + 1) % 5;
+        raw.triangles.insert(raw.triangles.end(), { 0, upper, upperNext });
+        raw.triangles.insert(raw.triangles.end(), { upper, lower, upperNext });
+        raw.triangles.insert(raw.triangles.end(), { upperNext, lower, lowerNext });
+        raw.triangles.insert(raw.triangles.end(), { lower, 11, lowerNext });
+    }
+
+    for (int s = 0; s < subdivisions; ++s) {
+        std::unordered_map<uint64_t, uint32_t> midpoints;
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            uint64_t key = static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())
+                return found->second;
+            uint32_t index = static_cast<uint32_t>(raw.points.size());
+            raw.points.push_back(glm::normalize(raw.points[a] + raw.points[b]));
+            midpoints.emplace(key, index);
+            return index;
+        };
+        std::vector<uint32_t> split;
+        split.reserve(raw.triangles.size() * 4);
+        for (size_t t = 0; t < raw.triangles.size(); t += 3) {
+            uint32_t a = raw.triangles[t], b = raw.triangles[t + 1], c = raw.triangles[t + 2];
+            uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            split.insert(split.end(), { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca });
+        }
+        raw.triangles.swap(split);
+    }
+    return raw;
+}
+
+// Each face of a cube as a grid of cells, mapped onto the sphere so the
+// cells stay close to the same size. Points on shared edges are repeated
+// here and merged when the mesh is packed.
+RawSphere cubeSphere(int cells) {
+    cells = std::max(cells + cells % 2, 2);
+    const glm::vec3 faces[6][3] = {
+        { glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1) },
+        { glm::vec3(-1, 0, 0), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0) },
+        { glm::vec3(0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0) },
+        { glm::vec3(0, -1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1) },
+        { glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0) },
+        { glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0) },
+    };
+    RawSphere raw;
+    for (const auto& face : faces) {
+        uint32_t first = static_cast<uint32_t>(raw.points.size());
+        for (int i = 0; i <= cells; ++i) {
+            for (int j = 0; j <= cells; ++j) {
+                glm::vec3 p = face[0] + (2.0f * i / cells - 1.0f) * face[1] + (2.0f * j / cells - 1.0f) * face[2];
+                glm::vec3 p2 = p * p;
+                raw.points.push_back(glm::vec3(
+                    p.x * std::sqrt(1.0f - p2.y / 2 - p2.z / 2 + p2.y * p2.z / 3),
+                    p.y * std::sqrt(1.0f - p2.z / 2 - p2.x / 2 + p2.z * p2.x / 3),
+                    p.z * std::sqrt(1.0f - p2.x / 2 - p2.y / 2 + p2.x * p2.y / 3)));
+            }
+        }
+        for (int i = 0; i < cells; ++i) {
+            for (int j = 0; j < cells; ++j) {
+                uint32_t a = first + i * (cells + 1) + j, b = a + cells + 1;
+                raw.triangles.insert(raw.triangles.end(), { a, b, a + 1, a + 1, b, b + 1 });
+            }
+        }
+    }
+    return raw;
+}
+
+// Sphere's mapping: u around the z axis from +x, v from +z.
+glm::vec2 sphereTexCoord(const glm::vec3& p) {
+    float u = std::atan2(p.y, p.x) / (2 * PI);
+    if (u < 0.0f)
+        u += 1.0f;
+    return glm::vec2(u, std::acos(std::clamp(p.z, -1.0f, 1.0f)) / PI);
+}
+
+// The normal folded onto the octahedron and its lower half unfolded over
+// the corners of the square.
+glm::vec2 octahedralEncode(const glm::vec3& n) {
+    glm::vec2 p = glm::vec2(n) / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+    if (n.z < 0.0f) {
+        glm::vec2 folded = 1.0f - glm::abs(glm::vec2(p.y, p.x));
+        p = glm::vec2(p.x >= 0.0f ? folded.x : -folded.x, p.y >= 0.0f ? folded.y : -folded.y);
+    }
+    return p;
+}
+
+int16_t packSnorm(float v) {
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+uint16_t packUnorm(float v) {
+    return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+}
+
+// Turns every triangle outwards, gives each corner its texture coordinates
+// and merges corners that pack to the same bits. A triangle across the seam
+// gets copies of its low-u corners at u + 1, and a corner on a pole takes
+// the u of the rest of its triangle, so no triangle smears the whole map.
+bool packSphere(const RawSphere& raw, CompactSphereMesh& mesh) {
+    std::unordered_map<uint64_t, uint16_t> merged;
+    for (size_t t = 0; t < raw.triangles.size(); t += 3) {
+        uint32_t corners[3] = { raw.triangles[t], raw.triangles[t + 1], raw.triangles[t + 2] };
+        glm::vec3 a = raw.points[corners[0]], b = raw.points[corners[1]], c = raw.points[corners[2]];
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+        if (glm::dot(normal, a + b + c) < 0.0f) {
+            std::swap(corners[1], corners[2]);
+            normal = -normal;
+        }
+        // The plane is nearest the centre at the foot of the perpendicular,
+        // which falls inside the triangle on these meshes.
+        mesh.error = std::max(mesh.error, 1.0f - glm::dot(normal, a));
+
+        glm::vec2 texCoords[3];
+        bool pole[3];
+        float low = 1.0f, high = 0.0f;
+        for (int k = 0; k < 3; ++k) {
+            const glm::vec3& p = raw.points[corners[k]];
+            texCoords[k] = sphereTexCoord(p);
+            pole[k] = std::abs(p.z) > 1.0f - POLE_EPSILON;
+            if (!pole[k]) {
+                low = std::min(low, texCoords[k].x);
+                high = std::max(high, texCoords[k].x);
+            }
+        }
+        float poleU = 0.0f;
+        int around = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (pole[k])
+                continue;
+            if (high - low > 0.5f && texCoords[k].x < 0.5f)
+                texCoords[k].x += 1.0f;
+            poleU += texCoords[k].x;
+            ++around;
+        }
+        for (int k = 0; k < 3; ++k) {
+            if (pole[k])
+                texCoords[k].x = poleU / std::max(around, 1);
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            glm::vec2 octahedral = octahedralEncode(raw.points[corners[k]]);
+            CompactSphereVertex vertex = { { packSnorm(octahedral.x), packSnorm(octahedral.y) },
+                { packUnorm(texCoords[k].x * 0.5f), packUnorm(texCoords[k].y) } };
+            uint64_t key = static_cast<uint64_t>(static_cast<uint16_t>(vertex.normal[0]))
+                | static_cast<uint64_t>(static_cast<uint16_t>(vertex.normal[1])) << 16
+                | static_cast<uint64_t>(vertex.texCoord[0]) << 32 | static_cast<uint64_t>(vertex.texCoord[1]) << 48;
+            auto found = merged.find(key);
+            if (found == merged.end()) {
+                if (mesh.vertices.size() == MAX_VERTICES)
+                    return false;
+                found = merged.emplace(key, static_cast<uint16_t>(mesh.vertices.size())).first;
+                mesh.vertices.push_back(vertex);
+            }
+            mesh.indices.push_back(found->second);
+        }
+    }
+    return true;
+}
+
+float vertexScore(int cachePosition, uint32_t liveTriangles) {
+    if (liveTriangles == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 3)
+        score = std::pow(1.0f - float(cachePosition - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    else if (cachePosition >= 0)
+        score = LAST_TRIANGLE_SCORE;
+    return score + VALENCE_BOOST_SCALE * std::pow(float(liveTriangles), -VALENCE_BOOST_POWER);
+}
+
+}
+
+CompactSphereMesh buildCompactSphere(SphereTopology topology, int detail) {
+    RawSphere raw;
+    switch (topology) {
+    case SphereTopology::ICOSPHERE:
+        raw = icosphere(std::max(detail, 0));
+        break;
+    case SphereTopology::CUBE_SPHERE:
+        raw = cubeSphere(detail);
+        break;
+    default:
+        raw = uvSphere(detail);
+        break;
+    }
+
+    CompactSphereMesh mesh;
+    if (!packSphere(raw, mesh)) {
+        std::cout << "ERROR: sphere mesh of detail " << detail << " needs more than " << MAX_VERTICES
+                  << " vertices for 16-bit indices" << std::endl;
+        return CompactSphereMesh();
+    }
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+
+    // Vertices in the order the triangles first reach them, for fetch locality.
+    std::vector<int32_t> remap(mesh.vertices.size(), -1);
+    std::vector<CompactSphereVertex> ordered;
+    ordered.reserve(mesh.vertices.size());
+    for (uint16_t& index : mesh.indices) {
+        if (remap[index] < 0) {
+            remap[index] = static_cast<int32_t>(ordered.size());
+            ordered.push_back(mesh.vertices[index]);
+        }
+        index = static_cast<uint16_t>(remap[index]);
+    }
+    mesh.vertices.swap(ordered);
+    return mesh;
+}
+
+// Greedily emits the best-scoring triangle among those using a vertex in
+// the simulated cache. Vertices score for being recently used and for
+// having few triangles left, so that none is left stranded after its
+// neighbours are gone.
+void optimizeVertexCache(std::vector<uint16_t>& indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0), live(vertexCount, 0);
+    for (uint16_t index : indices)
+        ++live[index];
+    for (size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] = firstTriangle[v] + live[v];
+    // Each vertex's live triangles are kept at the front of its range.
+    std::vector<uint32_t> triangles(indices.size());
+    std::vector<uint32_t> filled(vertexCount, 0);
+    for (size_t i = 0; i < indices.size(); ++i)
+        triangles[firstTriangle[indices[i]] + filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, live[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+
+    std::vector<uint16_t> ordered;
+    ordered.reserve(indices.size());
+    std::vector<uint16_t> cache, nextCache;
+    int64_t best = -1;
+    while (ordered.size() < indices.size()) {
+        // Nothing in the cache has triangles left: start from the best
+        // remaining one anywhere, which a connected mesh needs only once.
+        if (best < 0) {
+            for (size_t t = 0; t < triangleCount; ++t) {
+                if (!emitted[t] && (best < 0 || triangleScore[t] > triangleScore[best]))
+                    best = static_cast<int64_t>(t);
+            }
+        }
+
+        emitted[best] = true;
+        nextCache.clear();
+        for (int k = 0; k < 3; ++k) {
+            uint16_t v = indices[3 * best + k];
+            ordered.push_back(v);
+            nextCache.push_back(v);
+            uint32_t* begin = &triangles[firstTriangle[v]];
+            uint32_t* end = begin + live[v];
+            std::swap(*std::find(begin, end, static_cast<uint32_t>(best)), *(end - 1));
+            --live[v];
+        }
+        for (uint16_t v : cache) {
+            if (std::find(nextCache.begin(), nextCache.begin() + 3, v) == nextCache.begin() + 3)
+                nextCache.push_back(v);
+        }
+
+        for (size_t k = 0; k < nextCache.size(); ++k) {
+            uint16_t v = nextCache[k];
+            cachePosition[v] = k < CACHE_SIZE ? static_cast<int>(k) : -1;
+            score[v] = vertexScore(cachePosition[v], live[v]);
+        }
+        best = -1;
+        for (uint16_t v : nextCache) {
+            for (uint32_t i = 0; i < live[v]; ++i) {
+                uint32_t t = triangles[firstTriangle[v] + i];
+                triangleScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+                if (best < 0 || triangleScore[t] > triangleScore[best])
+                    best = t;
+            }
+        }
+        if (nextCache.size() > CACHE_SIZE)
+            nextCache.resize(CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+    indices.swap(ordered);
+}
@@ -0,0 +1,86 @@
+#include "StreamBuffer.h"
+#include <algorithm>
+
+StreamBuffer::StreamBuffer(GLenum bufferTarget, bool allowPersistent) : target(bufferTarget) {
+    // The loader only has glBufferStorage on a 4.4 or newer context.
+    persistent = allowPersistent && glBufferStorage != nullptr;
+    glGenBuffers(1, &id);
+}
+
+StreamBuffer::~StreamBuffer() {
+    release();
+    glDeleteBuffers(1, &id);
+}
+
+void StreamBuffer::release() {
+    for (GLsync& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (mapped) {
+        glBindBuffer(target, id);
+        glUnmapBuffer(target);
+        mapped = nullptr;
+    }
+}
+
+// Buffer storage is immutable, so growing means a new buffer.
+void StreamBuffer::allocate(size_t size) {
+    regionSize = std::max(size, regionSize * 2);
+    if (!persistent)
+        return;
+
+    release();
+    glDeleteBuffers(1, &id);
+    glGenBuffers(1, &id);
+    glBindBuffer(target, id);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr total = static_cast<GLsizeiptr>(regionSize * REGIONS);
+    glBufferStorage(target, total, nullptr, flags);
+    mapped = static_cast<char*>(glMapBufferRange(target, 0, total, flags));
+    region = 0;
+}
+
+void* StreamBuffer::begin(size_t size) {
+    size = std::max<size_t>(size, 1);
+    if (!persistent) {
+        if (size > regionSize)
+            allocate(size);
+        // Orphan the storage the GPU may still be reading and map the new one.
+        glBindBuffer(target, id);
+        glBufferData(target, static_cast<GLsizeiptr>(regionSize), nullptr, GL_STREAM_DRAW);
+        return glMapBufferRange(target, 0, static_cast<GLsizeiptr>(size),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    if (mapped && fences[region] == nullptr)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (size > regionSize || !mapped)
+        allocate(size);
+    else
+        region = (region + 1) % REGIONS;
+
+    if (GLsync fence = fences[region]) {
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            ++stalls;
+            while (status == GL_TIMEOUT_EXPIRED)
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(fence);
+        fences[region] = nullptr;
+    }
+    return mapped + region * regionSize;
+}
+
+size_t StreamBuffer::end() {
+    if (!persistent) {
+        glBindBuffer(target, id);
+        glUnmapBuffer(target);
+        return 0;
+    }
+    // The mapping is coherent, so the writes are already visible.
+    return region * regionSize;
+}
@@ -0,0 +1,198 @@
+#include "SymplecticIntegrator.h"
+#include "GravityKernel.h"
+#include "KeplerPropagator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 256 bodies per tile: the receiving tile's positions and accelerations
+// (12 KB of doubles) plus the source tile's positions and masses (8 KB)
+// come to about 20 KB, inside a 32 KB L1.
+const size_t TILE = 256;
+
+// Yoshida's 4th-order composition of drift-kick-drift.
+const double CBRT2 = 1.2599210498948731;
+const double W1 = 1.0 / (2.0 - CBRT2);
+const double W0 = -CBRT2 / (2.0 - CBRT2);
+const double DRIFT[4] = { 0.5 * W1, 0.5 * (W0 + W1), 0.5 * (W0 + W1), 0.5 * W1 };
+const double KICK[3] = { W1, W0, W1 };
+
+struct ScalarOps {
+    using F = double;
+    static constexpr int width = 1;
+
+    static F set1(double v) { return v; }
+    static F loadu(const double* p) { return *p; }
+    static void storeu(double* p, F v) { *p = v; }
+    static F add(F a, F b) { return a + b; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F div(F a, F b) { return a / b; }
+    static F sqrt(F a) { return std::sqrt(a); }
+    static F max(F a, F b) { return a > b ? a : b; }
+    static F fmadd(F a, F b, F c) { return a * b + c; }
+};
+
+}
+
+void accumulateGravityScalar(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd) {
+    gravityKernel<ScalarOps>(v, iBegin, iEnd, jBegin, jEnd);
+}
+
+SymplecticIntegrator::SymplecticIntegrator() : simdLevel(detectSimdLevel()) {}
+
+SymplecticIntegrator::SymplecticIntegrator(SimdLevel level) : simdLevel(level) {
+    if (level > detectSimdLevel())
+        simdLevel = detectSimdLevel();
+}
+
+size_t SymplecticIntegrator::addBody(const glm::dvec3& position, const glm::dvec3& velocity, double bodyMass) {
+    size_t index = size();
+    posX.push_back(position.x);
+    posY.push_back(position.y);
+    posZ.push_back(position.z);
+    velX.push_back(velocity.x);
+    velY.push_back(velocity.y);
+    velZ.push_back(velocity.z);
+    accX.push_back(0.0);
+    accY.push_back(0.0);
+    accZ.push_back(0.0);
+    mass.push_back(bodyMass);
+    accelerationValid = false;
+    return index;
+}
+
+void SymplecticIntegrator::reserve(size_t count) {
+    posX.reserve(count);
+    posY.reserve(count);
+    posZ.reserve(count);
+    velX.reserve(count);
+    velY.reserve(count);
+    velZ.reserve(count);
+    accX.reserve(count);
+    accY.reserve(count);
+    accZ.reserve(count);
+    mass.reserve(count);
+}
+
+void SymplecticIntegrator::clear() {
+    posX.clear();
+    posY.clear();
+    posZ.clear();
+    velX.clear();
+    velY.clear();
+    velZ.clear();
+    accX.clear();
+    accY.clear();
+    accZ.clear();
+    mass.clear();
+    accelerationValid = false;
+}
+
+void SymplecticIntegrator::moveToBarycentricFrame() {
+    double total = 0.0;
+    glm::dvec3 centre(0.0), momentum(0.0);
+    for (size_t i = 0; i < size(); ++i) {
+        total += mass[i];
+        centre += position(i) * mass[i];
+        momentum += velocity(i) * mass[i];
+    }
+    if (total <= 0.0)
+        return;
+
+    centre /= total;
+    momentum /= total;
+    for (size_t i = 0; i < size(); ++i) {
+        posX[i] -= centre.x;
+        posY[i] -= centre.y;
+        posZ[i] -= centre.z;
+        velX[i] -= momentum.x;
+        velY[i] -= momentum.y;
+        velZ[i] -= momentum.z;
+    }
+    accelerationValid = false;
+}
+
+void SymplecticIntegrator::step(double dt) {
+    if (scheme == SymplecticScheme::Leapfrog) {
+        // Kick-drift-kick; the closing acceleration is reused by the next step.
+        if (!accelerationValid)
+            computeAccelerations();
+        kick(0.5 * dt);
+        drift(dt);
+        computeAccelerations();
+        kick(0.5 * dt);
+        return;
+    }
+
+    for (int stage = 0; stage < 3; ++stage) {
+        drift(DRIFT[stage] * dt);
+        computeAccelerations();
+        kick(KICK[stage] * dt);
+    }
+    drift(DRIFT[3] * dt);
+    accelerationValid = false;
+}
+
+void SymplecticIntegrator::drift(double dt) {
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        posX[i] += velX[i] * dt;
+        posY[i] += velY[i] * dt;
+        posZ[i] += velZ[i] * dt;
+    }
+}
+
+void SymplecticIntegrator::kick(double dt) {
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        velX[i] += accX[i] * dt;
+        velY[i] += accY[i] * dt;
+        velZ[i] += accZ[i] * dt;
+    }
+}
+
+void SymplecticIntegrator::computeAccelerations() {
+    const size_t n = size();
+    GravityView view = { posX.data(), posY.data(), posZ.data(), mass.data(), accX.data(), accY.data(), accZ.data() };
+
+    std::fill(accX.begin(), accX.end(), 0.0);
+    std::fill(accY.begin(), accY.end(), 0.0);
+    std::fill(accZ.begin(), accZ.end(), 0.0);
+
+    for (size_t iTile = 0; iTile < n; iTile += TILE) {
+        const size_t iEnd = std::min(iTile + TILE, n);
+        for (size_t jTile = 0; jTile < n; jTile += TILE) {
+            const size_t jEnd = std::min(jTile + TILE, n);
+            switch (simdLevel) {
+            case SimdLevel::AVX512:
+                accumulateGravityAvx512(view, iTile, iEnd, jTile, jEnd);
+                break;
+            case SimdLevel::AVX2:
+                accumulateGravityAvx2(view, iTile, iEnd, jTile, jEnd);
+                break;
+            default:
+                accumulateGravityScalar(view, iTile, iEnd, jTile, jEnd);
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        accX[i] *= gravitationalConstant;
+        accY[i] *= gravitationalConstant;
+        accZ[i] *= gravitationalConstant;
+    }
+    accelerationValid = true;
+}
+
+double SymplecticIntegrator::energy() const {
+    double kinetic = 0.0, potential = 0.0;
+    for (size_t i = 0; i < size(); ++i) {
+        kinetic += 0.5 * mass[i] * glm::dot(velocity(i), velocity(i));
+        for (size_t j = i + 1; j < size(); ++j)
+            potential -= gravitationalConstant * mass[i] * mass[j] / glm::length(position(j) - position(i));
+    }
+    return kinetic + potential;
+}
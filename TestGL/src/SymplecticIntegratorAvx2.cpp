@@ -0,0 +1,36 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "GravityKernel.h"
+
+namespace {
+
+struct Avx2Ops {
+    using F = __m256d;
+    static constexpr int width = 4;
+
+    static F set1(double v) { return _mm256_set1_pd(v); }
+    static F loadu(const double* p) { return _mm256_loadu_pd(p); }
+    static void storeu(double* p, F v) { _mm256_storeu_pd(p, v); }
+    static F add(F a, F b) { return _mm256_add_pd(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_pd(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_pd(a, b); }
+    static F div(F a, F b) { return _mm256_div_pd(a, b); }
+    static F sqrt(F a) { return _mm256_sqrt_pd(a); }
+    static F max(F a, F b) { return _mm256_max_pd(a, b); }
+    static F fmadd(F a, F b, F c) { return _mm256_fmadd_pd(a, b, c); }
+};
+
+}
+
+void accumulateGravityAvx2(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd) {
+    gravityKernel<Avx2Ops>(v, iBegin, iEnd, jBegin, jEnd);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,36 @@
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "GravityKernel.h"
+
+namespace {
+
+struct Avx512Ops {
+    using F = __m512d;
+    static constexpr int width = 8;
+
+    static F set1(double v) { return _mm512_set1_pd(v); }
+    static F loadu(const double* p) { return _mm512_loadu_pd(p); }
+    static void storeu(double* p, F v) { _mm512_storeu_pd(p, v); }
+    static F add(F a, F b) { return _mm512_add_pd(a, b); }
+    static F sub(F a, F b) { return _mm512_sub_pd(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_pd(a, b); }
+    static F div(F a, F b) { return _mm512_div_pd(a, b); }
+    static F sqrt(F a) { return _mm512_sqrt_pd(a); }
+    static F max(F a, F b) { return _mm512_max_pd(a, b); }
+    static F fmadd(F a, F b, F c) { return _mm512_fmadd_pd(a, b, c); }
+};
+
+}
+
+void accumulateGravityAvx512(const GravityView& v, size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd) {
+    gravityKernel<Avx512Ops>(v, iBegin, iEnd, jBegin, jEnd);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
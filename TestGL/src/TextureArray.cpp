@@ -0,0 +1,89 @@
+#include "TextureArray.h"
+#include <stb_image.h>
+#include <iostream>
+
+int TextureArray::load(const std::vector<const char*>& paths, int layerWidth, int layerHeight, bool flipVertically) {
+    width = layerWidth;
+    height = layerHeight;
+    loaded.assign(paths.size(), false);
+
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (static_cast<GLint>(paths.size()) > maxLayers) {
+        std::cout << "ERROR: " << paths.size() << " texture layers requested, the driver allows " << maxLayers
+            << std::endl;
+        return 0;
+    }
+
+    glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, static_cast<GLsizei>(paths.size()), 0, GL_RGBA,
+        GL_UNSIGNED_BYTE, nullptr);
+
+    int count = 0;
+    stbi_set_flip_vertically_on_load(flipVertically);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        int imageWidth, imageHeight, nrChannels;
+        unsigned char* data = stbi_load(paths[i], &imageWidth, &imageHeight, &nrChannels, 4);
+        if (!data) {
+            std::cout << "ERROR: Failed to load texture at path: " << paths[i] << std::endl;
+            continue;
+        }
+        copyToLayer(data, imageWidth, imageHeight, static_cast<int>(i));
+        stbi_image_free(data);
+        loaded[i] = true;
+        ++count;
+        std::cout << "✓ Texture loaded: " << paths[i] << " (layer " << i << ")" << std::endl;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return count;
+}
+
+int TextureArray::layer(int index) const {
+    return index >= 0 && index < layerCount() && loaded[index] ? index : -1;
+}
+
+// An image of the layer size is uploaded as is. Any other goes up as a
+// mipmapped 2D texture and is blitted from the level nearest the layer size,
+// so a large image is box-filtered down rather than point-sampled.
+void TextureArray::copyToLayer(const unsigned char* pixels, int imageWidth, int imageHeight, int layerIndex) {
+    if (imageWidth == width && imageHeight == height) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layerIndex, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+            pixels);
+        return;
+    }
+
+    unsigned int staging;
+    glGenTextures(1, &staging);
+    glBindTexture(GL_TEXTURE_2D, staging);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    int level = 0;
+    while ((imageWidth >> (level + 1)) >= width && (imageHeight >> (level + 1)) >= height)
+        ++level;
+    if (level > 0)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    GLint readBinding = 0, drawBinding = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readBinding);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawBinding);
+    unsigned int framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, staging, level);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, ID, 0, layerIndex);
+    glBlitFramebuffer(0, 0, imageWidth >> level, imageHeight >> level, 0, 0, width, height, GL_COLOR_BUFFER_BIT,
+        GL_LINEAR);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readBinding);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawBinding);
+    glDeleteFramebuffers(2, framebuffers);
+    glDeleteTextures(1, &staging);
+}
@@ -0,0 +1,38 @@
+#include "Benchmarks.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef TESTGL_COUNT_ALLOCATIONS
+
+// Replaces the global operator new so benchmarks can count allocations. Every
+// allocation then bumps one shared atomic, so only the Debug configurations
+// define TESTGL_COUNT_ALLOCATIONS; Release keeps the library's operator new.
+static std::atomic<size_t> allocations{ 0 };
+
+size_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+#else
+
+size_t allocationCount() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "Benchmarks.h"
+#include "BarnesHut.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static void fillDisk(BarnesHutSimulation& simulation, size_t count) {
+    simulation.clear();
+    simulation.softening = 0.05f;
+    // Central star plus a massive disk, so self-gravity matters to the tree.
+    simulation.addParticle(glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
+    addParticleDisk(simulation, count - 1, glm::vec3(0.0f), 1.0f, 0.05f, 10.0f, 100.0f, 7);
+}
+
+static double stepSeconds(BarnesHutSimulation& simulation, int steps, double& build, double& force) {
+    build = force = 0.0;
+    BenchTimer timer;
+    for (int s = 0; s < steps; ++s) {
+        simulation.step(0.01f);
+        build += simulation.lastBuildSeconds;
+        force += simulation.lastForceSeconds;
+    }
+    build /= steps;
+    force /= steps;
+    return timer.elapsedSeconds() / steps;
+}
+
+void benchBarnesHut() {
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < hardware; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(hardware);
+
+    // Strong scaling at a fixed problem size.
+    const size_t scalingCount = 100000;
+    std::printf("%zu particles, theta 0.5\n", scalingCount);
+    std::printf("%8s %10s %10s %10s %8s\n", "threads", "build ms", "force ms", "step ms", "speedup");
+    double baseline = 0.0;
+    for (unsigned threads : threadCounts) {
+        ThreadPool pool(threads);
+        BarnesHutSimulation simulation(pool);
+        fillDisk(simulation, scalingCount);
+        simulation.computeForces();
+
+        double build, force;
+        double seconds = stepSeconds(simulation, 5, build, force);
+        if (baseline == 0.0)
+            baseline = seconds;
+        std::printf("%8u %10.2f %10.2f %10.2f %7.2fx\n", threads, build * 1e3, force * 1e3, seconds * 1e3,
+            baseline / seconds);
+    }
+
+    ThreadPool pool(hardware);
+
+    // Opening-angle sweep: cost against force error relative to direct summation.
+    std::printf("\nopening angle, %zu particles, %u threads\n", scalingCount, hardware);
+    std::printf("%8s %10s %12s %12s\n", "theta", "force ms", "max error", "rms error");
+    BarnesHutSimulation simulation(pool);
+    fillDisk(simulation, scalingCount);
+    const float thetas[] = { 0.3f, 0.5f, 0.7f, 1.0f };
+    for (float theta : thetas) {
+        simulation.theta = theta;
+        simulation.computeForces();
+        simulation.computeForces();
+
+        double maxError = 0.0, sumSquared = 0.0;
+        int samples = 0;
+        for (size_t i = 1; i < simulation.size(); i += simulation.size() / 64) {
+            glm::vec3 reference = simulation.directAcceleration(i);
+            glm::vec3 tree(simulation.accX[i], simulation.accY[i], simulation.accZ[i]);
+            double err = glm::length(tree - reference) / glm::length(reference);
+            maxError = std::max(maxError, err);
+            sumSquared += err * err;
+            ++samples;
+        }
+        std::printf("%8.2f %10.2f %12.2e %12.2e\n", theta, simulation.lastForceSeconds * 1e3, maxError,
+            std::sqrt(sumSquared / samples));
+    }
+
+    // Upper end of the target range.
+    const size_t largeCount = 1000000;
+    fillDisk(simulation, largeCount);
+    simulation.theta = 0.5f;
+    simulation.computeForces();
+    double build, force;
+    double seconds = stepSeconds(simulation, 2, build, force);
+    std::printf("\n%zu particles, %u threads: build %.1f ms, force %.1f ms, step %.1f ms\n", largeCount, hardware,
+        build * 1e3, force * 1e3, seconds * 1e3);
+}
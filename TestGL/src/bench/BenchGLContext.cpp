@@ -0,0 +1,39 @@
+#include "Benchmarks.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+BenchGLContext::BenchGLContext() {
+    if (!glfwInit()) {
+        std::cout << "ERROR: cannot initialize GLFW for the rendering benchmarks" << std::endl;
+        return;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* hidden = glfwCreateWindow(256, 256, "TestGL bench", NULL, NULL);
+    if (hidden == NULL) {
+        std::cout << "ERROR: cannot create a GL 3.3 context for the rendering benchmarks" << std::endl;
+        glfwTerminate();
+        return;
+    }
+    glfwMakeContextCurrent(hidden);
+    // No vsync, so timings measure the work and not the display.
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "ERROR: cannot load GL functions for the rendering benchmarks" << std::endl;
+        glfwDestroyWindow(hidden);
+        glfwTerminate();
+        return;
+    }
+    window = hidden;
+    ok = true;
+}
+
+BenchGLContext::~BenchGLContext() {
+    if (window) {
+        glfwDestroyWindow(static_cast<GLFWwindow*>(window));
+        glfwTerminate();
+    }
+}
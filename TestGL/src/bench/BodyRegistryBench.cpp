@@ -0,0 +1,125 @@
+#include "Benchmarks.h"
+#include "BodyRegistry.h"
+#include "JulianDate.h"
+#include <cstdio>
+#include <random>
+
+static void fillRegistry(BodyRegistry& registry, size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> distance(20.0f, 400.0f);
+    std::uniform_real_distribution<float> eccentricity(0.0f, 0.2f);
+    std::uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+
+    registry.clear();
+    registry.reserve(count);
+    registry.orbits.epoch = J2000;
+    for (size_t i = 0; i < count; ++i) {
+        BodyDesc desc;
+        desc.name = "body" + std::to_string(i);
+        float a = distance(rng);
+        desc.orbit.semiMajor = a;
+        desc.orbit.eccentricity = eccentricity(rng);
+        desc.orbit.ascendingNode = phase(rng);
+        desc.orbit.argPeriapsis = phase(rng);
+        desc.orbit.meanAnomaly = phase(rng);
+        desc.orbit.meanMotion = 20.0 / a;
+        desc.spinRate = 6.28;
+        // Every tenth body is a satellite of the previous planet.
+        if (i % 10 == 9) {
+            desc.parent = static_cast<int32_t>(i - 1);
+            desc.orbit.semiMajor = 5.0;
+        }
+        registry.addBody(desc);
+    }
+}
+
+// Planets, each followed by its satellites, so a planet's subtree is one
+// contiguous block as it would be when a system is loaded body by body.
+static void fillSatellites(BodyRegistry& registry, size_t planets, size_t satellites) {
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> distance(1.0f, 10.0f);
+
+    registry.clear();
+    registry.reserve(planets * (satellites / planets + 1));
+    registry.orbits.epoch = J2000;
+    for (size_t p = 0; p < planets; ++p) {
+        BodyDesc planet;
+        planet.name = "planet" + std::to_string(p);
+        planet.orbit.semiMajor = 40.0 + 30.0 * p;
+        planet.orbit.meanAnomaly = phase(rng);
+        planet.orbit.meanMotion = 20.0 / planet.orbit.semiMajor;
+        int32_t planetId = static_cast<int32_t>(registry.addBody(planet));
+
+        for (size_t s = 0; s < satellites / planets; ++s) {
+            BodyDesc moon;
+            moon.name = planet.name + "/" + std::to_string(s);
+            moon.parent = planetId;
+            moon.orbit.semiMajor = distance(rng);
+            moon.orbit.ascendingNode = phase(rng);
+            moon.orbit.meanAnomaly = phase(rng);
+            moon.orbit.meanMotion = 1.0 / moon.orbit.semiMajor;
+            registry.addBody(moon);
+        }
+    }
+}
+
+static double updateSeconds(BodyRegistry& registry, uint32_t moved, int repeats) {
+    BenchTimer timer;
+    for (int r = 0; r < repeats; ++r) {
+        registry.setLocalPosition(moved, registry.localPosition(moved) + glm::vec3(0.001f));
+        registry.updateWorldPositions();
+    }
+    return timer.elapsedSeconds() / repeats;
+}
+
+static void benchHierarchy() {
+    const size_t planets = 8, satellites = 100000;
+    BodyRegistry registry;
+    fillSatellites(registry, planets, satellites);
+    const size_t count = registry.size();
+    const uint32_t firstPlanet = 0;
+    const uint32_t lastPlanet = static_cast<uint32_t>(count - satellites / planets - 1);
+
+    std::printf("\n%zu satellites of %zu planets\n", satellites, planets);
+    const int frames = 200;
+    BenchTimer timer;
+    for (int f = 0; f < frames; ++f)
+        registry.evaluate(J2000 + f / 60.0);
+    std::printf("  evaluate, every orbit moves:   %8.3f ms\n", timer.elapsedSeconds() * 1e3 / frames);
+
+    // Time held still: only one planet's frame moves.
+    std::printf("  first planet moved:            %8.3f ms\n", updateSeconds(registry, firstPlanet, 1000) * 1e3);
+    std::printf("  last planet moved:             %8.3f ms\n", updateSeconds(registry, lastPlanet, 1000) * 1e3);
+
+    timer.reset();
+    for (int r = 0; r < 1000; ++r)
+        registry.updateWorldPositions();
+    std::printf("  nothing moved:                 %8.3f ms  (checksum %.3f)\n", timer.elapsedSeconds(),
+        registry.posX[count - 1]);
+}
+
+void benchBodyRegistry() {
+    const size_t counts[] = { 4, 10000, 1000000 };
+    BodyRegistry registry;
+
+    for (size_t count : counts) {
+        fillRegistry(registry, count);
+
+        // Aim for roughly the same total work at every size.
+        size_t frames = count < 1000 ? 1000000 : 20000000 / count;
+        if (frames < 10)
+            frames = 10;
+
+        BenchTimer timer;
+        for (size_t f = 0; f < frames; ++f)
+            registry.evaluate(J2000 + f / 60.0);
+        double seconds = timer.elapsedSeconds();
+
+        double nsPerBody = seconds * 1e9 / (static_cast<double>(frames) * count);
+        double msPerFrame = seconds * 1e3 / frames;
+        std::printf("%8zu bodies: %8.3f ms/frame  %6.2f ns/body  (checksum %.3f)\n",
+            count, msPerFrame, nsPerBody, registry.posX[count - 1]);
+    }
+    benchHierarchy();
+}
@@ -0,0 +1,102 @@
+#include "Benchmarks.h"
+#include "ElementCatalog.h"
+#include "JulianDate.h"
+#include "KeplerPropagator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes `count` MPCORB-format records, replacing every 10000th with a
+// truncated line so validation is exercised. Returns the number of bad lines.
+static size_t writeSyntheticCatalog(const std::string& path, size_t count) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return 0;
+
+    std::fputs("MINOR PLANET CENTER ORBIT DATABASE (MPCORB)\n\nDes'n     H     G   Epoch     M        Peri."
+        "      Node       Incl.       e            n           a\n", file);
+    std::fputs("----------------------------------------------------------------------------------------------------"
+        "-------------------------------------------------------------------------------------------------\n", file);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> semiMajor(1.8, 3.6);
+    std::uniform_real_distribution<double> eccentricity(0.0, 0.35);
+    std::uniform_real_distribution<double> inclination(0.0, 30.0);
+    std::uniform_real_distribution<double> angle(0.0, 359.99999);
+
+    size_t bad = 0;
+    char line[256];
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 10000 == 9999) {
+            std::fputs("0123456 14.2  0.15 K2555 188.70269   73.27343\n", file);
+            ++bad;
+            continue;
+        }
+        double a = semiMajor(rng);
+        double motion = 0.9856076686 / (a * std::sqrt(a));
+        std::snprintf(line, sizeof(line),
+            "%07zu %5.2f  0.15 K2555 %9.5f  %9.5f  %9.5f  %9.5f  %9.7f %11.8f %11.7f  0 E2024-V47  7330 125 "
+            "1801-2024 0.80 M-v 30k MPCLINUX   4000 %-26s 20241101\n",
+            i % 10000000, 10.0 + (i % 800) * 0.01, angle(rng), angle(rng), angle(rng), inclination(rng),
+            eccentricity(rng), motion, a, "(synthetic)");
+        std::fputs(line, file);
+    }
+    std::fclose(file);
+    return bad;
+}
+
+void benchCatalogIngest() {
+    const size_t count = 1000000;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string input = (directory / "mpcorb_bench.dat").string();
+    const std::string output = (directory / "mpcorb_bench.elem").string();
+
+    BenchTimer timer;
+    size_t bad = writeSyntheticCatalog(input, count);
+    double inputMB = std::filesystem::file_size(input) / 1048576.0;
+    std::printf("generated %zu records (%.0f MB) in %.2f s\n", count, inputMB, timer.elapsedSeconds());
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < hardware; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(hardware);
+
+    std::printf("%8s %10s %10s %12s %8s %10s\n", "threads", "seconds", "MB/s", "Mrecords/s", "speedup", "rejected");
+    double baseline = 0.0;
+    for (unsigned threads : threadCounts) {
+        ThreadPool pool(threads);
+        CatalogIngestStats stats;
+        if (!ingestElementCatalog(input, output, pool, stats))
+            break;
+        if (baseline == 0.0)
+            baseline = stats.seconds;
+        std::printf("%8u %10.3f %10.0f %12.2f %7.2fx %6zu/%zu\n", threads, stats.seconds,
+            stats.bytes / 1048576.0 / stats.seconds, stats.records / stats.seconds * 1e-6, baseline / stats.seconds,
+            stats.rejected, bad);
+    }
+
+    ElementCatalog catalog;
+    timer.reset();
+    if (catalog.open(output)) {
+        double openSeconds = timer.elapsedSeconds();
+        std::vector<float> x(catalog.size()), y(catalog.size()), z(catalog.size());
+        KeplerPropagator propagator;
+        timer.reset();
+        propagator.propagateRange(catalog.view(), catalog.epoch(), J2000 + 9000.0, x.data(), y.data(), z.data(),
+            0, catalog.size());
+        std::printf("catalog %.1f MB, mapped in %.1f us, first propagation of %zu orbits %.1f ms (%s)\n",
+            std::filesystem::file_size(output) / 1048576.0, openSeconds * 1e6, catalog.size(),
+            timer.elapsedSeconds() * 1e3, simdLevelName(propagator.level()));
+        catalog.close();
+    }
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
@@ -0,0 +1,149 @@
+#include "Benchmarks.h"
+#include "ConjunctionSweep.h"
+#include "JulianDate.h"
+#include "KeplerPropagator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Main-belt-like heliocentric orbits in AU and days, 30-300 km across.
+static void fillBelt(KeplerOrbitSet& orbits, std::vector<float>& radius, size_t count) {
+    const double DEG = 3.14159265358979323846 / 180.0;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> semiMajor(2.1, 3.3);
+    std::uniform_real_distribution<double> eccentricity(0.0, 0.25);
+    std::uniform_real_distribution<double> inclination(0.0, 20.0 * DEG);
+    std::uniform_real_distribution<double> angle(0.0, 6.283185307179586);
+    std::uniform_real_distribution<float> size(1e-7f, 1e-6f);
+
+    orbits.clear();
+    orbits.reserve(count);
+    orbits.epoch = J2000;
+    radius.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        KeplerElements el;
+        el.semiMajor = semiMajor(rng);
+        el.eccentricity = eccentricity(rng);
+        el.inclination = inclination(rng);
+        el.ascendingNode = angle(rng);
+        el.argPeriapsis = angle(rng);
+        el.meanAnomaly = angle(rng);
+        el.meanMotion = 0.01720209895 / std::pow(el.semiMajor, 1.5);
+        orbits.add(el);
+        radius[i] = size(rng);
+    }
+}
+
+static std::vector<std::pair<uint32_t, uint32_t>> sortedPairs(const std::vector<ConjunctionPair>& pairs) {
+    std::vector<std::pair<uint32_t, uint32_t>> sorted;
+    for (const ConjunctionPair& pair : pairs)
+        sorted.emplace_back(std::min(pair.nearBody, pair.farBody), std::max(pair.nearBody, pair.farBody));
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+// Away from the ecliptic a fixed angle spans more longitude. Checks the
+// sweep against brute force for two bodies at 80 degrees latitude, 3 degrees
+// apart in longitude (0.52 apart on the sky), and for the belt and the Sun
+// seen from 10 AU above the Sun, which puts the belt at 72 to 78 degrees and
+// the Sun on the pole.
+static void checkHighLatitudes(KeplerOrbitSet& orbits, KeplerPropagator& propagator) {
+    const float DEG = 3.14159265f / 180.0f;
+    std::vector<float> x, y, z, radius;
+    for (float longitude : { 10.0f * DEG, 13.0f * DEG }) {
+        x.push_back(5.0f * std::cos(80.0f * DEG) * std::cos(longitude));
+        y.push_back(5.0f * std::sin(80.0f * DEG));
+        z.push_back(5.0f * std::cos(80.0f * DEG) * std::sin(longitude));
+        radius.push_back(0.0f);
+    }
+
+    ConjunctionSweep sweep;
+    std::vector<ConjunctionPair> reference;
+    findConjunctionsBruteForce(x.data(), y.data(), z.data(), radius.data(), x.size(), glm::vec3(0.0f),
+        sweep.threshold, reference);
+    sweep.update(x.data(), y.data(), z.data(), radius.data(), x.size(), glm::vec3(0.0f));
+    std::printf("two bodies at 80 degrees latitude: %zu pairs, brute force %zu%s\n", sweep.pairs().size(),
+        reference.size(), sortedPairs(reference) == sortedPairs(sweep.pairs()) ? "" : " MISMATCH");
+
+    const size_t count = 10000;
+    fillBelt(orbits, radius, count);
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    propagator.propagate(orbits, J2000 + 5000.0, x.data(), y.data(), z.data());
+    x.push_back(0.0f);
+    y.push_back(0.0f);
+    z.push_back(0.0f);
+    radius.push_back(0.00465f);
+    const glm::vec3 above(0.0f, 10.0f, 0.0f);
+    findConjunctionsBruteForce(x.data(), y.data(), z.data(), radius.data(), x.size(), above, sweep.threshold,
+        reference);
+    sweep.update(x.data(), y.data(), z.data(), radius.data(), x.size(), above);
+    std::printf("belt and Sun from 10 AU above the Sun: %zu pairs, brute force %zu%s\n", sweep.pairs().size(),
+        reference.size(), sortedPairs(reference) == sortedPairs(sweep.pairs()) ? "" : " MISMATCH");
+}
+
+void benchConjunctionSweep() {
+    const double DEG = 3.14159265358979323846 / 180.0;
+    const KeplerElements earthOrbit = { 1.0000010, 0.0167, 0.0, 0.0, 102.937 * DEG, 357.529 * DEG,
+        6.283185307179586 / 365.256363 };
+    const size_t counts[] = { 1000, 10000, 100000 };
+    const int steps = 100;
+    const double stepDays = 0.25;
+
+    std::printf("seen from Earth, 0.1 degree threshold, %d steps of %.2f days\n", steps, stepDays);
+    std::printf("%8s %12s %10s %10s %12s %10s %10s %12s\n", "bodies", "first ms", "step ms", "ns/body", "swaps/step",
+        "cand/step", "pairs", "brute ms");
+
+    KeplerOrbitSet orbits;
+    KeplerPropagator propagator;
+    std::vector<float> radius;
+    for (size_t count : counts) {
+        fillBelt(orbits, radius, count);
+        std::vector<float> x(count), y(count), z(count);
+
+        ConjunctionSweep sweep;
+        sweep.threshold = static_cast<float>(0.1 * DEG);
+
+        double time = J2000 + 5000.0;
+        propagator.propagate(orbits, time, x.data(), y.data(), z.data());
+        glm::vec3 earth(keplerPosition(earthOrbit, time - J2000));
+        BenchTimer timer;
+        sweep.update(x.data(), y.data(), z.data(), radius.data(), count, earth);
+        double firstSeconds = timer.elapsedSeconds();
+
+        double seconds = 0.0;
+        size_t swaps = 0, candidates = 0, pairs = 0;
+        for (int s = 0; s < steps; ++s) {
+            time += stepDays;
+            propagator.propagate(orbits, time, x.data(), y.data(), z.data());
+            earth = glm::vec3(keplerPosition(earthOrbit, time - J2000));
+            timer.reset();
+            sweep.update(x.data(), y.data(), z.data(), radius.data(), count, earth);
+            seconds += timer.elapsedSeconds();
+            swaps += sweep.stats().swaps;
+            candidates += sweep.stats().candidates;
+            pairs += sweep.pairs().size();
+        }
+
+        char brute[32] = "-";
+        if (count <= 10000) {
+            std::vector<ConjunctionPair> reference;
+            timer.reset();
+            findConjunctionsBruteForce(x.data(), y.data(), z.data(), radius.data(), count, earth, sweep.threshold,
+                reference);
+            double bruteSeconds = timer.elapsedSeconds();
+            bool same = sortedPairs(reference) == sortedPairs(sweep.pairs());
+            std::snprintf(brute, sizeof(brute), "%.2f%s", bruteSeconds * 1e3, same ? "" : " MISMATCH");
+        }
+
+        std::printf("%8zu %12.3f %10.3f %10.1f %12zu %10zu %10zu %12s\n", count, firstSeconds * 1e3,
+            seconds * 1e3 / steps, seconds * 1e9 / (static_cast<double>(steps) * count), swaps / steps,
+            candidates / steps, pairs / steps, brute);
+    }
+
+    checkHighLatitudes(orbits, propagator);
+}
@@ -0,0 +1,156 @@
+#include "Benchmarks.h"
+#include "InstanceCuller.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include "SphereBatch.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int TARGET_SIZE = 256;            // BenchGLContext's window
+const size_t OCCLUDERS = 9;
+
+enum class CullMode { NONE, CPU_FRUSTUM, GPU_FRUSTUM, GPU_HIZ };
+
+// A sun and eight planets, then a belt of small bodies around and behind
+// them, seen from just above the belt's plane.
+void fillScene(std::vector<SphereInstance>& scene, size_t count) {
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    scene.resize(count);
+    scene[0] = { glm::scale(glm::mat4(1.0f), glm::vec3(20.0f)), glm::vec4(1.0f, 0.8f, 0.3f, 1.0f),
+        glm::ivec4(0, 0, 0, 0) };
+    for (size_t i = 1; i < count; ++i) {
+        bool planet = i < OCCLUDERS;
+        float angle = unit(rng) * 6.2831853f;
+        float distance = planet ? 25.0f + 8.0f * float(i) : 30.0f + 90.0f * unit(rng);
+        float radius = planet ? 2.0f + 2.0f * unit(rng) : 0.05f + 0.25f * unit(rng);
+        glm::vec3 position(std::cos(angle) * distance, (unit(rng) - 0.5f) * 6.0f, std::sin(angle) * distance);
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(radius));
+        scene[i] = { model, glm::vec4(0.6f, 0.6f, 0.55f, 1.0f), glm::ivec4(1, 0, 0, 0) };
+    }
+}
+
+}
+
+// Draws a belt population with each kind of culling, timing the CPU side
+// and the whole frame. Culling must not change the image, so each run's
+// pixels are compared with the unculled frame.
+void benchCulling() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    Shader shader("shaders/solar_vertex.glsl", "shaders/solar_fragment.glsl");
+    checkBlockLayouts(shader, "solar");
+    shader.use();
+    setSolarUniforms(shader, false);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 3.0f, 120.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+    UniformBuffer frameBuffer;
+    frameBuffer.create(FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+    FrameBlock frame = FrameBlock();
+    frame.view = view;
+    frame.projection = projection;
+    frame.viewPos = glm::vec4(0.0f, 3.0f, 120.0f, 1.0f);
+    frame.sunPos = glm::vec4(0.0f, 0.0f, 0.0f, 20.0f);
+    frame.sunLight = glm::vec4(1.0f, 0.95f, 0.8f, 2.0f);
+    frameBuffer.upload(&frame, sizeof(frame));
+
+    Sphere unitSphere(1.0f, 8, 4);
+    glEnable(GL_DEPTH_TEST);
+    const struct {
+        const char* name;
+        CullMode mode;
+    } runs[] = {
+        { "none", CullMode::NONE },
+        { "CPU frustum", CullMode::CPU_FRUSTUM },
+        { "GPU frustum", CullMode::GPU_FRUSTUM },
+        { "GPU frustum + Hi-Z", CullMode::GPU_HIZ },
+    };
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    const int frames = 3;
+    std::vector<SphereInstance> scene;
+    std::vector<unsigned char> reference(TARGET_SIZE * TARGET_SIZE * 4), pixels(reference.size());
+
+    std::printf("%d frames each, %u triangles per sphere, %d x %d target; the first %zu spheres occlude\n", frames,
+        unitSphere.indexCount / 3, TARGET_SIZE, TARGET_SIZE, OCCLUDERS);
+    std::printf("%10s %-20s %10s %10s %10s %10s\n", "spheres", "culling", "drawn", "cull ms", "CPU ms", "total ms");
+    for (size_t count : counts) {
+        fillScene(scene, count);
+        for (const auto& run : runs) {
+            std::unique_ptr<SphereBatch> batch;
+            std::unique_ptr<InstanceCuller> culler;
+            if (run.mode == CullMode::NONE) {
+                batch = std::make_unique<SphereBatch>(unitSphere);
+            } else {
+                culler = std::make_unique<InstanceCuller>(unitSphere, run.mode != CullMode::CPU_FRUSTUM);
+                if (run.mode != CullMode::CPU_FRUSTUM && !culler->gpu) {
+                    std::printf("%10zu %-20s %10s\n", count, run.name, "needs GL 4.3, skipped");
+                    continue;
+                }
+                culler->occlusion = run.mode == CullMode::GPU_HIZ;
+            }
+
+            RenderQueue queue;
+            DrawItem item;
+            item.program = shader.ID;
+            double cullSeconds = 0.0, cpuSeconds = 0.0, totalSeconds = 0.0;
+            size_t drawn = 0;
+            glFinish();
+            // Frame -1 compiles the programs' variants and is not timed.
+            for (int f = -1; f < frames; ++f) {
+                if (f == 0)
+                    cullSeconds = cpuSeconds = totalSeconds = 0.0;
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                BenchTimer timer;
+                if (batch) {
+                    batch->upload(scene.data(), scene.size());
+                    item.geometry = batch->geometry();
+                    queue.submit(item);
+                } else {
+                    std::memcpy(culler->beginUpload(count), scene.data(), count * sizeof(SphereInstance));
+                    culler->endUpload();
+                    BenchTimer cullTimer;
+                    culler->cull(view, projection, TARGET_SIZE, OCCLUDERS);
+                    cullSeconds += cullTimer.elapsedSeconds();
+                    for (size_t draw = 0; draw < culler->drawCount(); ++draw) {
+                        item.geometry = culler->geometry(draw);
+                        queue.submit(item);
+                    }
+                }
+                queue.flush();
+                cpuSeconds += timer.elapsedSeconds();
+                glFinish();
+                totalSeconds += timer.elapsedSeconds();
+                drawn = culler ? culler->readVisibleCount() : count;
+            }
+
+            glReadPixels(0, 0, TARGET_SIZE, TARGET_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            size_t changed = 0;
+            if (run.mode == CullMode::NONE)
+                reference = pixels;
+            for (size_t p = 0; p < pixels.size(); p += 4)
+                changed += std::memcmp(&pixels[p], &reference[p], 4) != 0;
+
+            std::printf("%10zu %-20s %10zu %10.3f %10.3f %10.3f\n", count, run.name, drawn,
+                cullSeconds / frames * 1e3, cpuSeconds / frames * 1e3, totalSeconds / frames * 1e3);
+            if (changed != 0)
+                std::printf("MISMATCH: %s culling changed %zu pixels\n", run.name, changed);
+        }
+    }
+
+    glDeleteBuffers(1, &frameBuffer.id);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
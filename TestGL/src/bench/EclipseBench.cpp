@@ -0,0 +1,162 @@
+#include "Benchmarks.h"
+#include "EclipseCatalog.h"
+#include "EclipseSearch.h"
+#include "JulianDate.h"
+#include "KeplerPropagator.h"
+#include "ShadowRaster.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Mean J2000 orbits in AU, as the scene's gravity mode uses them.
+static EclipseModel benchModel() {
+    const double DEG = 3.14159265358979323846 / 180.0;
+    const double TWO_PI = 6.283185307179586;
+    const double GAUSS_K2 = 2.959122082855911e-4;
+
+    EclipseModel model;
+    model.epoch = J2000;
+    model.earthOrbit = { 1.0000010, 0.0167, 0.0, 0.0, 102.937 * DEG, 357.529 * DEG, TWO_PI / 365.256363 };
+    double moonMotion = TWO_PI / 27.321662;
+    double moonAxis = std::cbrt(GAUSS_K2 * (3.0034896e-6 + 3.6943037e-8) / (moonMotion * moonMotion));
+    model.moonOrbit = { moonAxis, 0.0549, 5.145 * DEG, 125.08 * DEG, 318.15 * DEG, 134.963 * DEG, moonMotion };
+    return model;
+}
+
+void benchEclipseSearch() {
+    const EclipseModel model = benchModel();
+    const int searches = 200;
+    for (EclipseKind kind : { EclipseKind::Solar, EclipseKind::Lunar }) {
+        int counts[5] = {};
+        double from = J2000;
+        BenchTimer timer;
+        for (int i = 0; i < searches; ++i) {
+            EclipseEvent event = findNextEclipse(model, kind, from, 20.0 * 365.25);
+            counts[static_cast<int>(event.type)]++;
+            if (i < 3) {
+                std::printf("  %-7s %-5s greatest %s, contacts %.0f min apart\n", eclipseTypeName(event.type),
+                    kind == EclipseKind::Solar ? "solar" : "lunar", formatJulianDate(event.maximum).c_str(),
+                    (event.end - event.start) * 1440.0);
+            }
+            if (event.type == EclipseType::None)
+                break;
+            from = event.maximum + 1.0;
+        }
+        double seconds = timer.elapsedSeconds();
+        std::printf("%s: %d next-eclipse searches through %s, %.3f ms each (%d partial, %d annular, %d total)\n",
+            kind == EclipseKind::Solar ? "solar" : "lunar", searches, formatJulianDate(from).c_str(),
+            seconds * 1e3 / searches, counts[2], counts[3], counts[4]);
+    }
+}
+
+void benchEclipseCatalog() {
+    const EclipseModel model = benchModel();
+    const double from = calendarToJulianDate(1000, 1, 1.0);
+    const double to = calendarToJulianDate(3000, 1, 1.0);
+    const std::string base = (std::filesystem::temp_directory_path() / "eclipse_bench").string();
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < hardware; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(hardware);
+
+    std::printf("eclipse catalog, years 1000 to 3000\n");
+    std::printf("%8s %10s %8s %8s %12s %8s\n", "threads", "seconds", "solar", "lunar", "events/s", "speedup");
+    double baseline = 0.0;
+    for (unsigned threads : threadCounts) {
+        ThreadPool pool(threads);
+        EclipseCatalogStats stats;
+        if (!generateEclipseCatalog(model, base, from, to, false, pool, stats))
+            break;
+        if (baseline == 0.0)
+            baseline = stats.seconds;
+        std::printf("%8u %10.3f %8zu %8zu %12.0f %7.2fx\n", threads, stats.seconds, stats.solar, stats.lunar,
+            stats.events / stats.seconds, baseline / stats.seconds);
+    }
+    std::printf("catalog %.1f KB binary, %.1f KB CSV\n", std::filesystem::file_size(base + ".ecl") / 1024.0,
+        std::filesystem::file_size(base + ".csv") / 1024.0);
+
+    std::filesystem::remove(base + ".csv");
+    std::filesystem::remove(base + ".ecl");
+}
+
+void benchShadowRaster() {
+    const EclipseModel model = benchModel();
+    const double spinRate = 6.283185307179586 / 0.99726968;
+    const double pathStep = 2.0 / 1440.0;
+
+    EclipseEvent total;
+    for (double from = J2000; total.type != EclipseType::Total; from = total.maximum + 1.0)
+        total = findNextEclipse(model, EclipseKind::Solar, from, 20.0 * 365.25);
+    std::printf("total solar eclipse at %s, path sampled every %.0f min\n", formatJulianDate(total.maximum).c_str(),
+        pathStep * 1440.0);
+
+    const int width = 720, height = 360, repeats = 5;
+    ThreadPool single(1);
+    ShadowRaster reference(SimdLevel::Scalar);
+    reference.resize(width, height);
+    reference.compute(model, total.maximum, 0.0, spinRate, pathStep, single);
+
+    // Whole-eclipse path, then one instant as when scrubbing through it.
+    std::printf("%dx%d raster\n%8s %8s %10s %14s %10s %14s\n", width, height, "simd", "threads", "path ms",
+        "Mpoints/s", "max error", "frame ms");
+    ThreadPool pool;
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512 };
+    for (SimdLevel level : levels) {
+        if (level > detectSimdLevel())
+            break;
+        for (ThreadPool* threads : { &single, &pool }) {
+            if (threads == &pool && (pool.size() == 1 || level != detectSimdLevel()))
+                continue;
+            ShadowRaster raster(level);
+            raster.resize(width, height);
+            BenchTimer timer;
+            size_t evaluations = 0;
+            for (int r = 0; r < repeats; ++r) {
+                raster.invalidate();
+                raster.compute(model, total.maximum, 0.0, spinRate, pathStep, *threads);
+                evaluations += raster.evaluations();
+            }
+            double pathSeconds = timer.elapsedSeconds() / repeats;
+
+            const int frames = 200;
+            timer.reset();
+            for (int f = 0; f < frames; ++f) {
+                double t = total.maximum + (f - frames / 2) * (1.0 / 1440.0);
+                raster.compute(model, t, spinRate * (t - total.maximum), spinRate, pathStep, *threads);
+            }
+            double frameSeconds = timer.elapsedSeconds() / frames;
+
+            raster.compute(model, total.maximum, 0.0, spinRate, pathStep, *threads);
+            float error = 0.0f;
+            for (size_t i = 0; i < raster.size(); ++i)
+                error = std::max(error, std::abs(raster.path.obscuration[i] - reference.path.obscuration[i]));
+            std::printf("%8s %8u %10.2f %14.1f %10.1e %14.3f\n", simdLevelName(level), threads->size(),
+                pathSeconds * 1e3, evaluations / (pathSeconds * repeats) * 1e-6, error, frameSeconds * 1e3);
+        }
+    }
+
+    size_t central = 0, partial = 0;
+    float greatest = 0.0f;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        central += reference.path.central[i] > 0.0f;
+        partial += reference.path.obscuration[i] > 0.0f;
+        greatest = std::max(greatest, reference.now.obscuration[i]);
+    }
+    std::printf("path: %zu texels partial, %zu central; greatest obscuration at maximum %.3f\n", partial, central,
+        greatest);
+
+    // Away from an eclipse an update costs only the culling test.
+    ShadowRaster raster;
+    raster.resize(width, height);
+    BenchTimer timer;
+    for (int r = 0; r < 1000; ++r)
+        raster.compute(model, total.maximum + 10.0 + r * 0.01, 0.0, spinRate, pathStep, pool);
+    std::printf("no eclipse: %.1f us per update\n", timer.elapsedSeconds() * 1e3);
+}
@@ -0,0 +1,92 @@
+#include "Benchmarks.h"
+#include "Ephemeris.h"
+#include "JulianDate.h"
+#include "KeplerPropagator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+void benchEphemeris() {
+    const size_t count = 10000;
+    const double span = 365.25;
+    const double TWO_PI = 6.283185307179586;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> period(60.0, 700.0);
+    std::uniform_real_distribution<double> eccentricity(0.0, 0.3);
+    std::uniform_real_distribution<double> angle(0.0, TWO_PI);
+
+    std::vector<KeplerElements> elements(count);
+    std::vector<EphemerisBodySpec> specs(count);
+    KeplerOrbitSet orbits;
+    orbits.epoch = J2000;
+    for (size_t i = 0; i < count; ++i) {
+        KeplerElements& el = elements[i];
+        el.meanMotion = TWO_PI / period(rng);
+        el.semiMajor = 60.0 * std::cbrt(std::pow(TWO_PI / el.meanMotion / 365.25, 2.0));
+        el.eccentricity = eccentricity(rng);
+        el.inclination = angle(rng) * 0.05;
+        el.ascendingNode = angle(rng);
+        el.argPeriapsis = angle(rng);
+        el.meanAnomaly = angle(rng);
+        orbits.add(el);
+
+        specs[i].name = "body" + std::to_string(i);
+        specs[i].segmentDays = TWO_PI / el.meanMotion / 8.0;
+        specs[i].coefficientCount = 12;
+    }
+
+    const std::string path = (std::filesystem::temp_directory_path() / "ephemeris_bench.bin").string();
+    BenchTimer timer;
+    bool written = writeEphemeris(path, specs, J2000, J2000 + span, [&](size_t body, double jd) {
+        return keplerPosition(elements[body], jd - J2000);
+    });
+    double writeSeconds = timer.elapsedSeconds();
+    if (!written)
+        return;
+
+    Ephemeris ephemeris;
+    timer.reset();
+    if (!ephemeris.open(path))
+        return;
+    double openSeconds = timer.elapsedSeconds();
+    std::printf("%zu bodies over %.0f days: wrote %.1f MB in %.2f s, opened in %.1f us\n", count, span,
+        std::filesystem::file_size(path) / 1048576.0, writeSeconds, openSeconds * 1e6);
+
+    std::vector<double> dates(64);
+    std::uniform_real_distribution<double> date(J2000, J2000 + span);
+    for (double& d : dates)
+        d = date(rng);
+
+    std::vector<float> x(count), y(count), z(count);
+    ephemeris.evaluateRelative(dates[0], x.data(), y.data(), z.data());
+    timer.reset();
+    for (double d : dates)
+        ephemeris.evaluateRelative(d, x.data(), y.data(), z.data());
+    double ephemerisSeconds = timer.elapsedSeconds() / dates.size();
+
+    double maxError = 0.0;
+    for (size_t i = 0; i < count; i += 3) {
+        glm::dvec3 ref = keplerPosition(elements[i], dates.back() - J2000);
+        double err = glm::length(ephemeris.relativePosition(i, dates.back()) - ref) / elements[i].semiMajor;
+        maxError = std::max(maxError, err);
+    }
+
+    KeplerPropagator propagator;
+    timer.reset();
+    for (double d : dates)
+        propagator.propagate(orbits, d, x.data(), y.data(), z.data());
+    double keplerSeconds = timer.elapsedSeconds() / dates.size();
+
+    std::printf("%-22s %10s %14s\n", "", "ms/eval", "ns/body");
+    std::printf("%-22s %10.3f %14.1f\n", "ephemeris (random date)", ephemerisSeconds * 1e3, ephemerisSeconds / count * 1e9);
+    std::printf("%-22s %10.3f %14.1f\n", (std::string("kepler ") + simdLevelName(propagator.level())).c_str(),
+        keplerSeconds * 1e3, keplerSeconds / count * 1e9);
+    std::printf("max relative error against the double-precision orbit: %.2e\n", maxError);
+
+    ephemeris.close();
+    std::filesystem::remove(path);
+}
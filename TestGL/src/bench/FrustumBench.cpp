@@ -0,0 +1,87 @@
+#include "Benchmarks.h"
+#include "FrustumCulling.h"
+#include "KeplerPropagator.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The layout of learnopengl/entity.h: one heap object per body behind a
+// virtual isOnFrustum.
+struct BoundingVolume {
+    virtual ~BoundingVolume() = default;
+    virtual bool isOnFrustum(const ViewFrustum& frustum) const = 0;
+};
+
+struct BoundingSphere : BoundingVolume {
+    glm::vec3 centre;
+    float radius;
+
+    BoundingSphere(const glm::vec3& c, float r) : centre(c), radius(r) {}
+    bool isOnFrustum(const ViewFrustum& frustum) const override { return frustum.contains(centre, radius); }
+};
+
+}
+
+// Asteroid-sized spheres scattered around a camera looking down the belt,
+// culled the entity.h way and by the SoA kernels at each instruction set.
+void benchFrustumCulling() {
+    const size_t counts[] = { 100000, 1000000 };
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(100.0f, 0.0f, 30.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f));
+    const ViewFrustum frustum = frustumFromMatrix(projection * view);
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    std::printf("%10s %-18s %10s %10s %14s\n", "spheres", "method", "visible", "culled", "us per 100k");
+    for (size_t count : counts) {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> spread(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> size(0.05f, 2.0f);
+        SphereBounds bounds;
+        bounds.resize(count);
+        std::vector<std::unique_ptr<BoundingVolume>> volumes(count);
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 centre(spread(rng), spread(rng) * 0.05f, spread(rng));
+            float radius = size(rng);
+            bounds.set(i, centre, radius);
+            volumes[i] = std::make_unique<BoundingSphere>(centre, radius);
+        }
+        const int repeats = static_cast<int>(20000000 / count);
+
+        std::vector<uint32_t> reference;
+        reference.reserve(count);
+        BenchTimer timer;
+        for (int r = 0; r < repeats; ++r) {
+            reference.clear();
+            for (size_t i = 0; i < count; ++i) {
+                if (volumes[i]->isOnFrustum(frustum))
+                    reference.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        double perHundredK = timer.elapsedSeconds() / repeats * 1e6 * 100000.0 / count;
+        std::printf("%10zu %-18s %10zu %10zu %14.1f\n", count, "virtual per object", reference.size(),
+            count - reference.size(), perHundredK);
+
+        for (SimdLevel level : levels) {
+            if (level > detectSimdLevel())
+                break;
+            FrustumCuller culler(level);
+            timer.reset();
+            for (int r = 0; r < repeats; ++r)
+                culler.cull(frustum, bounds);
+            perHundredK = timer.elapsedSeconds() / repeats * 1e6 * 100000.0 / count;
+            std::printf("%10zu %-18s %10zu %10zu %14.1f\n", count, simdLevelName(level), culler.visibleCount(),
+                culler.culledCount(), perHundredK);
+
+            bool same = culler.visibleCount() == reference.size();
+            for (size_t k = 0; same && k < reference.size(); ++k)
+                same = culler.visible()[k] == reference[k];
+            if (!same)
+                std::printf("MISMATCH: %s visible list differs from the per-object test\n", simdLevelName(level));
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "Benchmarks.h"
+#include "KeplerPropagator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+void benchKeplerPropagator() {
+    const size_t count = 1000000;
+    const double time = 1234.5;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> distance(1.0, 100.0);
+    std::uniform_real_distribution<double> lowEcc(0.0, 0.3);
+    std::uniform_real_distribution<double> highEcc(0.3, 0.95);
+    std::uniform_real_distribution<double> angle(0.0, 6.283185307179586);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<KeplerElements> elements(count);
+    KeplerOrbitSet orbits;
+    orbits.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        KeplerElements& el = elements[i];
+        el.semiMajor = distance(rng);
+        // Roughly the main-belt mix: mostly low eccentricity, a tail of comets.
+        el.eccentricity = unit(rng) < 0.9 ? lowEcc(rng) : highEcc(rng);
+        el.inclination = angle(rng) * 0.1;
+        el.ascendingNode = angle(rng);
+        el.argPeriapsis = angle(rng);
+        el.meanAnomaly = angle(rng);
+        el.meanMotion = 1.0 / std::pow(el.semiMajor, 1.5);
+        orbits.add(el);
+    }
+
+    std::vector<float> x(count), y(count), z(count);
+    const SimdLevel best = detectSimdLevel();
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    for (SimdLevel level : levels) {
+        if (level > best)
+            break;
+
+        KeplerPropagator propagator(level);
+        propagator.propagate(orbits, time, x.data(), y.data(), z.data());
+
+        const int runs = 10;
+        BenchTimer timer;
+        for (int r = 0; r < runs; ++r)
+            propagator.propagate(orbits, time + r, x.data(), y.data(), z.data());
+        double seconds = timer.elapsedSeconds() / runs;
+
+        propagator.propagate(orbits, time, x.data(), y.data(), z.data());
+        double maxError = 0.0, sumSquared = 0.0;
+        size_t samples = 0;
+        for (size_t i = 0; i < count; i += 7) {
+            glm::dvec3 ref = keplerPosition(elements[i], time);
+            double err = glm::length(glm::dvec3(x[i], y[i], z[i]) - ref) / elements[i].semiMajor;
+            maxError = std::max(maxError, err);
+            sumSquared += err * err;
+            ++samples;
+        }
+
+        std::printf("%-8s %7.2f ms  %7.1f M bodies/s/core  rel. error max %.2e rms %.2e\n",
+            simdLevelName(level), seconds * 1e3, count / seconds * 1e-6, maxError, std::sqrt(sumSquared / samples));
+    }
+}
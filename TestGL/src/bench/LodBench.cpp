@@ -0,0 +1,203 @@
+#include "Benchmarks.h"
+#include "FrustumCulling.h"
+#include "InstanceCuller.h"
+#include "Sphere.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int VIEWPORT_WIDTH = 1920;
+const int VIEWPORT_HEIGHT = 1080;
+const int FRAMES = 600;
+
+struct Waypoint {
+    glm::vec3 eye;
+    glm::vec3 target;
+};
+
+// In from far out, past the Sun, skimming the Earth and the Moon, along the
+// belt, then back out.
+const Waypoint PATH[] = {
+    { glm::vec3(0.0f, 60.0f, 450.0f), glm::vec3(0.0f) },
+    { glm::vec3(30.0f, 12.0f, 40.0f), glm::vec3(0.0f) },
+    { glm::vec3(66.0f, 1.0f, 4.0f), glm::vec3(60.0f, 0.0f, 0.0f) },
+    { glm::vec3(64.0f, 0.5f, 1.2f), glm::vec3(64.0f, 0.0f, 0.0f) },
+    { glm::vec3(120.0f, 2.0f, -20.0f), glm::vec3(150.0f, 0.0f, 60.0f) },
+    { glm::vec3(90.0f, 4.0f, 110.0f), glm::vec3(0.0f, 0.0f, 140.0f) },
+    { glm::vec3(0.0f, 150.0f, 500.0f), glm::vec3(0.0f) },
+};
+
+// Sun, Earth, Moon and Mars, then a belt of small bodies.
+void fillScene(std::vector<SphereInstance>& scene, size_t asteroids) {
+    const glm::vec4 bodies[] = {
+        glm::vec4(0.0f, 0.0f, 0.0f, 10.0f),
+        glm::vec4(60.0f, 0.0f, 0.0f, 2.0f),
+        glm::vec4(64.0f, 0.0f, 0.0f, 0.5f),
+        glm::vec4(-90.0f, 0.0f, 40.0f, 1.5f),
+    };
+    std::mt19937 rng(41);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    scene.clear();
+    for (const glm::vec4& body : bodies) {
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(body)), glm::vec3(body.w));
+        scene.push_back({ model, glm::vec4(1.0f), glm::ivec4(0) });
+    }
+    for (size_t i = 0; i < asteroids; ++i) {
+        float angle = unit(rng) * 6.2831853f;
+        float distance = 100.0f + 60.0f * unit(rng);
+        glm::vec3 position(std::cos(angle) * distance, (unit(rng) - 0.5f) * 8.0f, std::sin(angle) * distance);
+        float radius = 0.05f + 0.25f * unit(rng);
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(radius));
+        scene.push_back({ model, glm::vec4(0.6f, 0.6f, 0.55f, 1.0f), glm::ivec4(1, 0, 0, 0) });
+    }
+}
+
+// Eases between waypoints, with a slow bob along the view direction of the
+// kind a hand on the mouse adds, which sits bodies on LOD thresholds.
+glm::mat4 pathView(int frame, glm::vec3& eye) {
+    const int legs = static_cast<int>(sizeof(PATH) / sizeof(PATH[0])) - 1;
+    float t = static_cast<float>(frame) / FRAMES * legs;
+    int leg = std::min(static_cast<int>(t), legs - 1);
+    float s = t - leg;
+    s = s * s * (3.0f - 2.0f * s);
+    eye = glm::mix(PATH[leg].eye, PATH[leg + 1].eye, s);
+    glm::vec3 target = glm::mix(PATH[leg].target, PATH[leg + 1].target, s);
+    glm::vec3 forward = glm::normalize(target - eye);
+    eye += forward * (0.01f * glm::length(target - eye) * std::sin(frame * 0.9f));
+    return glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+struct FlightStats {
+    double triangles = 0.0;
+    size_t maxTriangles = 0;
+    double drawn = 0.0;
+    double cullSeconds = 0.0;
+    std::vector<size_t> trianglesPerFrame;
+};
+
+FlightStats fly(InstanceCuller& culler, const std::vector<SphereInstance>& scene, const glm::mat4& projection) {
+    FlightStats stats;
+    for (int f = 0; f < FRAMES; ++f) {
+        glm::vec3 eye;
+        glm::mat4 view = pathView(f, eye);
+        std::memcpy(culler.beginUpload(scene.size()), scene.data(), scene.size() * sizeof(SphereInstance));
+        culler.endUpload();
+        BenchTimer timer;
+        // Frustum only, so the two paths draw the same bodies.
+        culler.cull(view, projection, VIEWPORT_HEIGHT, 0);
+        stats.cullSeconds += timer.elapsedSeconds();
+
+        size_t triangles = culler.readTriangleCount();
+        stats.trianglesPerFrame.push_back(triangles);
+        stats.triangles += static_cast<double>(triangles);
+        stats.maxTriangles = std::max(stats.maxTriangles, triangles);
+        stats.drawn += static_cast<double>(culler.readVisibleCount());
+    }
+    return stats;
+}
+
+// How often bodies in view change level, replaying the cull's choice.
+double switchesPerFrame(const Sphere& mesh, const SphereLodSettings& settings, const std::vector<SphereInstance>& scene,
+    const glm::mat4& projection) {
+    std::vector<int> previous(scene.size(), -1);
+    float focalPixels = projection[1][1] * VIEWPORT_HEIGHT * 0.5f;
+    size_t switches = 0;
+    for (int f = 0; f < FRAMES; ++f) {
+        glm::vec3 eye;
+        ViewFrustum frustum = frustumFromMatrix(projection * pathView(f, eye));
+        for (size_t i = 0; i < scene.size(); ++i) {
+            glm::vec3 centre(scene[i].model[3]);
+            float radius = glm::length(glm::vec3(scene[i].model[0]));
+            if (!frustum.contains(centre, radius))
+                continue;
+            int level = selectSphereLod(mesh.lods,
+                projectedSphereRadius(focalPixels, glm::length(centre - eye), radius), previous[i], settings);
+            switches += previous[i] >= 0 && level != previous[i];
+            previous[i] = level;
+        }
+    }
+    return static_cast<double>(switches) / FRAMES;
+}
+
+}
+
+// Triangles drawn per frame over a scripted fly-through, with main's old
+// fixed 48 x 48 sphere and with UV and icosphere LOD chains, with and
+// without hysteresis.
+// The CPU and GPU paths must pick the same levels.
+void benchSphereLod() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f),
+        static_cast<float>(VIEWPORT_WIDTH) / VIEWPORT_HEIGHT, 0.1f, 1000.0f);
+    std::vector<SphereInstance> scene;
+    fillScene(scene, 20000);
+    Sphere fixedSphere(1.0f, 48, 48);
+    Sphere lodSphere(1.0f, { 96, 48, 24, 12, 6 });
+    Sphere icoSphere(SphereTopology::ICOSPHERE, { 5, 4, 3, 2, 1, 0 });
+
+    std::printf("%zu spheres, %d frames at %d x %d\nUV levels:", scene.size(), FRAMES, VIEWPORT_WIDTH,
+        VIEWPORT_HEIGHT);
+    for (const SphereLod& lod : lodSphere.lods)
+        std::printf(" %d sectors (%u tris, error %.4f)", lod.detail, lod.indexCount / 3, lod.error);
+    std::printf("\nicosphere levels:");
+    for (const SphereLod& lod : icoSphere.lods)
+        std::printf(" %d (%u tris, error %.4f)", lod.detail, lod.indexCount / 3, lod.error);
+    std::printf("\n%-20s %-4s %12s %12s %10s %12s %10s\n", "mesh", "path", "tris/frame", "max tris", "drawn",
+        "switches/fr", "cull ms");
+
+    const struct {
+        const char* name;
+        const Sphere* mesh;
+        float hysteresis;
+    } runs[] = {
+        { "fixed 48x48", &fixedSphere, 0.0f },
+        { "LOD chain", &lodSphere, SphereLodSettings().hysteresis },
+        { "LOD, no hysteresis", &lodSphere, 0.0f },
+        { "icosphere LOD chain", &icoSphere, SphereLodSettings().hysteresis },
+    };
+    for (const auto& run : runs) {
+        SphereLodSettings settings;
+        settings.hysteresis = run.hysteresis;
+        double switches = switchesPerFrame(*run.mesh, settings, scene, projection);
+
+        std::vector<size_t> cpuTriangles;
+        for (bool allowGpu : { false, true }) {
+            InstanceCuller culler(*run.mesh, allowGpu);
+            if (allowGpu && !culler.gpu) {
+                std::printf("%-20s %-4s %12s\n", run.name, "GPU", "needs GL 4.3, skipped");
+                continue;
+            }
+            culler.lod = settings;
+            FlightStats stats = fly(culler, scene, projection);
+            std::printf("%-20s %-4s %12.0f %12zu %10.0f %12.2f %10.3f\n", run.name, allowGpu ? "GPU" : "CPU",
+                stats.triangles / FRAMES, stats.maxTriangles, stats.drawn / FRAMES, switches,
+                stats.cullSeconds / FRAMES * 1e3);
+
+            if (!allowGpu) {
+                cpuTriangles = stats.trianglesPerFrame;
+                continue;
+            }
+            int differing = 0;
+            for (int f = 0; f < FRAMES; ++f)
+                differing += stats.trianglesPerFrame[f] != cpuTriangles[f];
+            if (differing != 0)
+                std::printf("MISMATCH: %s: GPU and CPU triangle counts differ in %d frames\n", run.name, differing);
+        }
+    }
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
@@ -0,0 +1,126 @@
+#include "Benchmarks.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include "Sphere.h"
+#include "SphereBatch.h"
+#include "SphereMesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+const size_t TRIANGLES_PER_FRAME = 4000000;
+
+GLint bufferSize(GLenum target, unsigned int buffer) {
+    GLint size = 0;
+    glBindBuffer(target, buffer);
+    glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+    return size;
+}
+
+// The finest level's indices, read back from the element buffer.
+std::vector<uint32_t> readIndices(const Sphere& sphere) {
+    const SphereLod& lod = sphere.lods[0];
+    std::vector<uint32_t> indices(lod.indexCount);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere.EBO);
+    if (sphere.indexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shorts(lod.indexCount);
+        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, lod.firstIndex * sizeof(uint16_t),
+            shorts.size() * sizeof(uint16_t), shorts.data());
+        indices.assign(shorts.begin(), shorts.end());
+    } else {
+        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, lod.firstIndex * sizeof(uint32_t),
+            indices.size() * sizeof(uint32_t), indices.data());
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return indices;
+}
+
+}
+
+// Memory, vertex cache behaviour and vertex throughput of the float UV
+// sphere against the compact meshes. Rasterization is off, so the timings
+// are vertex fetch and shading only.
+void benchSphereMeshes() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    Shader shader("shaders/solar_vertex.glsl", "shaders/solar_fragment.glsl");
+    checkBlockLayouts(shader, "solar");
+    shader.use();
+    setSolarUniforms(shader, false);
+    UniformBuffer frameBuffer;
+    frameBuffer.create(FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+    FrameBlock frame = FrameBlock();
+    frame.view = glm::mat4(1.0f);
+    frame.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+    frameBuffer.upload(&frame, sizeof(frame));
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    const struct {
+        const char* name;
+        std::unique_ptr<Sphere> mesh;
+    } meshes[] = {
+        { "UV 48x48 float", std::make_unique<Sphere>(1.0f, 48, 48) },
+        { "UV 96x48 float", std::make_unique<Sphere>(1.0f, 96, 48) },
+        { "UV 96x48 compact", std::make_unique<Sphere>(SphereTopology::UV_SPHERE, std::vector<int>{ 96 }) },
+        { "icosphere 4", std::make_unique<Sphere>(SphereTopology::ICOSPHERE, std::vector<int>{ 4 }) },
+        { "icosphere 5", std::make_unique<Sphere>(SphereTopology::ICOSPHERE, std::vector<int>{ 5 }) },
+        { "cube sphere 16", std::make_unique<Sphere>(SphereTopology::CUBE_SPHERE, std::vector<int>{ 16 }) },
+        { "cube sphere 32", std::make_unique<Sphere>(SphereTopology::CUBE_SPHERE, std::vector<int>{ 32 }) },
+    };
+    const int frames = 5;
+
+    std::printf("%zu triangles a frame, %d frames, rasterizer discard; ACMR is vertices shaded per triangle\n",
+        TRIANGLES_PER_FRAME, frames);
+    std::printf("%-18s %8s %8s %10s %10s %8s %8s %8s %8s %10s\n", "mesh", "tris", "verts", "VB bytes", "IB bytes",
+        "B/tri", "error", "ACMR 16", "ACMR 32", "ms/Mtri");
+    std::vector<SphereInstance> instances;
+    for (const auto& entry : meshes) {
+        const Sphere& mesh = *entry.mesh;
+        GLint vertexBytes = bufferSize(GL_ARRAY_BUFFER, mesh.VBO);
+        GLint indexBytes = bufferSize(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        size_t vertexCount = vertexBytes / (mesh.compact ? sizeof(CompactSphereVertex) : 8 * sizeof(float));
+        size_t triangles = mesh.indexCount / 3;
+        std::vector<uint32_t> indices = readIndices(mesh);
+
+        // Enough instances, scattered in front of the camera, for the frame's triangles.
+        size_t count = std::max<size_t>(TRIANGLES_PER_FRAME / triangles, 1);
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> spread(-20.0f, 20.0f);
+        instances.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(spread(rng), spread(rng), -60.0f));
+            instances[i] = { glm::scale(model, glm::vec3(0.5f)), glm::vec4(1.0f), glm::ivec4(1, 0, 0, 0) };
+        }
+        SphereBatch batch(mesh);
+        batch.upload(instances.data(), count);
+        shader.use();
+        setSolarUniforms(shader, mesh.compact);
+        batch.draw(0, count);
+        glFinish();
+
+        BenchTimer timer;
+        for (int f = 0; f < frames; ++f)
+            batch.draw(0, count);
+        glFinish();
+        double millionTriangles = static_cast<double>(count * triangles * frames) / 1e6;
+
+        std::printf("%-18s %8zu %8zu %10d %10d %8.1f %8.5f %8.3f %8.3f %10.2f\n", entry.name, triangles, vertexCount,
+            vertexBytes, indexBytes, static_cast<double>(vertexBytes + indexBytes) / triangles, mesh.lods[0].error,
+            averageCacheMissRatio(indices.data(), indices.size(), 16),
+            averageCacheMissRatio(indices.data(), indices.size(), 32), timer.elapsedSeconds() * 1e3 / millionTriangles);
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    glDeleteBuffers(1, &frameBuffer.id);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
@@ -0,0 +1,127 @@
+#include "Benchmarks.h"
+#include "MeshRegistry.h"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const size_t MAJOR_BODIES = 8;
+const size_t SMALL_BODIES = 10000;
+const size_t ORBITS = 1000;
+const int SMALL_SHAPES = 4;
+
+// What a body asks for: the major bodies share the compact LOD chain, the
+// small ones pick one of a few coarse float spheres by size class.
+int smallShapeSectors(size_t body) {
+    return 8 + 4 * static_cast<int>(body % SMALL_SHAPES);
+}
+
+KeplerElements orbitElements(size_t body) {
+    KeplerElements elements;
+    elements.semiMajor = 100.0 + 0.05 * static_cast<double>(body);
+    elements.eccentricity = 0.1;
+    elements.inclination = 0.001 * static_cast<double>(body % 100);
+    return elements;
+}
+
+GLint bufferSize(GLenum target, unsigned int buffer) {
+    GLint size = 0;
+    glBindBuffer(target, buffer);
+    glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+    glBindBuffer(target, 0);
+    return size;
+}
+
+}
+
+// The meshes of a scene of 8 large bodies, 10k small ones and 1k orbits,
+// built once per object as main used to, and through a MeshRegistry. The
+// staging column is what the objects kept on the CPU before they dropped
+// their vertices after upload.
+void benchMeshRegistry() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    const std::vector<int> chain = { 5, 4, 3, 2, 1, 0 };
+    std::printf("%zu major bodies, %zu small bodies in %d shapes, %zu orbits\n", MAJOR_BODIES, SMALL_BODIES,
+        SMALL_SHAPES, ORBITS);
+    std::printf("%-16s %8s %12s %14s %10s %10s\n", "meshes", "built", "GPU bytes", "staging bytes", "CPU bytes",
+        "build ms");
+
+    // One mesh per object.
+    {
+        BenchTimer timer;
+        std::vector<std::unique_ptr<Sphere>> spheres;
+        std::vector<std::unique_ptr<OrbitPath>> orbits;
+        for (size_t i = 0; i < MAJOR_BODIES; ++i)
+            spheres.push_back(std::make_unique<Sphere>(SphereTopology::ICOSPHERE, chain));
+        for (size_t i = 0; i < SMALL_BODIES; ++i) {
+            int sectors = smallShapeSectors(i);
+            spheres.push_back(std::make_unique<Sphere>(1.0f, sectors, sectors / 2));
+        }
+        for (size_t i = 0; i < ORBITS; ++i) {
+            orbits.push_back(std::make_unique<OrbitPath>());
+            orbits.back()->generateKeplerOrbit(orbitElements(i), 120);
+        }
+        glFinish();
+        double seconds = timer.elapsedSeconds();
+
+        size_t gpuBytes = 0, stagingBytes = 0, cpuBytes = 0;
+        for (const auto& sphere : spheres) {
+            gpuBytes += sphere->gpuBytes();
+            stagingBytes += sphere->compact ? 0 : sphere->gpuBytes();
+            cpuBytes += sphere->lods.capacity() * sizeof(SphereLod);
+        }
+        for (const auto& orbit : orbits) {
+            gpuBytes += orbit->gpuBytes();
+            stagingBytes += orbit->gpuBytes();
+        }
+        std::printf("%-16s %8zu %12zu %14zu %10zu %10.1f\n", "one per object", spheres.size() + orbits.size(),
+            gpuBytes, stagingBytes, cpuBytes, seconds * 1e3);
+    }
+
+    // Shared.
+    {
+        BenchTimer timer;
+        MeshRegistry registry;
+        std::vector<Sphere*> bodySpheres;
+        for (size_t i = 0; i < MAJOR_BODIES; ++i)
+            bodySpheres.push_back(&registry.sphere(SphereTopology::ICOSPHERE, chain));
+        for (size_t i = 0; i < SMALL_BODIES; ++i) {
+            int sectors = smallShapeSectors(i);
+            bodySpheres.push_back(&registry.sphere(1.0f, sectors, sectors / 2));
+        }
+        for (size_t i = 0; i < ORBITS; ++i)
+            registry.keplerOrbit(orbitElements(i), 120);
+        glFinish();
+        double seconds = timer.elapsedSeconds();
+
+        MeshMemory memory = registry.memory();
+        std::printf("%-16s %8zu %12zu %14d %10zu %10.1f\n", "registry", memory.meshes, memory.gpuBytes, 0,
+            memory.cpuBytes, seconds * 1e3);
+        std::printf("%zu requests, %zu GPU bytes shared instead of uploaded again\n", memory.requests,
+            memory.sharedBytes);
+
+        // Same parameters must give the same mesh, others a different one,
+        // and the reported sizes must be what GL allocated.
+        if (bodySpheres[0] != bodySpheres[MAJOR_BODIES - 1]
+            || bodySpheres[MAJOR_BODIES] != bodySpheres[MAJOR_BODIES + SMALL_SHAPES]
+            || bodySpheres[MAJOR_BODIES] == bodySpheres[MAJOR_BODIES + 1])
+            std::printf("MISMATCH: registry handed out the wrong meshes\n");
+        if (memory.meshes != 1 + SMALL_SHAPES + ORBITS || memory.requests != MAJOR_BODIES + SMALL_BODIES + ORBITS)
+            std::printf("MISMATCH: %zu meshes for %zu requests\n", memory.meshes, memory.requests);
+        for (const Sphere* sphere : { bodySpheres[0], bodySpheres[MAJOR_BODIES] }) {
+            if (static_cast<size_t>(bufferSize(GL_ARRAY_BUFFER, sphere->VBO)) != sphere->vertexBytes
+                || static_cast<size_t>(bufferSize(GL_ELEMENT_ARRAY_BUFFER, sphere->EBO)) != sphere->indexBytes)
+                std::printf("MISMATCH: sphere buffer sizes differ from the reported ones\n");
+        }
+    }
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
@@ -0,0 +1,131 @@
+#include "Benchmarks.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include "Sphere.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int PROGRAMS = 4;
+const int TEXTURES = 16;
+const int MESHES = 8;
+
+struct QueueRun {
+    const char* name;
+    bool sorted;
+    bool filtered;
+};
+
+}
+
+// A scene of many objects, each with its own Object block, drawn with a few
+// programs, textures and meshes in random order; a tenth are blended.
+void benchRenderQueue() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    std::vector<std::unique_ptr<Shader>> programs;
+    programs.push_back(std::make_unique<Shader>("shaders/solar_vertex.glsl", "shaders/solar_fragment.glsl"));
+    programs.push_back(std::make_unique<Shader>("shaders/orbit_vertex.glsl", "shaders/orbit_fragment.glsl"));
+    programs.push_back(std::make_unique<Shader>("shaders/skybox_vertex.glsl", "shaders/skybox_fragment.glsl"));
+    programs.push_back(std::make_unique<Shader>("shaders/basic_vertex.glsl", "shaders/basic_fragment.glsl"));
+    for (const auto& program : programs)
+        checkBlockLayouts(*program, "bench");
+    programs[0]->use();
+    setSolarUniforms(*programs[0], false);
+    UniformBuffer frame;
+    frame.create(FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+    FrameBlock frameBlock = FrameBlock();
+    frame.upload(&frameBlock, sizeof(frameBlock));
+
+    unsigned int textures[TEXTURES];
+    glGenTextures(TEXTURES, textures);
+    const unsigned char texel[4] = { 200, 180, 160, 255 };
+    for (unsigned int texture : textures) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    }
+    std::vector<std::unique_ptr<Sphere>> meshes;
+    for (int i = 0; i < MESHES; ++i)
+        meshes.push_back(std::make_unique<Sphere>(1.0f, 4 + i, 2));
+
+    // Only submission and the GL calls are of interest.
+    glEnable(GL_RASTERIZER_DISCARD);
+    size_t alignment = uniformOffsetAlignment();
+    size_t stride = (sizeof(ObjectBlock) + alignment - 1) / alignment * alignment;
+
+    const size_t counts[] = { 1000, 10000 };
+    const QueueRun runs[] = {
+        { "source order, unfiltered", false, false },
+        { "source order, filtered", false, true },
+        { "sorted, filtered", true, true },
+    };
+    const int frames = 20;
+
+    std::printf("%d programs, %d textures, %d meshes, %d frames each; GL calls and CPU time per frame\n", PROGRAMS,
+        TEXTURES, MESHES, frames);
+    std::printf("%8s %-26s %8s %9s %9s %9s %9s %10s %10s\n", "objects", "order", "draws", "programs", "textures",
+        "VAOs", "states", "submit ms", "total ms");
+
+    for (size_t count : counts) {
+        UniformBuffer objects;
+        objects.create(OBJECT_BLOCK_BINDING, stride * count);
+
+        std::mt19937 rng(19);
+        std::uniform_real_distribution<float> depth(0.0f, 1000.0f);
+        std::vector<DrawItem> scene(count);
+        for (size_t i = 0; i < count; ++i) {
+            DrawItem& item = scene[i];
+            item.pass = rng() % 10 == 0 ? PASS_TRANSPARENT : PASS_OPAQUE;
+            item.program = programs[rng() % PROGRAMS]->ID;
+            item.textures[0] = { GL_TEXTURE_2D, textures[rng() % TEXTURES] };
+            item.geometry = meshes[rng() % MESHES]->geometry();
+            item.objectOffset = i * stride;
+            item.depth = depth(rng);
+        }
+
+        size_t drawsBefore = 0;
+        for (const QueueRun& run : runs) {
+            RenderQueue queue;
+            queue.objectBuffer = &objects;
+            queue.sorted = run.sorted;
+            queue.filtered = run.filtered;
+
+            RenderStats stats;
+            double submit = 0.0, total = 0.0;
+            for (int f = 0; f < frames; ++f) {
+                queue.state.stats.reset();
+                BenchTimer timer;
+                for (const DrawItem& item : scene)
+                    queue.submit(item);
+                queue.flush();
+                submit += timer.elapsedSeconds();
+                glFinish();
+                total += timer.elapsedSeconds();
+                stats = queue.state.stats;
+            }
+
+            std::printf("%8zu %-26s %8u %9u %9u %9u %9u %10.3f %10.3f\n", count, run.name, stats.draws,
+                stats.programSwitches, stats.textureBinds, stats.vertexArrayBinds, stats.stateChanges,
+                submit / frames * 1e3, total / frames * 1e3);
+            if (drawsBefore != 0 && stats.draws != drawsBefore)
+                std::printf("MISMATCH: %s drew %u objects, not %zu\n", run.name, stats.draws, drawsBefore);
+            drawsBefore = stats.draws;
+        }
+        glDeleteBuffers(1, &objects.id);
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    glDeleteTextures(TEXTURES, textures);
+    glDeleteBuffers(1, &frame.id);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
@@ -0,0 +1,117 @@
+#include "Benchmarks.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+// The old setters took `const std::string&` and asked the driver for the
+// location on every call.
+static void setIntByString(const Shader& shader, const std::string& name, int value) {
+    glUniform1i(glGetUniformLocation(shader.ID, name.c_str()), value);
+}
+
+static void setSolarUniformsByString(const Shader& solar, bool compactVertices) {
+    setIntByString(solar, "bodyTextures", 0);
+    setIntByString(solar, "shadowTexture", 1);
+    setIntByString(solar, "compactVertices", compactVertices);
+}
+
+// The per-object flag main set before the textures moved into the array; the
+// program no longer has it, so GL ignores the -1 location. At 16 characters
+// the name no longer fits std::string's inline buffer, so the old setter
+// allocates for it.
+static constexpr char LONG_NAME[] = "useCloudsTexture";
+
+// Two distinct names with the same FNV-1a hash, found by brute force.
+static bool findCollision(std::string& first, std::string& second) {
+    std::unordered_map<uint32_t, std::string> seen;
+    for (int i = 0; i < 2000000; ++i) {
+        std::string name = "u" + std::to_string(i);
+        auto inserted = seen.emplace(UniformName(name).hash, name);
+        if (!inserted.second) {
+            first = inserted.first->second;
+            second = name;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The setter calls main makes on the linked solar program (setSolarUniforms;
+// every other per-frame value goes through uniform blocks) plus one stale
+// long name, by string and driver lookup as before, and through Shader's
+// hashed table. Also checks the table against the driver and against a real
+// hash collision.
+void benchUniformSetters() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    const int frames = 100000;
+    Shader solar("shaders/solar_vertex.glsl", "shaders/solar_fragment.glsl");
+    solar.use();
+    GLint active = 0;
+    glGetProgramiv(solar.ID, GL_ACTIVE_UNIFORMS, &active);
+    std::printf("solar program: %d active uniforms, %zu outside blocks\n", active, solar.uniforms().size());
+    std::printf("%-28s %12s %14s\n", "setter name", "ns/frame", "allocs/frame");
+
+    size_t before = allocationCount();
+    BenchTimer timer;
+    for (int f = 0; f < frames; ++f) {
+        setSolarUniformsByString(solar, (f & 1) != 0);
+        setIntByString(solar, LONG_NAME, 0);
+    }
+    glFinish();
+    double seconds = timer.elapsedSeconds();
+    std::printf("%-28s %12.1f %14.2f\n", "std::string + driver lookup", seconds / frames * 1e9,
+        double(allocationCount() - before) / frames);
+
+    before = allocationCount();
+    timer.reset();
+    for (int f = 0; f < frames; ++f) {
+        setSolarUniforms(solar, (f & 1) != 0);
+        solar.setInt(LONG_NAME, 0);
+    }
+    glFinish();
+    seconds = timer.elapsedSeconds();
+    size_t hashedAllocations = allocationCount() - before;
+    std::printf("%-28s %12.1f %14.2f\n", "Shader::set* (hashed)", seconds / frames * 1e9,
+        double(hashedAllocations) / frames);
+
+#ifdef TESTGL_COUNT_ALLOCATIONS
+    if (hashedAllocations != 0)
+        std::printf("MISMATCH: the solar setters allocated %zu times\n", hashedAllocations);
+#else
+    (void)hashedAllocations;
+    std::printf("allocations not counted (TESTGL_COUNT_ALLOCATIONS is off)\n");
+#endif
+    for (UniformName name : { UniformName("bodyTextures"), UniformName("shadowTexture"),
+             UniformName("compactVertices") }) {
+        std::string text(name.text);
+        if (solar.uniforms().find(name) != glGetUniformLocation(solar.ID, text.c_str()))
+            std::printf("MISMATCH: %s resolves to the wrong location\n", text.c_str());
+    }
+    if (solar.uniforms().find("notAUniform") != -1 || solar.uniforms().find(LONG_NAME) != -1)
+        std::printf("MISMATCH: unknown name resolved\n");
+
+    std::string first, second;
+    if (!findCollision(first, second)) {
+        std::printf("no hash collision found, skipped\n");
+    } else {
+        UniformTable table;
+        bool added = table.add(first, 1) && table.add(second, 2);
+        std::printf("\"%s\" and \"%s\" share hash 0x%08x\n", first.c_str(), second.c_str(),
+            UniformName(first).hash);
+        if (!added || table.find(UniformName(first)) != 1 || table.find(UniformName(second)) != 2)
+            std::printf("MISMATCH: colliding names resolve to the wrong locations\n");
+        if (table.add(first, 3))
+            std::printf("MISMATCH: a name was added twice\n");
+    }
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
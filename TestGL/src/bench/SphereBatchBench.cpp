@@ -0,0 +1,110 @@
+#include "Benchmarks.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include "SphereBatch.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Spheres scattered in front of the camera.
+static void fillInstances(std::vector<SphereInstance>& instances, size_t count) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> spread(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> depth(-200.0f, -50.0f);
+    instances.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(spread(rng), spread(rng), depth(rng)));
+        model = glm::scale(model, glm::vec3(0.2f));
+        instances[i] = { model, glm::vec4(0.6f, 0.6f, 0.55f, 1.0f), glm::ivec4(1, 0, 0, 0) };
+    }
+}
+
+void benchSphereInstancing() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    Shader shader("shaders/solar_vertex.glsl", "shaders/solar_fragment.glsl");
+    checkBlockLayouts(shader, "solar");
+    shader.use();
+    setSolarUniforms(shader, false);
+    UniformBuffer frameBuffer;
+    frameBuffer.create(FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+    FrameBlock frame = FrameBlock();
+    frame.view = glm::mat4(1.0f);
+    frame.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+    frame.sunPos = glm::vec4(0.0f, 100.0f, 0.0f, 10.0f);
+    frame.sunLight = glm::vec4(1.0f, 0.95f, 0.8f, 2.0f);
+    frameBuffer.upload(&frame, sizeof(frame));
+
+    // An eight-triangle mesh with rasterization off, so the timings measure
+    // draw submission rather than vertex and fill work (which a software
+    // renderer would otherwise do inside the draw call).
+    Sphere unitSphere(1.0f, 4, 2);
+    SphereBatch batch(unitSphere);
+    shader.use();
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    const size_t counts[] = { 100, 1000, 10000, 100000 };
+    const size_t maxSingleDraws = 10000;
+    const int frames = 10;
+    std::vector<SphereInstance> instances;
+
+    std::printf("%d frames each, %u triangles per sphere, rasterizer discard; columns are CPU time to issue a frame\n"
+        "and, in brackets, time until glFinish returns\n", frames, unitSphere.indexCount / 3);
+    std::printf("%10s %18s %18s %18s %18s\n", "spheres", "1 draw/sphere ms", "  (total ms)", "instanced ms",
+        "  (total ms)");
+    // The first draws compile the program's variants; keep them out of the timings.
+    fillInstances(instances, 2);
+    batch.upload(instances.data(), instances.size());
+    batch.draw(0, 2);
+    batch.draw(1, 1);
+    glFinish();
+
+    for (size_t count : counts) {
+        fillInstances(instances, count);
+        batch.upload(instances.data(), instances.size());
+        glFinish();
+
+        double singleSubmit = 0.0, singleTotal = 0.0;
+        if (count <= maxSingleDraws) {
+            for (int f = 0; f < frames; ++f) {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                BenchTimer timer;
+                for (size_t i = 0; i < count; ++i)
+                    batch.draw(i, 1);
+                singleSubmit += timer.elapsedSeconds();
+                glFinish();
+                singleTotal += timer.elapsedSeconds();
+            }
+        }
+
+        double instancedSubmit = 0.0, instancedTotal = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            BenchTimer timer;
+            // A real frame re-uploads the moving instances as well.
+            batch.upload(instances.data(), instances.size());
+            batch.draw(0, count);
+            instancedSubmit += timer.elapsedSeconds();
+            glFinish();
+            instancedTotal += timer.elapsedSeconds();
+        }
+
+        if (count <= maxSingleDraws) {
+            std::printf("%10zu %18.3f %18.3f %18.3f %18.3f\n", count, singleSubmit / frames * 1e3,
+                singleTotal / frames * 1e3, instancedSubmit / frames * 1e3, instancedTotal / frames * 1e3);
+        } else {
+            std::printf("%10zu %18s %18s %18.3f %18.3f\n", count, "-", "-", instancedSubmit / frames * 1e3,
+                instancedTotal / frames * 1e3);
+        }
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
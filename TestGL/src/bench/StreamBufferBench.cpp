@@ -0,0 +1,113 @@
+#include "Benchmarks.h"
+#include "Shader.h"
+#include "ShaderBlocks.h"
+#include "SphereBatch.h"
+#include "StreamBuffer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+enum class StreamMode { SUB_DATA, ORPHAN, PERSISTENT };
+
+// One frame's instances, moving a little every frame.
+void writeInstances(SphereInstance* out, size_t count, int frame) {
+    for (size_t i = 0; i < count; ++i) {
+        float x = float(i % 1000) * 0.1f, z = float(i / 1000) * 0.1f + frame * 0.01f;
+        out[i] = { glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, z)), glm::vec4(1.0f), glm::ivec4(1, 0, 0, 0) };
+    }
+}
+
+}
+
+// Streams a frame of sphere instances and draws them as points from the
+// same buffer, which is the read that makes an in-place update wait.
+void benchStreamBuffer() {
+    BenchGLContext context;
+    if (!context.ok) {
+        std::printf("no GL context, skipped\n");
+        return;
+    }
+
+    Shader shader("shaders/orbit_vertex.glsl", "shaders/orbit_fragment.glsl");
+    checkBlockLayouts(shader, "orbit");
+    UniformBuffer frameBuffer, objectBuffer;
+    frameBuffer.create(FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+    objectBuffer.create(OBJECT_BLOCK_BINDING, sizeof(ObjectBlock));
+    FrameBlock frame = FrameBlock();
+    ObjectBlock object = ObjectBlock();
+    frameBuffer.upload(&frame, sizeof(frame));
+    objectBuffer.upload(&object, sizeof(object));
+    shader.use();
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    unsigned int vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(0);
+
+    const size_t counts[] = { 10000, 100000 };
+    const int frames = 60;
+    const struct {
+        const char* name;
+        StreamMode mode;
+    } modes[] = {
+        { "glBufferSubData", StreamMode::SUB_DATA },
+        { "orphan + map", StreamMode::ORPHAN },
+        { "persistent ring", StreamMode::PERSISTENT },
+    };
+
+    std::printf("%d frames of 96-byte instances, each written then drawn; CPU ms per frame\n", frames);
+    std::printf("%10s %-18s %10s %10s %8s\n", "instances", "path", "frame ms", "MB/s", "stalls");
+    for (size_t count : counts) {
+        std::vector<SphereInstance> staging(count);
+        for (const auto& run : modes) {
+            StreamBuffer stream(GL_ARRAY_BUFFER, run.mode == StreamMode::PERSISTENT);
+            if (run.mode == StreamMode::PERSISTENT && !stream.persistent) {
+                std::printf("%10zu %-18s %10s\n", count, run.name, "no buffer storage (GL 4.4), skipped");
+                continue;
+            }
+            unsigned int plain = 0;
+            if (run.mode == StreamMode::SUB_DATA) {
+                glGenBuffers(1, &plain);
+                glBindBuffer(GL_ARRAY_BUFFER, plain);
+                glBufferData(GL_ARRAY_BUFFER, count * sizeof(SphereInstance), nullptr, GL_DYNAMIC_DRAW);
+            }
+
+            glFinish();
+            BenchTimer timer;
+            for (int f = 0; f < frames; ++f) {
+                uintptr_t offset = 0;
+                if (run.mode == StreamMode::SUB_DATA) {
+                    writeInstances(staging.data(), count, f);
+                    glBindBuffer(GL_ARRAY_BUFFER, plain);
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(SphereInstance), staging.data());
+                } else {
+                    writeInstances(static_cast<SphereInstance*>(stream.begin(count * sizeof(SphereInstance))), count,
+                        f);
+                    offset = stream.end();
+                    glBindBuffer(GL_ARRAY_BUFFER, stream.id);
+                }
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                    (void*)(offset + offsetof(SphereInstance, model) + 3 * sizeof(glm::vec4)));
+                glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+            }
+            glFinish();
+            double seconds = timer.elapsedSeconds();
+            double bytes = double(count) * sizeof(SphereInstance) * frames;
+            std::printf("%10zu %-18s %10.3f %10.0f %8u\n", count, run.name, seconds / frames * 1e3,
+                bytes / seconds / 1e6, stream.stalls);
+            if (plain != 0)
+                glDeleteBuffers(1, &plain);
+        }
+    }
+
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDisable(GL_RASTERIZER_DISCARD);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+        std::printf("MISMATCH: GL error 0x%x\n", error);
+}
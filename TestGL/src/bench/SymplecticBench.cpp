@@ -0,0 +1,129 @@
+#include "Benchmarks.h"
+#include "KeplerPropagator.h"
+#include "SymplecticIntegrator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Gaussian gravitational constant squared: AU^3 / (solar mass * day^2).
+static const double GAUSS_K2 = 2.959122082855911e-4;
+
+static void fillCluster(SymplecticIntegrator& integrator, size_t count) {
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    integrator.clear();
+    integrator.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        integrator.addBody(glm::dvec3(unit(rng), unit(rng), unit(rng)) * 10.0,
+            glm::dvec3(unit(rng), unit(rng), unit(rng)) * 0.01, 1.0 / count);
+}
+
+// Sun and the eight planets on their mean J2000 orbits.
+static void fillSolarSystem(SymplecticIntegrator& integrator) {
+    struct Planet { double a, e, inc, node, peri, meanAnomaly, mass; };
+    const double DEG = 3.14159265358979323846 / 180.0;
+    const Planet planets[] = {
+        { 0.387098, 0.205630, 7.005, 48.331, 29.124, 174.796, 1.6601e-7 },
+        { 0.723332, 0.006772, 3.395, 76.680, 54.884, 50.115, 2.4478e-6 },
+        { 1.000001, 0.016709, 0.000, -11.261, 114.208, 358.617, 3.0404e-6 },
+        { 1.523679, 0.093405, 1.850, 49.558, 286.502, 19.373, 3.2271e-7 },
+        { 5.2044, 0.0489, 1.303, 100.464, 273.867, 20.020, 9.5479e-4 },
+        { 9.5826, 0.0565, 2.485, 113.665, 339.392, 317.020, 2.8589e-4 },
+        { 19.2184, 0.046381, 0.773, 74.006, 96.998857, 142.2386, 4.3662e-5 },
+        { 30.07, 0.008678, 1.770, 131.784, 273.187, 256.228, 5.1514e-5 },
+    };
+
+    integrator.clear();
+    integrator.gravitationalConstant = GAUSS_K2;
+    integrator.addBody(glm::dvec3(0.0), glm::dvec3(0.0), 1.0);
+    for (const Planet& p : planets) {
+        KeplerElements el;
+        el.semiMajor = p.a;
+        el.eccentricity = p.e;
+        el.inclination = p.inc * DEG;
+        el.ascendingNode = p.node * DEG;
+        el.argPeriapsis = p.peri * DEG;
+        el.meanAnomaly = p.meanAnomaly * DEG;
+        el.meanMotion = std::sqrt(GAUSS_K2 * (1.0 + p.mass) / (p.a * p.a * p.a));
+        integrator.addBody(keplerPosition(el, 0.0), keplerVelocity(el, 0.0), p.mass);
+    }
+    integrator.moveToBarycentricFrame();
+}
+
+static double stepSeconds(SimdLevel level, SymplecticScheme scheme, size_t count) {
+    SymplecticIntegrator integrator(level);
+    integrator.scheme = scheme;
+    fillCluster(integrator, count);
+    integrator.step(1e-3);
+
+    // Enough steps for roughly 1e8 pair interactions per measurement.
+    const int forceEvaluations = scheme == SymplecticScheme::Leapfrog ? 1 : 3;
+    const int steps = std::max<int>(10, static_cast<int>(1e8 / (count * count * forceEvaluations)));
+    BenchTimer timer;
+    for (int s = 0; s < steps; ++s)
+        integrator.step(1e-3);
+    return timer.elapsedSeconds() / steps;
+}
+
+void benchSymplectic() {
+    const SymplecticScheme schemes[] = { SymplecticScheme::Leapfrog, SymplecticScheme::Yoshida4 };
+    const char* schemeNames[] = { "leapfrog", "yoshida4" };
+    const SimdLevel best = detectSimdLevel();
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    std::printf("step time in us (leapfrog per instruction set, yoshida4 at %s)\n%6s", simdLevelName(best), "N");
+    for (SimdLevel level : levels) {
+        if (level <= best)
+            std::printf(" %10s", simdLevelName(level));
+    }
+    std::printf(" %10s %12s\n", "yoshida4", "Gpairs/s");
+
+    const size_t counts[] = { 9, 32, 100, 250, 500, 1000 };
+    for (size_t count : counts) {
+        std::printf("%6zu", count);
+        double fastest = 0.0;
+        for (SimdLevel level : levels) {
+            if (level > best)
+                break;
+            fastest = stepSeconds(level, SymplecticScheme::Leapfrog, count);
+            std::printf(" %10.2f", fastest * 1e6);
+        }
+        double yoshida = stepSeconds(best, SymplecticScheme::Yoshida4, count);
+        std::printf(" %10.2f %12.3f\n", yoshida * 1e6, count * count / fastest * 1e-9);
+    }
+
+    // Sun + 8 planets at a one-day step for a million steps (~2700 years).
+    const long long totalSteps = 1000000;
+    const long long reportEvery = 200000;
+    std::printf("\nrelative energy error, Sun + 8 planets, dt = 1 day\n%10s", "steps");
+    for (const char* name : schemeNames)
+        std::printf(" %12s", name);
+    std::printf("\n");
+
+    SymplecticIntegrator systems[2];
+    double initialEnergy[2];
+    double maxError[2] = { 0.0, 0.0 };
+    for (int k = 0; k < 2; ++k) {
+        systems[k].scheme = schemes[k];
+        fillSolarSystem(systems[k]);
+        initialEnergy[k] = systems[k].energy();
+    }
+
+    BenchTimer timer;
+    for (long long done = 0; done < totalSteps; done += reportEvery) {
+        std::printf("%10lld", done + reportEvery);
+        for (int k = 0; k < 2; ++k) {
+            for (long long s = 0; s < reportEvery; ++s) {
+                systems[k].step(1.0);
+                if (s % 97 == 0) {
+                    double err = std::abs(systems[k].energy() / initialEnergy[k] - 1.0);
+                    maxError[k] = std::max(maxError[k], err);
+                }
+            }
+            std::printf(" %12.3e", std::abs(systems[k].energy() / initialEnergy[k] - 1.0));
+        }
+        std::printf("\n");
+    }
+    std::printf("%10s %12.3e %12.3e  (%.1f s)\n", "max", maxError[0], maxError[1], timer.elapsedSeconds());
+}
@@ -4,14 +4,37 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <atomic>
 #include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 #include "Shader.h"
 #include "Camera.h"
 #include "Sphere.h"
-#include "TextureLoader.h"
+#include "TextureArray.h"
 #include "Skybox.h"
+#include "RenderQueue.h"
 #include "OrbitPath.h"
+#include "MeshRegistry.h"
+#include "BodyRegistry.h"
+#include "Benchmarks.h"
+#include "SimulationClock.h"
+#include "JulianDate.h"
+#include "BarnesHut.h"
+#include "ParticleCloud.h"
+#include "SymplecticIntegrator.h"
+#include "EclipseSearch.h"
+#include "EclipseCatalog.h"
+#include "ShadowRaster.h"
+#include "ConjunctionSweep.h"
+#include "ShaderBlocks.h"
+#include "InstanceCuller.h"
+#include "ElementCatalog.h"
+#include "Ephemeris.h"
 
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
@@ -24,20 +47,17 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-float earthOrbitAngle = 0.0f;
-float moonOrbitAngle = 0.0f;
-float marsOrbitAngle = 0.0f;
-float earthRotationAngle = 0.0f;
-float timeSpeed = 0.5f;
-float normalTimeSpeed = 0.5f;
-float fastTimeSpeed = 4.0f;
+// Simulated days per real second.
+float timeSpeed = 2.0f;
+float normalTimeSpeed = 2.0f;
+// Set while the clock is held at an eclipse found by the search.
 bool isEclipse = false;
 bool isLunarEclipse = false;
-bool speedUpMode = false;
-bool speedUpModeLunar = false;
+EclipseSearch eclipseSearch;
+const double ECLIPSE_SEARCH_DAYS = 20.0 * 365.25;
 bool cameraFollowEarth = false;
-glm::vec3 adjustedMoonPos;
-bool moonPosAdjusted = false;
+SimulationClock simClock(J2000);
+double lastTitleUpdate = 0.0;
 
 const float SUN_RADIUS = 10.0f;
 const float EARTH_RADIUS = 3.0f;
@@ -45,28 +65,174 @@ const float MOON_RADIUS = 2.4f;
 const float MARS_RADIUS = 1.5f;
 
 const float EARTH_ORBIT_SEMI_MAJOR = 60.0f;
-const float EARTH_ORBIT_SEMI_MINOR = 55.0f;
 const float MOON_ORBIT_RADIUS = 12.0f;
 const float MARS_ORBIT_SEMI_MAJOR = 85.0f;
-const float MARS_ORBIT_SEMI_MINOR = 80.0f;
+
+// Scene-scaled distances with the real J2000 elements and periods.
+// Fields: a, e, i, node, periapsis, mean anomaly at J2000, mean motion (rad/day).
+const double DEG = 3.14159265358979323846 / 180.0;
+const double TWO_PI = 6.283185307179586;
+const KeplerElements EARTH_ORBIT = { EARTH_ORBIT_SEMI_MAJOR, 0.0167, 0.0, 0.0, 102.937 * DEG, 357.529 * DEG, TWO_PI / 365.256363 };
+const KeplerElements MOON_ORBIT = { MOON_ORBIT_RADIUS, 0.0549, 5.145 * DEG, 125.08 * DEG, 318.15 * DEG, 134.963 * DEG, TWO_PI / 27.321662 };
+const KeplerElements MARS_ORBIT = { MARS_ORBIT_SEMI_MAJOR, 0.0934, 1.850 * DEG, 49.558 * DEG, 286.502 * DEG, 19.373 * DEG, TWO_PI / 686.980 };
+const double EARTH_SIDEREAL_DAY = 0.99726968;
+
+// Gravitational parameter of the Sun in scene units^3 / day^2, from Earth's orbit.
+const float SUN_GM = static_cast<float>((TWO_PI / 365.256363) * (TWO_PI / 365.256363)
+    * EARTH_ORBIT_SEMI_MAJOR * EARTH_ORBIT_SEMI_MAJOR * EARTH_ORBIT_SEMI_MAJOR);
+const float MARS_GM = SUN_GM * 3.227e-7f;
+
+// Optional gravitational N-body mode: an asteroid belt around the Sun,
+// perturbed by Mars, integrated with Barnes-Hut on its own fixed step.
+bool nbodyMode = false;
+size_t nbodyParticles = 20000;
+float nbodyTheta = 0.5f;
+const double NBODY_STEP = 0.5;
+const int NBODY_MAX_STEPS = 2;
+std::unique_ptr<BarnesHutSimulation> nbody;
+double nbodyTime = 0.0;
+
+// Optional minor-planet catalog from `--catalog`, mapped at startup and
+// propagated on the worker pool whenever the date changes.
+ElementCatalog catalog;
+std::vector<float> catalogX, catalogY, catalogZ;
+double catalogTime = 0.0;
+
+// Worker threads shared by the N-body mode, the catalog and the eclipse shadow.
+std::unique_ptr<ThreadPool> workerPool;
+
+// Solar eclipse shadow on the Earth's surface, recomputed whenever the date
+// changes and uploaded only while there is an eclipse to show.
+const int SHADOW_MAP_WIDTH = 720;
+const int SHADOW_MAP_HEIGHT = 360;
+const double SHADOW_PATH_STEP = 2.0 / 1440.0;
+ShadowRaster shadowRaster;
+std::vector<uint8_t> shadowPixels;
+unsigned int shadowTexture = 0;
+double shadowTime = 0.0;
+bool shadowVisible = false;
+
+// Uniform blocks shared by the programs (ShaderBlocks.h): one per frame, and
+// one per draw packed into a single buffer at the driver's offset alignment.
+// Every body but the Sun is an occluder that the solar shader tests against
+// the Sun's disk.
+UniformBuffer frameBuffer;
+UniformBuffer objectBuffer;
+FrameBlock frameBlock;
+std::vector<unsigned char> objectData;
+size_t objectStride = 0;
+std::vector<int> occluderSlot;          // per body, -1 when not an occluder
+
+// Every body is an instance of one unit sphere, and every body map is a
+// layer of one texture array, so all bodies go out in one instanced draw.
+// Maps are resampled to the 2k size of most of them.
+const int BODY_TEXTURE_WIDTH = 2048;
+const int BODY_TEXTURE_HEIGHT = 1024;
+enum BodyTextureLayer { SUN_LAYER, EARTH_DAY_LAYER, EARTH_NIGHT_LAYER, EARTH_CLOUDS_LAYER, MOON_LAYER, MARS_LAYER };
+TextureArray bodyTextures;
+
+// Each frame's draws are sorted by state and pass and submitted through a
+// cache that drops redundant GL calls; the title shows what got through.
+RenderQueue renderQueue;
+RenderStats frameStats;
+
+// Conjunctions, transits and occultations among the bodies as seen from the
+// camera, reported as they begin while the watch is on.
+ConjunctionSweep conjunctions;
+std::vector<ConjunctionPair> activeConjunctions;
+bool conjunctionWatch = false;
+double conjunctionTime = 0.0;
+
+// Optional direct-summation gravity for the major bodies, replacing the
+// closed-form orbits. The integrator works in AU, days and solar masses, and
+// each body's offset from the body it orbits is scaled to its scene distance.
+const double GAUSS_K2 = 2.959122082855911e-4;
+struct BodyPhysics {
+    double mass;            // solar masses
+    KeplerElements orbit;   // relative to the parent, semi-major axis in AU
+    double sceneScale;      // scene units per AU of offset from the parent
+};
+bool gravityMode = false;
+SymplecticIntegrator gravity;
+std::vector<BodyPhysics> bodyPhysics;
 
 glm::vec3 sunColor(1.0f, 0.95f, 0.8f);
-glm::vec3 earthColor(0.15f, 0.5f, 0.7f);
-glm::vec3 moonColor(0.75f, 0.75f, 0.8f);
-glm::vec3 marsColor(0.8f, 0.3f, 0.2f);
+
+// Texture layers of bodyTextures, -1 for none.
+struct BodyMaterial {
+    glm::vec3 color;
+    int objectType;
+    bool isMoon;
+    int diffuseLayer;
+    int nightLayer;
+    int cloudsLayer;
+};
+
+BodyRegistry bodies;
+Ephemeris ephemeris;
+std::vector<BodyMaterial> materials;
+uint32_t sunId, earthId, moonId, marsId;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 
-glm::vec3 calculateEarthPosition(float angle);
-glm::vec3 calculateMoonPosition(glm::vec3 earthPos, float angle);
-glm::vec3 calculateMarsPosition(float angle);
-bool checkSolarEclipse(glm::vec3 sunPos, glm::vec3 earthPos, glm::vec3 moonPos);
-bool checkLunarEclipse(glm::vec3 sunPos, glm::vec3 earthPos, glm::vec3 moonPos);
+void loadBodyTextures();
+void setupBodies();
+EclipseModel eclipseModel();
+void startEclipseSearch(EclipseKind kind);
+void showEclipse(const EclipseEvent& eclipse, double searchSeconds);
+void seekTo(double julianDate);
+void startNBody();
+ThreadPool& workers();
+void createShadowTexture();
+void updateEclipseShadow();
+void updateConjunctions();
+void createUniformBlocks(Shader& solarShader, Shader& orbitShader, Shader& skyboxShader);
+void updateFrameBlock(const glm::mat4& view, const glm::mat4& projection, float alpha);
+size_t addObject(const glm::mat4& model, const glm::vec3& color, int objectType, int flags, int ignoredOccluders);
+void propagateCatalog();
+void startGravity();
+int makeEphemeris(int argc, char** argv);
+int ingestCatalog(int argc, char** argv);
+int makeEclipseCatalog(int argc, char** argv);
+void applyGravity();
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return runBenchmarks(argc - 2, argv + 2);
+    if (argc > 1 && std::strcmp(argv[1], "--make-ephemeris") == 0)
+        return makeEphemeris(argc - 2, argv + 2);
+    if (argc > 1 && std::strcmp(argv[1], "--ingest") == 0)
+        return ingestCatalog(argc - 2, argv + 2);
+    if (argc > 1 && std::strcmp(argv[1], "--eclipse-catalog") == 0)
+        return makeEclipseCatalog(argc - 2, argv + 2);
+
+    double startDate = currentJulianDate();
+    const char* ephemerisPath = NULL;
+    const char* catalogPath = NULL;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--date") == 0 && !parseCalendarDate(argv[i + 1], startDate)) {
+            std::cout << "Invalid --date " << argv[i + 1] << ", expected YYYY-MM-DD[Thh:mm]" << std::endl;
+            startDate = currentJulianDate();
+        }
+        if (std::strcmp(argv[i], "--nbody") == 0) {
+            nbodyMode = true;
+            nbodyParticles = std::strtoul(argv[i + 1], NULL, 10);
+        }
+        if (std::strcmp(argv[i], "--theta") == 0)
+            nbodyTheta = std::strtof(argv[i + 1], NULL);
+        if (std::strcmp(argv[i], "--ephemeris") == 0)
+            ephemerisPath = argv[i + 1];
+        if (std::strcmp(argv[i], "--catalog") == 0)
+            catalogPath = argv[i + 1];
+    }
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--gravity") == 0)
+            gravityMode = true;
+    }
 
-int main() {
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -97,26 +263,44 @@ int main() {
     Shader skyboxShader("shaders/skybox_vertex.glsl", "shaders/skybox_fragment.glsl");
     Shader orbitShader("shaders/orbit_vertex.glsl", "shaders/orbit_fragment.glsl");
 
-    unsigned int sunTexture = TextureLoader::loadTexture("textures/8k_sun.jpg", false);
-    unsigned int earthDayTexture = TextureLoader::loadTexture("textures/2k_earth_daymap.jpg", false);
-    unsigned int earthNightTexture = TextureLoader::loadTexture("textures/2k_earth_nightmap.jpg", false);
-    unsigned int earthCloudsTexture = TextureLoader::loadTexture("textures/2k_earth_clouds.jpg", false);
-    unsigned int moonTexture = TextureLoader::loadTexture("textures/2k_moon.jpg", false);
-    unsigned int marsTexture = TextureLoader::loadTexture("textures/8k_mars.jpg", false);
+    loadBodyTextures();
 
     Skybox skybox;
     skybox.loadTexture("textures/2k_stars_milky_way.jpg");
 
-    OrbitPath earthOrbitPath;
-    earthOrbitPath.generateEarthOrbit(EARTH_ORBIT_SEMI_MAJOR, EARTH_ORBIT_SEMI_MINOR, 120);
-    
-    OrbitPath moonOrbitPath;
-    moonOrbitPath.generateMoonOrbit(MOON_ORBIT_RADIUS, 80);
+    MeshRegistry meshes;
+    OrbitPath& earthOrbitPath = meshes.keplerOrbit(EARTH_ORBIT, 120);
+    OrbitPath& moonOrbitPath = meshes.keplerOrbit(MOON_ORBIT, 80);
 
-    Sphere sun(SUN_RADIUS, 50, 50);
-    Sphere earth(EARTH_RADIUS, 40, 40);
-    Sphere moon(MOON_RADIUS, 30, 30);
-    Sphere mars(MARS_RADIUS, 35, 35);
+    setupBodies();
+    if (ephemerisPath && ephemeris.open(ephemerisPath) && bodies.useEphemeris(&ephemeris)) {
+        std::cout << "Ephemeris " << ephemerisPath << " covers " << formatJulianDate(ephemeris.startTime())
+            << " to " << formatJulianDate(ephemeris.endTime()) << std::endl;
+    }
+    if (catalogPath && catalog.open(catalogPath)) {
+        catalogX.resize(catalog.size());
+        catalogY.resize(catalog.size());
+        catalogZ.resize(catalog.size());
+        std::cout << "Catalog " << catalogPath << ": " << catalog.size() << " orbits" << std::endl;
+    }
+
+    createShadowTexture();
+    createUniformBlocks(solarShader, orbitShader, skyboxShader);
+
+    // From 20k triangles for a body filling the screen down to 20 for one a
+    // few pixels across, in 8-byte vertices.
+    Sphere& unitSphere = meshes.sphere(SphereTopology::ICOSPHERE, { 5, 4, 3, 2, 1, 0 });
+    solarShader.use();
+    setSolarUniforms(solarShader, unitSphere.compact);
+    InstanceCuller bodyCuller(unitSphere);
+    MeshMemory meshMemory = meshes.memory();
+    std::cout << "Meshes: " << meshMemory.meshes << ", " << meshMemory.gpuBytes / 1024 << " KB on the GPU, "
+        << meshMemory.cpuBytes << " bytes on the CPU" << std::endl;
+
+    ParticleCloud nbodyCloud;
+    ParticleCloud catalogCloud;
+
+    seekTo(startDate);
 
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = static_cast<float>(glfwGetTime());
@@ -125,24 +309,65 @@ int main() {
 
         processInput(window);
 
-        if (!isEclipse && !isLunarEclipse) {
-            float clampedDeltaTime = std::min(deltaTime, 0.1f);
-            earthOrbitAngle += 0.3f * timeSpeed * clampedDeltaTime;
-            moonOrbitAngle += 1.2f * timeSpeed * clampedDeltaTime;
-            marsOrbitAngle += 0.15f * timeSpeed * clampedDeltaTime;
-            earthRotationAngle += 2.0f * timeSpeed * clampedDeltaTime;
+        int substeps = simClock.beginFrame(deltaTime, (isEclipse || isLunarEclipse) ? 0.0 : timeSpeed);
+        for (int step = 0; step < substeps; ++step) {
+            bodies.storePreviousState();
+            simClock.advanceStep();
+            // Gravity mode overwrites the orbit positions, so it only needs the spins.
+            if (gravityMode) {
+                bodies.evaluateSpin(simClock.time());
+                gravity.step(simClock.step);
+                applyGravity();
+            } else {
+                bodies.evaluate(simClock.time());
+            }
         }
 
-        glm::vec3 sunPos(0.0f, 0.0f, 0.0f);
-        glm::vec3 earthPos = calculateEarthPosition(earthOrbitAngle);
-        glm::vec3 moonPos;
-        if (moonPosAdjusted && (isEclipse || isLunarEclipse)) {
-            moonPos = adjustedMoonPos;
-        } else {
-            moonPos = calculateMoonPosition(earthPos, moonOrbitAngle);
-            moonPosAdjusted = false;
+        EclipseEvent eclipse;
+        double searchSeconds;
+        if (eclipseSearch.poll(eclipse, searchSeconds))
+            showEclipse(eclipse, searchSeconds);
+
+        if (nbodyMode && !nbody)
+            startNBody();
+        if (nbodyMode) {
+            // Catch up with the clock on the coarser particle step, dropping
+            // whatever this frame cannot afford.
+            int nbodySteps = 0;
+            while (nbodyTime + NBODY_STEP <= simClock.time() && nbodySteps < NBODY_MAX_STEPS) {
+                nbody->step(static_cast<float>(NBODY_STEP));
+                nbodyTime += NBODY_STEP;
+                ++nbodySteps;
+            }
+            if (std::abs(simClock.time() - nbodyTime) > NBODY_STEP)
+                nbodyTime = simClock.time();
+            if (nbodySteps > 0 || nbodyCloud.pointCount == 0)
+                nbodyCloud.update(nbody->posX.data(), nbody->posY.data(), nbody->posZ.data(), nbody->size());
+        }
+
+        if (catalog.isOpen() && (catalogTime != simClock.time() || catalogCloud.pointCount == 0)) {
+            propagateCatalog();
+            catalogCloud.update(catalogX.data(), catalogY.data(), catalogZ.data(), catalog.size());
+        }
+
+        if (shadowTime != simClock.time())
+            updateEclipseShadow();
+
+        if (conjunctionWatch && conjunctionTime != simClock.time())
+            updateConjunctions();
+
+        float alpha = simClock.alpha();
+
+        if (currentFrame - lastTitleUpdate > 0.25) {
+            lastTitleUpdate = currentFrame;
+            std::string title = "Solar System - Earth, Moon & Sun - " + formatJulianDate(simClock.time())
+                + " - " + std::to_string(frameStats.draws) + " draws, " + std::to_string(frameStats.programSwitches)
+                + " programs, " + std::to_string(frameStats.textureBinds) + " texture binds";
+            glfwSetWindowTitle(window, title.c_str());
         }
-        glm::vec3 marsPos = calculateMarsPosition(marsOrbitAngle);
+        glm::vec3 sunPos = bodies.interpolatedPosition(sunId, alpha);
+        glm::vec3 earthPos = bodies.interpolatedPosition(earthId, alpha);
+        glm::vec3 moonPos = bodies.interpolatedPosition(moonId, alpha);
 
         if (cameraFollowEarth) {
             glm::vec3 lookTarget;
@@ -159,179 +384,104 @@ int main() {
             camera.SetPositionAndLookAt(cameraPos, lookTarget);
         }
 
-        if (speedUpMode && !isEclipse && !isLunarEclipse) {
-            isEclipse = checkSolarEclipse(sunPos, earthPos, moonPos);
-            if (isEclipse) {
-                glm::vec3 sunToEarth = earthPos - sunPos;
-                float sunToEarthDist = glm::length(sunToEarth);
-                glm::vec3 sunToEarthDir = glm::normalize(sunToEarth);
-                
-                float moonDistFromEarth = MOON_ORBIT_RADIUS;
-                float moonDistFromSun = sunToEarthDist - moonDistFromEarth;
-                
-                if (moonDistFromSun > 0 && moonDistFromSun < sunToEarthDist) {
-                    adjustedMoonPos = sunPos + sunToEarthDir * moonDistFromSun;
-                    adjustedMoonPos.y = 0.0f;
-                    moonPosAdjusted = true;
-                    
-                    glm::vec3 verifySunToMoon = adjustedMoonPos - sunPos;
-                    glm::vec3 verifyMoonToEarth = earthPos - adjustedMoonPos;
-                    float verifyAlignment = glm::dot(glm::normalize(verifySunToMoon), glm::normalize(verifyMoonToEarth));
-                    
-                    std::cout << "SOLAR ECLIPSE DETECTED! Movement stopped. Perfect alignment achieved." << std::endl;
-                    std::cout << "Alignment verification: " << verifyAlignment << " (should be ~1.0)" << std::endl;
-                }
-                
-                timeSpeed = 0.0f;
-            }
-        }
+        glm::mat4 view = camera.GetViewMatrix();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+        updateFrameBlock(view, projection, alpha);
 
-        if (speedUpModeLunar && !isLunarEclipse && !isEclipse) {
-            isLunarEclipse = checkLunarEclipse(sunPos, earthPos, moonPos);
-            if (isLunarEclipse) {
-                glm::vec3 sunToEarth = glm::normalize(earthPos - sunPos);
-                float earthToMoonDist = MOON_ORBIT_RADIUS;
-                moonPos = earthPos + sunToEarth * earthToMoonDist;
-                moonPos.y = 0.0f;
-                
-                std::cout << "LUNAR ECLIPSE DETECTED! Movement stopped. Perfect alignment achieved." << std::endl;
-                timeSpeed = 0.0f;
-            }
+        // Every draw's object block goes up in one upload before drawing.
+        objectData.clear();
+        size_t earthOrbitObject = addObject(glm::mat4(1.0f), glm::vec3(0.8f, 0.8f, 0.9f), 0, 0, 0);
+        size_t moonOrbitObject = addObject(glm::translate(glm::mat4(1.0f), earthPos), glm::vec3(0.7f, 0.7f, 0.8f), 0, 0, 0);
+        size_t nbodyObject = addObject(glm::mat4(1.0f), glm::vec3(0.75f, 0.7f, 0.6f), 0, 0, 0);
+        // Catalog positions are heliocentric AU.
+        size_t catalogObject = addObject(glm::scale(glm::translate(glm::mat4(1.0f), sunPos),
+            glm::vec3(EARTH_ORBIT_SEMI_MAJOR)), glm::vec3(0.6f, 0.6f, 0.55f), 0, 0, 0);
+
+        objectBuffer.upload(objectData.data(), objectData.size());
+
+        // Written straight into the culler's stream buffer.
+        SphereInstance* bodyInstances = bodyCuller.beginUpload(bodies.size());
+        for (uint32_t i = 0; i < bodies.size(); ++i) {
+            const BodyMaterial& material = materials[bodies.materialId[i]];
+
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, bodies.interpolatedPosition(i, alpha));
+            model = glm::rotate(model, bodies.interpolatedSpin(i, alpha), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(bodies.radius[i]));
+            int flags = (material.diffuseLayer >= 0 ? OBJECT_USE_TEXTURE : 0)
+                | (material.nightLayer >= 0 ? OBJECT_USE_NIGHT_TEXTURE : 0)
+                | (material.cloudsLayer >= 0 ? OBJECT_USE_CLOUDS_TEXTURE : 0)
+                | (i == earthId && shadowVisible ? OBJECT_USE_SHADOW_TEXTURE : 0)
+                | (material.isMoon ? OBJECT_IS_MOON : 0);
+            // A body never shadows itself, and the raster already shows the
+            // real Moon shadow on the Earth.
+            int ignored = occluderSlot[i] >= 0 ? 1 << occluderSlot[i] : 0;
+            if (i == earthId && shadowVisible && occluderSlot[moonId] >= 0)
+                ignored |= 1 << occluderSlot[moonId];
+            int layers = packTextureLayers(material.diffuseLayer, material.nightLayer, material.cloudsLayer);
+            bodyInstances[i] = { model, glm::vec4(material.color, 1.0f),
+                glm::ivec4(material.objectType, flags, ignored, layers) };
         }
+        bodyCuller.endUpload();
+        // Every body is large enough to hide the others.
+        int framebufferWidth = 0, framebufferHeight = 0;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        bodyCuller.cull(view, projection, framebufferHeight, bodies.size());
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glDepthFunc(GL_LEQUAL);
-        skyboxShader.use();
-        glm::mat4 view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-        skyboxShader.setMat4("view", view);
-        skyboxShader.setMat4("projection", projection);
-        glActiveTexture(GL_TEXTURE0);
-        skyboxShader.setInt("skybox", 0);
-        skybox.Draw();
-        glDepthFunc(GL_LESS);
-
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glLineWidth(1.5f);
-        orbitShader.use();
-        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-        view = camera.GetViewMatrix();
-        orbitShader.setMat4("projection", projection);
-        orbitShader.setMat4("view", view);
-        
-        glm::mat4 model = glm::mat4(1.0f);
-        orbitShader.setMat4("model", model);
-        orbitShader.setVec3("orbitColor", glm::vec3(0.8f, 0.8f, 0.9f));
-        earthOrbitPath.Draw();
-        
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, earthPos);
-        orbitShader.setMat4("model", model);
-        orbitShader.setVec3("orbitColor", glm::vec3(0.7f, 0.7f, 0.8f));
-        moonOrbitPath.Draw();
-        
-        glDisable(GL_BLEND);
-        glLineWidth(1.0f);
-
-        solarShader.use();
-
-        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-        view = camera.GetViewMatrix();
-        solarShader.setMat4("projection", projection);
-        solarShader.setMat4("view", view);
-        solarShader.setVec3("viewPos", camera.Position);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, sunPos);
-        solarShader.setMat4("model", model);
-        solarShader.setVec3("objectColor", sunColor);
-        solarShader.setInt("objectType", 0);
-        solarShader.setVec3("sunPos", sunPos);
-        solarShader.setVec3("sunColor", sunColor);
-        solarShader.setFloat("sunIntensity", 2.0f);
-        solarShader.setVec3("moonPos", moonPos);
-        solarShader.setVec3("moonColor", glm::vec3(0.9f, 0.9f, 0.95f));
-        solarShader.setFloat("moonIntensity", 0.3f);
-        solarShader.setBool("isMoon", false);
-        solarShader.setBool("useTexture", true);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sunTexture);
-        solarShader.setInt("diffuseTexture", 0);
-        sun.Draw();
-            
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, earthPos);
-        model = glm::rotate(model, earthRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        solarShader.setMat4("model", model);
-        solarShader.setVec3("objectColor", earthColor);
-        solarShader.setInt("objectType", 1);
-        solarShader.setVec3("sunPos", sunPos);
-        solarShader.setVec3("sunColor", sunColor);
-        solarShader.setFloat("sunIntensity", 2.0f);
-        solarShader.setVec3("moonPos", moonPos);
-        solarShader.setVec3("moonColor", glm::vec3(0.9f, 0.9f, 0.95f));
-        solarShader.setFloat("moonIntensity", 0.3f);
-        solarShader.setBool("isMoon", false);
-        solarShader.setBool("useTexture", true);
-        solarShader.setBool("useNightTexture", true);
-        solarShader.setBool("useCloudsTexture", true);
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, earthDayTexture);
-        solarShader.setInt("diffuseTexture", 0);
-        
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, earthNightTexture);
-        solarShader.setInt("nightTexture", 1);
-        
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, earthCloudsTexture);
-        solarShader.setInt("cloudsTexture", 2);
-        
-        earth.Draw();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, moonPos);
-        solarShader.setMat4("model", model);
-        solarShader.setVec3("objectColor", moonColor);
-        solarShader.setInt("objectType", 2);
-        solarShader.setVec3("sunPos", sunPos);
-        solarShader.setVec3("sunColor", sunColor);
-        solarShader.setFloat("sunIntensity", 2.0f);
-        solarShader.setVec3("moonPos", moonPos);
-        solarShader.setVec3("moonColor", glm::vec3(0.9f, 0.9f, 0.95f));
-        solarShader.setFloat("moonIntensity", 0.3f);
-        solarShader.setBool("isMoon", true);
-        solarShader.setBool("useTexture", true);
-        solarShader.setBool("useNightTexture", false);
-        solarShader.setBool("useCloudsTexture", false);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, moonTexture);
-        solarShader.setInt("diffuseTexture", 0);
-        moon.Draw();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, marsPos);
-        solarShader.setMat4("model", model);
-        solarShader.setVec3("objectColor", marsColor);
-        solarShader.setInt("objectType", 1);
-        solarShader.setVec3("sunPos", sunPos);
-        solarShader.setVec3("sunColor", sunColor);
-        solarShader.setFloat("sunIntensity", 2.0f);
-        solarShader.setVec3("moonPos", moonPos);
-        solarShader.setVec3("moonColor", glm::vec3(0.9f, 0.9f, 0.95f));
-        solarShader.setFloat("moonIntensity", 0.3f);
-        solarShader.setBool("isMoon", false);
-        solarShader.setBool("useTexture", true);
-        solarShader.setBool("useNightTexture", false);
-        solarShader.setBool("useCloudsTexture", false);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, marsTexture);
-        solarShader.setInt("diffuseTexture", 0);
-        mars.Draw();
+        DrawItem bodiesItem;
+        bodiesItem.program = solarShader.ID;
+        bodiesItem.textures[0] = { GL_TEXTURE_2D_ARRAY, bodyTextures.ID };
+        bodiesItem.textures[1] = { GL_TEXTURE_2D, shadowTexture };
+        for (size_t draw = 0; draw < bodyCuller.drawCount(); ++draw) {
+            bodiesItem.geometry = bodyCuller.geometry(draw);
+            renderQueue.submit(bodiesItem);
+        }
+
+        DrawItem skyItem;
+        skyItem.pass = PASS_SKY;
+        skyItem.program = skyboxShader.ID;
+        skyItem.textures[0] = { GL_TEXTURE_2D, skybox.textureID };
+        skyItem.geometry = skybox.geometry();
+        renderQueue.submit(skyItem);
+
+        // Orbits and particles are blended over the bodies, farthest first.
+        DrawItem lineItem;
+        lineItem.pass = PASS_TRANSPARENT;
+        lineItem.program = orbitShader.ID;
+        lineItem.lineWidth = 1.5f;
+        lineItem.geometry = earthOrbitPath.geometry();
+        lineItem.objectOffset = earthOrbitObject;
+        lineItem.depth = glm::length(sunPos - camera.Position);
+        renderQueue.submit(lineItem);
+        lineItem.geometry = moonOrbitPath.geometry();
+        lineItem.objectOffset = moonOrbitObject;
+        lineItem.depth = glm::length(earthPos - camera.Position);
+        renderQueue.submit(lineItem);
+
+        if (nbodyMode) {
+            DrawItem pointItem = lineItem;
+            pointItem.pointSize = 2.0f;
+            pointItem.geometry = nbodyCloud.geometry();
+            pointItem.objectOffset = nbodyObject;
+            pointItem.depth = glm::length(sunPos - camera.Position);
+            renderQueue.submit(pointItem);
+        }
+
+        if (catalog.isOpen()) {
+            DrawItem pointItem = lineItem;
+            pointItem.pointSize = 1.0f;
+            pointItem.geometry = catalogCloud.geometry();
+            pointItem.objectOffset = catalogObject;
+            pointItem.depth = glm::length(sunPos - camera.Position);
+            renderQueue.submit(pointItem);
+        }
+
+        renderQueue.state.stats.reset();
+        renderQueue.flush();
+        frameStats = renderQueue.state.stats;
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -341,70 +491,430 @@ int main() {
     return 0;
 }
 
-glm::vec3 calculateEarthPosition(float angle) {
-    float x = EARTH_ORBIT_SEMI_MAJOR * cos(angle);
-    float z = EARTH_ORBIT_SEMI_MINOR * sin(angle);
-    return glm::vec3(x, 0.0f, z);
+ThreadPool& workers() {
+    if (!workerPool)
+        workerPool = std::make_unique<ThreadPool>();
+    return *workerPool;
 }
 
-glm::vec3 calculateMoonPosition(glm::vec3 earthPos, float angle) {
-    float x = earthPos.x + MOON_ORBIT_RADIUS * cos(angle);
-    float z = earthPos.z + MOON_ORBIT_RADIUS * sin(angle);
-    return glm::vec3(x, 0.0f, z);
+void createShadowTexture() {
+    shadowRaster.resize(SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT);
+    shadowPixels.assign(shadowRaster.size() * 4, 0);
+
+    glGenTextures(1, &shadowTexture);
+    glBindTexture(GL_TEXTURE_2D, shadowTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+        shadowPixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
-glm::vec3 calculateMarsPosition(float angle) {
-    float x = MARS_ORBIT_SEMI_MAJOR * cos(angle);
-    float z = MARS_ORBIT_SEMI_MINOR * sin(angle);
-    return glm::vec3(x, 0.0f, z);
+void updateEclipseShadow() {
+    shadowTime = simClock.time();
+    double spinRate = bodies.spinRate[earthId];
+    double spin = bodies.spinPhase[earthId] + spinRate * (shadowTime - bodies.orbits.epoch);
+    shadowVisible = shadowRaster.compute(eclipseModel(), shadowTime, spin, spinRate, SHADOW_PATH_STEP, workers());
+    if (!shadowVisible)
+        return;
+
+    shadowRaster.packRGBA(shadowPixels.data());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, shadowTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE,
+        shadowPixels.data());
 }
 
-bool checkSolarEclipse(glm::vec3 sunPos, glm::vec3 earthPos, glm::vec3 moonPos) {
-    glm::vec3 sunToEarth = earthPos - sunPos;
-    glm::vec3 sunToMoon = moonPos - sunPos;
-    
-    sunToEarth = glm::normalize(sunToEarth);
-    sunToMoon = glm::normalize(sunToMoon);
-    
-    float alignment = glm::dot(sunToEarth, sunToMoon);
-    
-    float sunToMoonDist = glm::length(moonPos - sunPos);
-    float moonToEarthDist = glm::length(earthPos - moonPos);
-    float sunToEarthDist = glm::length(earthPos - sunPos);
-    
-    bool isAligned = alignment > 0.9995f;
-    bool moonBetween = (sunToMoonDist + moonToEarthDist) < (sunToEarthDist * 1.01f);
-    bool samePlane = std::abs(sunPos.y - earthPos.y) < 0.1f && std::abs(earthPos.y - moonPos.y) < 0.1f;
-    
-    if (isAligned && moonBetween && samePlane) {
-        return true;
-    }
-    
-    return false;
+void createUniformBlocks(Shader& solarShader, Shader& orbitShader, Shader& skyboxShader) {
+    checkBlockLayouts(solarShader, "solar");
+    checkBlockLayouts(orbitShader, "orbit");
+    checkBlockLayouts(skyboxShader, "skybox");
+
+    // Samplers stay on fixed texture units; the solar ones are set with the
+    // unit sphere.
+    skyboxShader.use();
+    skyboxShader.setInt("skybox", 0);
+
+    frameBlock = FrameBlock();
+    occluderSlot.assign(bodies.size(), -1);
+    for (uint32_t i = 0; i < bodies.size() && frameBlock.occluderCount.x < MAX_OCCLUDERS; ++i) {
+        if (i != sunId)
+            occluderSlot[i] = frameBlock.occluderCount.x++;
+    }
+    frameBuffer.create(FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+
+    size_t alignment = uniformOffsetAlignment();
+    objectStride = (sizeof(ObjectBlock) + alignment - 1) / alignment * alignment;
+    objectBuffer.create(OBJECT_BLOCK_BINDING, objectStride * (bodies.size() + 8));
+    renderQueue.objectBuffer = &objectBuffer;
 }
 
-bool checkLunarEclipse(glm::vec3 sunPos, glm::vec3 earthPos, glm::vec3 moonPos) {
-    glm::vec3 sunToEarth = earthPos - sunPos;
-    glm::vec3 earthToMoon = moonPos - earthPos;
-    
-    sunToEarth = glm::normalize(sunToEarth);
-    earthToMoon = glm::normalize(earthToMoon);
-    
-    float alignment = glm::dot(sunToEarth, earthToMoon);
-    
-    float sunToEarthDist = glm::length(earthPos - sunPos);
-    float earthToMoonDist = glm::length(moonPos - earthPos);
-    float sunToMoonDist = glm::length(moonPos - sunPos);
-    
-    bool isAligned = alignment > 0.9995f;
-    bool earthBetween = (sunToEarthDist + earthToMoonDist) < (sunToMoonDist * 1.01f);
-    bool samePlane = std::abs(sunPos.y - earthPos.y) < 0.1f && std::abs(earthPos.y - moonPos.y) < 0.1f;
-    
-    if (isAligned && earthBetween && samePlane) {
-        return true;
-    }
-    
-    return false;
+void updateFrameBlock(const glm::mat4& view, const glm::mat4& projection, float alpha) {
+    frameBlock.view = view;
+    frameBlock.projection = projection;
+    frameBlock.viewPos = glm::vec4(camera.Position, 1.0f);
+    frameBlock.sunPos = glm::vec4(bodies.interpolatedPosition(sunId, alpha), bodies.radius[sunId]);
+    frameBlock.sunLight = glm::vec4(sunColor, 2.0f);
+    frameBlock.moonPos = glm::vec4(bodies.interpolatedPosition(moonId, alpha), bodies.radius[moonId]);
+    frameBlock.moonLight = glm::vec4(0.9f, 0.9f, 0.95f, 0.3f);
+    for (uint32_t i = 0; i < bodies.size(); ++i) {
+        if (occluderSlot[i] >= 0)
+            frameBlock.occluders[occluderSlot[i]] = glm::vec4(bodies.interpolatedPosition(i, alpha), bodies.radius[i]);
+    }
+    frameBuffer.upload(&frameBlock, sizeof(frameBlock));
+}
+
+// Appends an object block for this frame and returns its offset.
+size_t addObject(const glm::mat4& model, const glm::vec3& color, int objectType, int flags, int ignoredOccluders) {
+    ObjectBlock block;
+    block.model = model;
+    block.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+    block.color = glm::vec4(color, 1.0f);
+    block.flags = glm::ivec4(objectType, flags, ignoredOccluders, 0);
+
+    size_t offset = objectData.size();
+    objectData.resize(offset + objectStride);
+    std::memcpy(objectData.data() + offset, &block, sizeof(block));
+    return offset;
+}
+
+void updateConjunctions() {
+    conjunctionTime = simClock.time();
+    conjunctions.update(bodies.posX.data(), bodies.posY.data(), bodies.posZ.data(), bodies.radius.data(),
+        bodies.size(), camera.Position);
+
+    static const char* const KIND_NAMES[] = { "conjunction", "transit", "occultation" };
+    for (const ConjunctionPair& pair : conjunctions.pairs()) {
+        bool known = false;
+        for (const ConjunctionPair& active : activeConjunctions) {
+            if (active.nearBody == pair.nearBody && active.farBody == pair.farBody && active.kind == pair.kind) {
+                known = true;
+                break;
+            }
+        }
+        if (!known) {
+            std::cout << formatJulianDate(conjunctionTime) << ": " << KIND_NAMES[static_cast<int>(pair.kind)] << " of "
+                << bodies.names[pair.farBody] << " by " << bodies.names[pair.nearBody] << ", "
+                << glm::degrees(pair.separation) << " deg apart." << std::endl;
+        }
+    }
+    activeConjunctions = conjunctions.pairs();
+}
+
+void propagateCatalog() {
+    catalogTime = simClock.time();
+    const KeplerPropagator& propagator = bodies.propagator;
+    workers().parallelFor(catalog.size(), 1 << 16, [&](size_t begin, size_t end) {
+        propagator.propagateRange(catalog.view(), catalog.epoch(), catalogTime, catalogX.data(), catalogY.data(),
+            catalogZ.data(), begin, end);
+    });
+}
+
+void startNBody() {
+    nbody = std::make_unique<BarnesHutSimulation>(workers());
+    nbody->theta = nbodyTheta;
+    nbody->softening = 0.1f;
+
+    glm::vec3 sunPos = bodies.position(sunId);
+    glm::vec3 marsOffset = bodies.position(marsId) - sunPos;
+    float marsSpeed = std::sqrt(SUN_GM / glm::length(marsOffset));
+    glm::vec3 marsVelocity = glm::normalize(glm::cross(marsOffset, glm::vec3(0.0f, 1.0f, 0.0f))) * marsSpeed;
+
+    nbody->addParticle(sunPos, glm::vec3(0.0f), SUN_GM);
+    nbody->addParticle(sunPos + marsOffset, marsVelocity, MARS_GM);
+    // Main belt between 2.1 and 3.3 AU, with a notional total mass.
+    addParticleDisk(*nbody, nbodyParticles, sunPos, SUN_GM, SUN_GM * 1e-6f,
+        2.1f * EARTH_ORBIT_SEMI_MAJOR, 3.3f * EARTH_ORBIT_SEMI_MAJOR);
+
+    nbodyTime = simClock.time();
+    std::cout << "N-body mode: " << nbody->size() << " particles on " << workers().size()
+        << " threads, theta " << nbody->theta << std::endl;
+}
+
+// In BodyTextureLayer order.
+void loadBodyTextures() {
+    bodyTextures.load({ "textures/8k_sun.jpg", "textures/2k_earth_daymap.jpg", "textures/2k_earth_nightmap.jpg",
+        "textures/2k_earth_clouds.jpg", "textures/2k_moon.jpg", "textures/8k_mars.jpg" },
+        BODY_TEXTURE_WIDTH, BODY_TEXTURE_HEIGHT, false);
+}
+
+// A map that failed to load leaves its body in its flat colour.
+void setupBodies() {
+    materials.push_back({ sunColor, 0, false, bodyTextures.layer(SUN_LAYER), -1, -1 });
+    materials.push_back({ glm::vec3(0.15f, 0.5f, 0.7f), 1, false, bodyTextures.layer(EARTH_DAY_LAYER),
+        bodyTextures.layer(EARTH_NIGHT_LAYER), bodyTextures.layer(EARTH_CLOUDS_LAYER) });
+    materials.push_back({ glm::vec3(0.75f, 0.75f, 0.8f), 2, true, bodyTextures.layer(MOON_LAYER), -1, -1 });
+    materials.push_back({ glm::vec3(0.8f, 0.3f, 0.2f), 1, false, bodyTextures.layer(MARS_LAYER), -1, -1 });
+
+    bodies.orbits.epoch = J2000;
+
+    BodyDesc sun;
+    sun.name = "Sun";
+    sun.radius = SUN_RADIUS;
+    sun.materialId = 0;
+    sunId = bodies.addBody(sun);
+
+    BodyDesc earth;
+    earth.name = "Earth";
+    earth.orbit = EARTH_ORBIT;
+    earth.spinRate = TWO_PI / EARTH_SIDEREAL_DAY;
+    earth.radius = EARTH_RADIUS;
+    earth.materialId = 1;
+    earthId = bodies.addBody(earth);
+
+    BodyDesc moon;
+    moon.name = "Moon";
+    moon.parent = static_cast<int32_t>(earthId);
+    moon.orbit = MOON_ORBIT;
+    moon.radius = MOON_RADIUS;
+    moon.materialId = 2;
+    moonId = bodies.addBody(moon);
+
+    BodyDesc mars;
+    mars.name = "Mars";
+    mars.orbit = MARS_ORBIT;
+    mars.radius = MARS_RADIUS;
+    mars.materialId = 3;
+    marsId = bodies.addBody(mars);
+
+    // Real masses for the gravity mode, in body order. Each physical orbit
+    // takes the semi-major axis that gives its real period about its parent,
+    // so integrated and closed-form motion agree up to the perturbations.
+    auto physics = [](double mass, double centralMass, const KeplerElements& sceneOrbit) {
+        KeplerElements orbit = sceneOrbit;
+        orbit.semiMajor = std::cbrt(GAUSS_K2 * (centralMass + mass) / (orbit.meanMotion * orbit.meanMotion));
+        return BodyPhysics{ mass, orbit, sceneOrbit.semiMajor / orbit.semiMajor };
+    };
+    const double SUN_MASS = 1.0, EARTH_MASS = 3.0034896e-6, MOON_MASS = 3.6943037e-8, MARS_MASS = 3.2271514e-7;
+    bodyPhysics.push_back({ SUN_MASS, KeplerElements(), 1.0 });
+    bodyPhysics.push_back(physics(EARTH_MASS, SUN_MASS, EARTH_ORBIT));
+    bodyPhysics.push_back(physics(MOON_MASS, EARTH_MASS, MOON_ORBIT));
+    bodyPhysics.push_back(physics(MARS_MASS, SUN_MASS, MARS_ORBIT));
+}
+
+// Offline tool: `TestGL --make-ephemeris <file> [--from DATE] [--to DATE]`
+// samples the body orbits into a Chebyshev ephemeris for `--ephemeris`.
+int makeEphemeris(int argc, char** argv) {
+    if (argc < 1) {
+        std::cout << "Usage: TestGL --make-ephemeris <file> [--from YYYY-MM-DD] [--to YYYY-MM-DD]" << std::endl;
+        return 1;
+    }
+
+    double from = calendarToJulianDate(1900, 1, 1.0);
+    double to = calendarToJulianDate(2100, 1, 1.0);
+    for (int i = 1; i + 1 < argc; ++i) {
+        bool ok = true;
+        if (std::strcmp(argv[i], "--from") == 0)
+            ok = parseCalendarDate(argv[i + 1], from);
+        else if (std::strcmp(argv[i], "--to") == 0)
+            ok = parseCalendarDate(argv[i + 1], to);
+        if (!ok) {
+            std::cout << "Invalid date " << argv[i + 1] << ", expected YYYY-MM-DD[Thh:mm]" << std::endl;
+            return 1;
+        }
+    }
+
+    setupBodies();
+
+    // Eight segments per orbit keeps a 12-term fit far below float precision.
+    std::vector<EphemerisBodySpec> specs(bodies.size());
+    for (uint32_t i = 0; i < bodies.size(); ++i) {
+        specs[i].name = bodies.names[i];
+        specs[i].parent = bodies.parent[i];
+        double motion = bodies.orbits.meanMotion[i];
+        if (motion > 0.0) {
+            specs[i].segmentDays = TWO_PI / motion / 8.0;
+        } else {
+            specs[i].segmentDays = to - from;
+            specs[i].coefficientCount = 1;
+        }
+    }
+
+    std::vector<float> x(bodies.size()), y(bodies.size()), z(bodies.size());
+    auto sampler = [&](size_t body, double julianDate) {
+        bodies.propagator.propagateRange(bodies.orbits, julianDate, x.data(), y.data(), z.data(), body, body + 1);
+        return glm::dvec3(x[body], y[body], z[body]);
+    };
+
+    if (!writeEphemeris(argv[0], specs, from, to, sampler))
+        return 1;
+
+    Ephemeris written;
+    if (!written.open(argv[0]))
+        return 1;
+    size_t segments = 0;
+    for (size_t i = 0; i < written.bodyCount(); ++i)
+        segments += written.body(i).segmentCount;
+    std::cout << "Wrote " << argv[0] << ": " << written.bodyCount() << " bodies, " << segments << " segments, "
+        << formatJulianDate(from) << " to " << formatJulianDate(to) << std::endl;
+    return 0;
+}
+
+// Offline tool: `TestGL --ingest <MPCORB.DAT> <file> [--threads N]` converts
+// a text element catalog into the binary form loaded by `--catalog`.
+int ingestCatalog(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: TestGL --ingest <elements.txt> <catalog> [--threads N]" << std::endl;
+        return 1;
+    }
+
+    unsigned threads = 0;
+    for (int i = 2; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0)
+            threads = static_cast<unsigned>(std::strtoul(argv[i + 1], NULL, 10));
+    }
+
+    ThreadPool pool(threads);
+    CatalogIngestStats stats;
+    if (!ingestElementCatalog(argv[0], argv[1], pool, stats))
+        return 1;
+
+    std::cout << "Wrote " << argv[1] << ": " << stats.records << " orbits from " << stats.bytes / 1048576.0
+        << " MB in " << stats.seconds << " s (" << stats.bytes / 1048576.0 / stats.seconds << " MB/s, "
+        << stats.records / stats.seconds << " records/s, " << pool.size() << " threads)" << std::endl;
+    if (stats.rejected > 0) {
+        std::cout << "Skipped " << stats.rejected << " invalid records, the first on line " << stats.firstRejectedLine
+            << std::endl;
+    }
+    return 0;
+}
+
+static std::atomic<bool> catalogInterrupted{ false };
+
+static void interruptCatalog(int) {
+    catalogInterrupted.store(true);
+}
+
+// Offline tool: `TestGL --eclipse-catalog <base> [--from YEAR] [--to YEAR]
+// [--threads N] [--resume]` lists every eclipse of the scene's orbits in
+// <base>.csv and <base>.ecl. Ctrl+C stops after the current batch; --resume
+// continues from <base>.checkpoint.
+int makeEclipseCatalog(int argc, char** argv) {
+    if (argc < 1) {
+        std::cout << "Usage: TestGL --eclipse-catalog <base> [--from YEAR] [--to YEAR] [--threads N] [--resume]"
+            << std::endl;
+        return 1;
+    }
+
+    int fromYear = -2000, toYear = 3000;
+    unsigned threads = 0;
+    bool resume = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--resume") == 0)
+            resume = true;
+        if (i + 1 >= argc)
+            continue;
+        if (std::strcmp(argv[i], "--from") == 0)
+            fromYear = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--to") == 0)
+            toYear = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            threads = static_cast<unsigned>(std::strtoul(argv[i + 1], NULL, 10));
+    }
+    if (!resume && (fromYear < -5000 || toYear > 5000 || toYear <= fromYear)) {
+        std::cout << "Invalid range " << fromYear << " to " << toYear << ", years must be within -5000 to 5000"
+            << std::endl;
+        return 1;
+    }
+
+    setupBodies();
+    std::signal(SIGINT, interruptCatalog);
+
+    ThreadPool pool(threads);
+    EclipseCatalogStats stats;
+    if (!generateEclipseCatalog(eclipseModel(), argv[0], calendarToJulianDate(fromYear, 1, 1.0),
+        calendarToJulianDate(toYear, 1, 1.0), resume, pool, stats, &catalogInterrupted))
+        return 1;
+
+    size_t found = stats.solar + stats.lunar;
+    std::cout << (stats.interrupted ? "Interrupted: " : "Wrote ") << argv[0] << ".csv and " << argv[0] << ".ecl: "
+        << stats.events << " eclipses (" << stats.solar << " solar, " << stats.lunar << " lunar found in "
+        << stats.seconds << " s, " << found / stats.seconds << " events/s, " << pool.size() << " threads)" << std::endl;
+    if (stats.interrupted)
+        std::cout << "Run again with --resume to continue." << std::endl;
+    return 0;
+}
+
+static uint32_t gravityCenter(uint32_t index) {
+    return bodies.parent[index] >= 0 ? static_cast<uint32_t>(bodies.parent[index]) : sunId;
+}
+
+void startGravity() {
+    const double dt = simClock.time() - bodies.orbits.epoch;
+    std::vector<glm::dvec3> position(bodies.size()), velocity(bodies.size());
+
+    gravity.clear();
+    gravity.gravitationalConstant = GAUSS_K2;
+    for (uint32_t i = 0; i < bodies.size(); ++i) {
+        if (i != sunId) {
+            uint32_t center = gravityCenter(i);
+            position[i] = position[center] + keplerPosition(bodyPhysics[i].orbit, dt);
+            velocity[i] = velocity[center] + keplerVelocity(bodyPhysics[i].orbit, dt);
+        }
+        gravity.addBody(position[i], velocity[i], bodyPhysics[i].mass);
+    }
+    gravity.moveToBarycentricFrame();
+    applyGravity();
+}
+
+void applyGravity() {
+    // Integrated offsets replace the Kepler ones; the Sun sits at the origin,
+    // so top-level bodies can use their offset from it directly.
+    for (uint32_t i = 0; i < bodies.size(); ++i) {
+        if (i == sunId)
+            continue;
+        uint32_t center = gravityCenter(i);
+        glm::dvec3 offset = (gravity.position(i) - gravity.position(center)) * bodyPhysics[i].sceneScale;
+        bodies.setLocalPosition(i, glm::vec3(offset));
+    }
+    bodies.updateWorldPositions();
+}
+
+// Eclipses are found on the physical orbits, whose directions match the scene.
+EclipseModel eclipseModel() {
+    EclipseModel model;
+    model.epoch = bodies.orbits.epoch;
+    model.earthOrbit = bodyPhysics[earthId].orbit;
+    model.moonOrbit = bodyPhysics[moonId].orbit;
+    return model;
+}
+
+void startEclipseSearch(EclipseKind kind) {
+    // From an eclipse on display, look for the one after it.
+    double from = (isEclipse || isLunarEclipse) ? simClock.time() + 1.0 : simClock.time();
+
+    eclipseSearch.start(eclipseModel(), kind, from, ECLIPSE_SEARCH_DAYS);
+    std::cout << "Searching for the next " << (kind == EclipseKind::Solar ? "solar" : "lunar") << " eclipse after "
+        << formatJulianDate(from) << "..." << std::endl;
+}
+
+void showEclipse(const EclipseEvent& eclipse, double searchSeconds) {
+    const char* kind = eclipse.kind == EclipseKind::Solar ? "solar" : "lunar";
+    if (eclipse.type == EclipseType::None) {
+        std::cout << "No " << kind << " eclipse in the next " << ECLIPSE_SEARCH_DAYS / 365.25 << " years." << std::endl;
+        return;
+    }
+
+    const char* type = eclipse.type == EclipseType::Total ? "Total"
+        : eclipse.type == EclipseType::Annular ? "Annular" : "Partial";
+    seekTo(eclipse.maximum);
+    isEclipse = eclipse.kind == EclipseKind::Solar;
+    isLunarEclipse = eclipse.kind == EclipseKind::Lunar;
+    std::cout << type << " " << kind << " eclipse, greatest at " << formatJulianDate(eclipse.maximum)
+        << " (contacts " << formatJulianDate(eclipse.start) << " to " << formatJulianDate(eclipse.end) << ", "
+        << (eclipse.end - eclipse.start) * 1440.0 << " min), found in " << searchSeconds * 1e3 << " ms." << std::endl;
+    std::cout << "Time is held at greatest eclipse. Press J to resume." << std::endl;
+}
+
+void seekTo(double julianDate) {
+    simClock.seek(julianDate);
+    bodies.evaluate(julianDate);
+    // Integrated states cannot be jumped to; restart from the orbits at the new date.
+    if (gravityMode)
+        startGravity();
+    bodies.storePreviousState();
+    std::cout << "Date: " << formatJulianDate(julianDate) << std::endl;
 }
 
 void processInput(GLFWwindow* window) {
@@ -428,12 +938,7 @@ void processInput(GLFWwindow* window) {
     static bool gKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !gKeyPressed) {
         gKeyPressed = true;
-        if (!isEclipse && !isLunarEclipse) {
-            speedUpMode = true;
-            speedUpModeLunar = false;
-            timeSpeed = fastTimeSpeed;
-            std::cout << "Speed up mode activated! Searching for solar eclipse..." << std::endl;
-        }
+        startEclipseSearch(EclipseKind::Solar);
     }
     if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE) {
         gKeyPressed = false;
@@ -442,12 +947,7 @@ void processInput(GLFWwindow* window) {
     static bool hKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS && !hKeyPressed) {
         hKeyPressed = true;
-        if (!isLunarEclipse && !isEclipse) {
-            speedUpModeLunar = true;
-            speedUpMode = false;
-            timeSpeed = fastTimeSpeed;
-            std::cout << "Lunar speed up mode activated! Searching for lunar eclipse..." << std::endl;
-        }
+        startEclipseSearch(EclipseKind::Lunar);
     }
     if (glfwGetKey(window, GLFW_KEY_H) == GLFW_RELEASE) {
         hKeyPressed = false;
@@ -458,15 +958,9 @@ void processInput(GLFWwindow* window) {
         jKeyPressed = true;
         if (isEclipse) {
             isEclipse = false;
-            speedUpMode = false;
-            timeSpeed = normalTimeSpeed;
-            moonPosAdjusted = false;
             std::cout << "Solar eclipse ended. Normal movement resumed. Press G to search for eclipse again." << std::endl;
         } else if (isLunarEclipse) {
             isLunarEclipse = false;
-            speedUpModeLunar = false;
-            timeSpeed = normalTimeSpeed;
-            moonPosAdjusted = false;
             std::cout << "Lunar eclipse ended. Normal movement resumed. Press H to search for eclipse again." << std::endl;
         }
     }
@@ -488,16 +982,65 @@ void processInput(GLFWwindow* window) {
         vKeyPressed = false;
     }
 
+    static bool bracketKeyPressed = false;
+    bool backKey = glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+    bool forwardKey = glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+    if ((backKey || forwardKey) && !bracketKeyPressed) {
+        bracketKeyPressed = true;
+        seekTo(simClock.time() + (forwardKey ? 365.25 : -365.25));
+    }
+    if (!backKey && !forwardKey) {
+        bracketKeyPressed = false;
+    }
+
+    static bool nKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS && !nKeyPressed) {
+        nKeyPressed = true;
+        nbodyMode = !nbodyMode;
+        if (!nbodyMode)
+            std::cout << "N-body mode off." << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_RELEASE) {
+        nKeyPressed = false;
+    }
+
+    static bool kKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && !kKeyPressed) {
+        kKeyPressed = true;
+        gravityMode = !gravityMode;
+        if (gravityMode) {
+            startGravity();
+            std::cout << "Gravity mode: bodies are now integrated (" << simdLevelName(gravity.level()) << ")." << std::endl;
+        } else {
+            bodies.evaluate(simClock.time());
+            std::cout << "Gravity mode off: back to Kepler orbits." << std::endl;
+        }
+        bodies.storePreviousState();
+    }
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_RELEASE) {
+        kKeyPressed = false;
+    }
+
+    static bool cKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !cKeyPressed) {
+        cKeyPressed = true;
+        conjunctionWatch = !conjunctionWatch;
+        activeConjunctions.clear();
+        conjunctionTime = 0.0;
+        std::cout << "Conjunction watch " << (conjunctionWatch ? "on." : "off.") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        cKeyPressed = false;
+    }
+
     static bool rKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !rKeyPressed) {
         rKeyPressed = true;
+        eclipseSearch.cancel();
         isEclipse = false;
         isLunarEclipse = false;
-        speedUpMode = false;
-        speedUpModeLunar = false;
         timeSpeed = normalTimeSpeed;
         cameraFollowEarth = false;
-        moonPosAdjusted = false;
         std::cout << "Reset. Normal speed resumed." << std::endl;
     }
     if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE) {